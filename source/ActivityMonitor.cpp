@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "ActivityMonitor.h"
+#include "SDL.h"
+#include "RenderConfig.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+ActivityMonitor::ActivityMonitor()
+{
+	m_SecondsPerCount = 1.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	m_CoreCount = std::max(SDL_GetCPUCount(), 1);
+	m_LastCounter = SDL_GetPerformanceCounter();
+	m_LastCPUSeconds = GetProcessCPUSeconds();
+}
+
+void ActivityMonitor::Update()
+{
+	const uint64_t counter = SDL_GetPerformanceCounter();
+	const double wallSeconds = (counter - m_LastCounter) * m_SecondsPerCount;
+
+	if (wallSeconds < 1.0)
+	{
+		return;
+	}
+
+	const double cpuSeconds = GetProcessCPUSeconds();
+	m_CPUUsage = static_cast<float>(100.0 * (cpuSeconds - m_LastCPUSeconds) / (wallSeconds * m_CoreCount));
+
+	if (RENDER_CONFIG->ShouldPrintFPS())
+	{
+		std::cout << "\033[33m"; // TEXT COLOR
+		std::cout << "[Activity] CPU usage: " << m_CPUUsage << "% of " << m_CoreCount << " cores"
+			<< ", wakeups: " << m_Wakeups / wallSeconds << "/s"
+			<< ", rendered: " << m_RenderedFrames / wallSeconds << "/s"
+			<< ", skipped: " << m_SkippedFrames / wallSeconds << "/s" << std::endl;
+		std::cout << "\033[37m"; // TEXT COLOR WHITE
+	}
+
+	m_LastCounter = counter;
+	m_LastCPUSeconds = cpuSeconds;
+	m_Wakeups = 0;
+	m_RenderedFrames = 0;
+	m_SkippedFrames = 0;
+}
+
+double ActivityMonitor::GetProcessCPUSeconds()
+{
+#if defined(_WIN32)
+	FILETIME creationTime{}, exitTime{}, kernelTime{}, userTime{};
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return 0.0;
+	}
+
+	// 100 ns ticks
+	const auto toTicks = [](const FILETIME& time)
+		{
+			return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+		};
+
+	return (toTicks(kernelTime) + toTicks(userTime)) * 1e-7;
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
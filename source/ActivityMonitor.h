@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+/**
+	* Counts main loop wakeups and rendered/skipped frames and samples the
+	* CPU time of the whole process (all threads), so the cost of idling
+	* in on-demand rendering can be compared against continuous rendering.
+	*/
+class ActivityMonitor
+{
+public:
+	ActivityMonitor();
+
+	void AddWakeup() { ++m_Wakeups; };
+	void AddRenderedFrame() { ++m_RenderedFrames; };
+	void AddSkippedFrame() { ++m_SkippedFrames; };
+
+	// Reports once per second of wall time, the main loop timer stops while idling
+	void Update();
+
+	float GetCPUUsage() const { return m_CPUUsage; };
+
+private:
+	uint64_t m_LastCounter{};
+	double m_LastCPUSeconds{};
+	double m_SecondsPerCount{};
+	int m_CoreCount{ 1 };
+
+	uint32_t m_Wakeups{};
+	uint32_t m_RenderedFrames{};
+	uint32_t m_SkippedFrames{};
+
+	// Percentage of all cores
+	float m_CPUUsage{};
+
+	static double GetProcessCPUSeconds();
+};
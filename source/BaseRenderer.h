@@ -21,6 +21,9 @@ public:
 	virtual void Update(Timer* pTimer) {};
 	virtual void Render();
 
+	// Pipelined renderers can hold frames that were rendered but not presented yet
+	virtual bool HasPendingFrames() const { return false; };
+
 protected:
 	SDL_Window* m_pWindow{};
 
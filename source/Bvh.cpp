@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "Bvh.h"
+#include "JobSystem.h"
+
+void Bvh::Bounds::Grow(const Vector3& point)
+{
+	min = Vector3{ std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z) };
+	max = Vector3{ std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z) };
+}
+
+void Bvh::Bounds::Grow(const Bounds& bounds)
+{
+	// Empty bins would stretch the bounds to infinity
+	if (bounds.min.x > bounds.max.x)
+	{
+		return;
+	}
+
+	Grow(bounds.min);
+	Grow(bounds.max);
+}
+
+float Bvh::Bounds::GetHalfArea() const
+{
+	const Vector3 extent = max - min;
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+void Bvh::Build(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices)
+{
+	const int triangleCount = static_cast<int>(indices.size() / 3);
+
+	m_TriangleBounds.resize(triangleCount);
+	m_Centroids.resize(triangleCount);
+	m_Order.resize(triangleCount);
+
+	JOB_SYSTEM->ParallelFor(0, triangleCount, [&](int triangle)
+		{
+			Bounds bounds{};
+			bounds.Grow(positions[indices[triangle * 3]]);
+			bounds.Grow(positions[indices[triangle * 3 + 1]]);
+			bounds.Grow(positions[indices[triangle * 3 + 2]]);
+
+			m_TriangleBounds[triangle] = bounds;
+			m_Centroids[triangle] = (bounds.min + bounds.max) * 0.5f;
+			m_Order[triangle] = triangle;
+		});
+
+	// A binary tree with a triangle or more per leaf never needs more nodes than this
+	m_Nodes.assign(std::max(2 * triangleCount - 1, 1), BvhNode{});
+	m_NodeCount.store(1, std::memory_order_relaxed);
+
+	if (triangleCount > 0)
+	{
+		BuildNode(0, 0, triangleCount, 0);
+	}
+
+	// The leaves index into the final order
+	m_Triangles.resize(triangleCount);
+	JOB_SYSTEM->ParallelFor(0, triangleCount, [&](int index)
+		{
+			const int32_t primitive = m_Order[index];
+			const Vector3& vertex0 = positions[indices[primitive * 3]];
+			const Vector3& vertex1 = positions[indices[primitive * 3 + 1]];
+			const Vector3& vertex2 = positions[indices[primitive * 3 + 2]];
+
+			m_Triangles[index] = BvhTriangle{ vertex0, vertex1 - vertex0, vertex2 - vertex0, primitive };
+		});
+
+	m_TriangleBounds = {};
+	m_Centroids = {};
+	m_Order = {};
+}
+
+void Bvh::BuildNode(int nodeIndex, int first, int count, int depth)
+{
+	Bounds bounds{};
+	Bounds centroidBounds{};
+	for (int index{ first }; index < first + count; ++index)
+	{
+		bounds.Grow(m_TriangleBounds[m_Order[index]]);
+		centroidBounds.Grow(m_Centroids[m_Order[index]]);
+	}
+
+	// Deep nodes only split at the median, which halves the count every level and keeps the
+	// traversal stack of TraceRays within MaxDepth even for 2^32 triangles
+	const bool isTooDeep = depth >= MaxDepth - 32;
+
+	int axis{};
+	int splitBin{};
+	const bool hasSplit = !isTooDeep && FindSplit(bounds, centroidBounds, first, count, axis, splitBin);
+
+	BvhNode& node = m_Nodes[nodeIndex];
+	if (!hasSplit && count <= MaxLeafSize)
+	{
+		MakeLeaf(node, bounds, first, count);
+		return;
+	}
+
+	int32_t* pFirst = m_Order.data() + first;
+	int32_t* pMiddle = pFirst;
+
+	if (hasSplit)
+	{
+		const float centroidMin = centroidBounds.min[axis];
+		const float binScale = BinCount / (centroidBounds.max[axis] - centroidBounds.min[axis]);
+
+		pMiddle = std::partition(pFirst, pFirst + count, [&](int32_t triangle)
+			{
+				return std::min(static_cast<int>((m_Centroids[triangle][axis] - centroidMin) * binScale), BinCount - 1) < splitBin;
+			});
+	}
+
+	// Without a split, half of the triangles go each way along the longest side of the centroids.
+	// Identical centroids can not be binned apart either, so they end up here too
+	if (pMiddle == pFirst || pMiddle == pFirst + count)
+	{
+		const Vector3 centroidExtent = centroidBounds.max - centroidBounds.min;
+		axis = centroidExtent.x >= centroidExtent.y && centroidExtent.x >= centroidExtent.z ? 0 : (centroidExtent.y >= centroidExtent.z ? 1 : 2);
+
+		pMiddle = pFirst + count / 2;
+		std::nth_element(pFirst, pMiddle, pFirst + count, [&](int32_t left, int32_t right)
+			{
+				return m_Centroids[left][axis] < m_Centroids[right][axis];
+			});
+	}
+
+	const int leftCount = static_cast<int>(pMiddle - pFirst);
+	const int leftChild = m_NodeCount.fetch_add(2, std::memory_order_relaxed);
+
+	node.leftFirst = leftChild;
+	node.count = 0;
+	node.axis = static_cast<int16_t>(axis);
+	for (int component{}; component < 3; ++component)
+	{
+		node.boundsMin[component] = bounds.min[component];
+		node.boundsMax[component] = bounds.max[component];
+	}
+
+	if (count > ParallelThreshold)
+	{
+		JOB_SYSTEM->ParallelInvoke(
+			[&]() { BuildNode(leftChild, first, leftCount, depth + 1); },
+			[&]() { BuildNode(leftChild + 1, first + leftCount, count - leftCount, depth + 1); });
+	}
+	else
+	{
+		BuildNode(leftChild, first, leftCount, depth + 1);
+		BuildNode(leftChild + 1, first + leftCount, count - leftCount, depth + 1);
+	}
+}
+
+bool Bvh::FindSplit(const Bounds& bounds, const Bounds& centroidBounds, int first, int count, int& axis, int& splitBin) const
+{
+	// Relative to the cost of a triangle test, the halved areas cancel out
+	constexpr float traversalCost{ 1.f };
+	float bestCost{ FLT_MAX };
+
+	for (int binAxis{}; binAxis < 3; ++binAxis)
+	{
+		const float centroidMin = centroidBounds.min[binAxis];
+		const float extent = centroidBounds.max[binAxis] - centroidMin;
+		if (extent <= 0.f)
+		{
+			continue;
+		}
+
+		Bounds binBounds[BinCount]{};
+		int binCounts[BinCount]{};
+		const float binScale = BinCount / extent;
+
+		for (int index{ first }; index < first + count; ++index)
+		{
+			const int32_t triangle = m_Order[index];
+			const int bin = std::min(static_cast<int>((m_Centroids[triangle][binAxis] - centroidMin) * binScale), BinCount - 1);
+
+			binBounds[bin].Grow(m_TriangleBounds[triangle]);
+			++binCounts[bin];
+		}
+
+		// Sweep from the right, then from the left, split s puts the bins below s on the left
+		float rightCosts[BinCount]{};
+		Bounds rightBounds{};
+		int rightCount{};
+		for (int bin{ BinCount - 1 }; bin > 0; --bin)
+		{
+			rightBounds.Grow(binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightCosts[bin] = rightCount > 0 ? rightBounds.GetHalfArea() * rightCount : 0.f;
+		}
+
+		Bounds leftBounds{};
+		int leftCount{};
+		for (int bin{ 1 }; bin < BinCount; ++bin)
+		{
+			leftBounds.Grow(binBounds[bin - 1]);
+			leftCount += binCounts[bin - 1];
+
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+
+			const float cost = leftBounds.GetHalfArea() * leftCount + rightCosts[bin];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				axis = binAxis;
+				splitBin = bin;
+			}
+		}
+	}
+
+	if (bestCost == FLT_MAX)
+	{
+		return false;
+	}
+
+	// Small nodes only split when that is cheaper than testing all of their triangles
+	const float leafCost = static_cast<float>(count);
+	const float splitCost = traversalCost + bestCost / bounds.GetHalfArea();
+
+	return count > MaxLeafSize || splitCost < leafCost;
+}
+
+void Bvh::MakeLeaf(BvhNode& node, const Bounds& bounds, int first, int count) const
+{
+	node.leftFirst = first;
+	node.count = static_cast<int16_t>(count);
+	node.axis = 0;
+	for (int component{}; component < 3; ++component)
+	{
+		node.boundsMin[component] = bounds.min[component];
+		node.boundsMax[component] = bounds.max[component];
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cfloat>
+#include "Math.h"
+
+// 32 bytes, two per cache line. Children of an interior node are stored next to each other
+struct BvhNode
+{
+	float boundsMin[3]{};
+	// First child of an interior node, first triangle of a leaf
+	int32_t leftFirst{};
+	float boundsMax[3]{};
+	// Triangles of a leaf, 0 for interior nodes
+	int16_t count{};
+	// Split axis of an interior node, the traversal visits the child on the side the rays come from first
+	int16_t axis{};
+};
+
+// Prepared for the Moller-Trumbore test, in the order of the leaves
+struct BvhTriangle
+{
+	Vector3 vertex0{};
+	Vector3 edge1{};
+	Vector3 edge2{};
+	// Index of the triangle in the index buffer it was built from
+	int32_t primitive{};
+};
+
+/**
+	* Bounding volume hierarchy over the triangles of a mesh, for the ray tracing
+	* backend. Built top down with the surface area heuristic evaluated on BinCount
+	* bins per axis (Wald 2007) instead of every split position. Subtrees above
+	* ParallelThreshold triangles get built on the JobSystem in parallel. The triangles
+	* stay in the space they were given in, rays get transformed into it instead,
+	* so a mesh that only moves never needs a rebuild.
+	*/
+class Bvh
+{
+public:
+	static constexpr int BinCount{ 16 };
+	static constexpr int MaxLeafSize{ 4 };
+	// Levels of the tree and entries of the traversal stack, the build falls back to median splits before reaching it
+	static constexpr int MaxDepth{ 64 };
+
+	// Triangle list, three indices per triangle
+	void Build(const std::vector<Vector3>& positions, const std::vector<uint32_t>& indices);
+
+	const BvhNode* GetNodes() const { return m_Nodes.data(); };
+	const BvhTriangle* GetTriangles() const { return m_Triangles.data(); };
+	int GetNodeCount() const { return m_NodeCount.load(std::memory_order_relaxed); };
+	int GetTriangleCount() const { return static_cast<int>(m_Triangles.size()); };
+
+private:
+	static constexpr int ParallelThreshold{ 4096 };
+
+	struct Bounds
+	{
+		Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		void Grow(const Vector3& point);
+		void Grow(const Bounds& bounds);
+		float GetHalfArea() const;
+	};
+
+	std::vector<BvhNode> m_Nodes{};
+	std::vector<BvhTriangle> m_Triangles{};
+	std::atomic<int> m_NodeCount{};
+
+	// Per triangle of the input, only needed while building
+	std::vector<Bounds> m_TriangleBounds{};
+	std::vector<Vector3> m_Centroids{};
+	std::vector<int32_t> m_Order{};
+
+	void BuildNode(int nodeIndex, int first, int count, int depth);
+	// Split position as bin index on axis, false when a leaf is cheaper
+	bool FindSplit(const Bounds& bounds, const Bounds& centroidBounds, int first, int count, int& axis, int& splitBin) const;
+	void MakeLeaf(BvhNode& node, const Bounds& bounds, int first, int count) const;
+};
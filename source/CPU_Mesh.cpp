@@ -5,3 +5,41 @@ CPU_Mesh::CPU_Mesh(MeshData* meshData, PrimitiveTopology topology)
 	:m_pMeshData{ meshData }, m_PrimitiveTopology{topology}
 {
 }
+
+void CPU_Mesh::UpdateWorldSpaceVertices()
+{
+	const Matrix& worldMatrix = m_pMeshData->worldMatrix;
+
+	if (m_IsWorldCacheValid && worldMatrix == m_CachedWorldMatrix && m_WorldPositions.size() == m_pMeshData->vertices.size())
+	{
+		return;
+	}
+
+	const std::vector<Vertex>& vertices = m_pMeshData->vertices;
+	m_WorldPositions.resize(vertices.size());
+	m_WorldNormals.resize(vertices.size());
+	// Baked object space normal maps leave the tangents unused
+	const bool useTangents = !m_pMeshData->isNormalMapObjectSpace;
+	m_WorldTangents.resize(useTangents ? vertices.size() : 0);
+
+	// Vertices are interleaved, the batched transforms work in place on the object space copies
+	for (size_t index{}; index < vertices.size(); ++index)
+	{
+		const Vertex& vertex = vertices[index];
+
+		m_WorldPositions[index] = vertex.position;
+		m_WorldNormals[index] = vertex.normal;
+	}
+
+	for (size_t index{}; index < m_WorldTangents.size(); ++index)
+	{
+		m_WorldTangents[index] = vertices[index].tangent;
+	}
+
+	worldMatrix.TransformPoints(m_WorldPositions, m_WorldPositions);
+	worldMatrix.TransformVectorsAndNormalize(m_WorldNormals, m_WorldNormals);
+	worldMatrix.TransformVectorsAndNormalize(m_WorldTangents, m_WorldTangents);
+
+	m_CachedWorldMatrix = worldMatrix;
+	m_IsWorldCacheValid = true;
+}
@@ -12,12 +12,32 @@ public:
 	CPU_Mesh& operator=(CPU_Mesh&&) noexcept = delete;
 
 	MeshData* GetMeshData() { return m_pMeshData;  };
-	std::vector<Vertex_Out>& GetVerticesOut() { return m_pVerticesOut; };
+	// Every frame in flight of the pipelined CPU renderer writes its own output slot
+	static constexpr int MaxOutputSlots{ 3 };
+
+	std::vector<Vector4>& GetPositionsOut(int slot) { return m_PositionsOut[slot]; };
+	std::vector<float>& GetVaryingsOut(int slot) { return m_VaryingsOut[slot]; };
 	PrimitiveTopology GetPrimitiveTopology() { return m_PrimitiveTopology; };
 
+	// Recomputes the world space vertex data only when the world matrix changed since the last call
+	void UpdateWorldSpaceVertices();
+	const std::vector<Vector3>& GetWorldPositions() const { return m_WorldPositions; };
+	const std::vector<Vector3>& GetWorldNormals() const { return m_WorldNormals; };
+	const std::vector<Vector3>& GetWorldTangents() const { return m_WorldTangents; };
+
 private:
 	MeshData* m_pMeshData{};
-	std::vector<Vertex_Out> m_pVerticesOut{};
+
+	// World space vertex data, valid for m_CachedWorldMatrix
+	std::vector<Vector3> m_WorldPositions{};
+	std::vector<Vector3> m_WorldNormals{};
+	std::vector<Vector3> m_WorldTangents{};
+	Matrix m_CachedWorldMatrix{};
+	bool m_IsWorldCacheValid{ false };
+
+	// Vertex stage output: raster positions plus the varyings of the active layout, interleaved per vertex
+	std::vector<Vector4> m_PositionsOut[MaxOutputSlots]{};
+	std::vector<float> m_VaryingsOut[MaxOutputSlots]{};
 	PrimitiveTopology m_PrimitiveTopology{ PrimitiveTopology::TriangleStrip };
 };
 
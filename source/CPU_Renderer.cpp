@@ -1,4 +1,15 @@
 #include "pch.h"
+
+// The depth prepass leaves only fragments of exactly the depth it stored, DepthRasterizer::InterpolateDepth has to round
+// like the depth kernels do. A multiply-add contracted here but not there (or the other way around) breaks that
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
 #include "CPU_Renderer.h"
 #include "SDL.h"
 #include "SDL_surface.h"
@@ -8,38 +19,195 @@
 #include "Camera.h"
 #include "Shading.h"
 #include "Mesh.h"
-#include <ppl.h>
+#include "JobSystem.h"
+#include <xmmintrin.h>
 #include "RenderConfig.h"
 #include "Utils.h"
+#include "ShadingRateImage.h"
+#include "SpatialUpscaler.h"
+#include "PostProcessor.h"
+#include "DirtyTileMap.h"
+#include "TransparencyBuffer.h"
+#include "DepthRasterizer.h"
+#include "ShadowMap.h"
+#include "FrameWorker.h"
+#include "SimdDispatch.h"
+#include "FastMath.h"
+#include "LightGrid.h"
+#include "Bvh.h"
+#include "RayTracedVisibility.h"
+#include <array>
+#include <random>
+
+// EdgeFunction for 4 points at once
+inline __m128 EdgeFunction4(const Vector4& a, const Vector4& b, __m128 pointX, __m128 pointY)
+{
+	const __m128 sideX = _mm_set1_ps(b.x - a.x);
+	const __m128 sideY = _mm_set1_ps(b.y - a.y);
+	const __m128 toPointX = _mm_sub_ps(pointX, _mm_set1_ps(a.x));
+	const __m128 toPointY = _mm_sub_ps(pointY, _mm_set1_ps(a.y));
+
+	return _mm_sub_ps(_mm_mul_ps(sideX, toPointY), _mm_mul_ps(sideY, toPointX));
+}
 
-inline float EdgeFunction(const Vector2& a, const Vector2& b, const Vector2& c)
+namespace
 {
-	// point to side => c - a
-	// side to end => b - a
-	return Vector2::Cross(b - a, c - a);
+	// Scattered through the bounding sphere of the mesh, the same seed gives the same lights every time.
+	// The radius shrinks with the count, so more lights means more but smaller pools of light
+	std::vector<PointLight> ScatterPointLights(const MeshData& mesh, int count)
+	{
+		const Vector3 center = mesh.transformMatrix[3].GetXYZ();
+
+		float meshRadius{};
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			meshRadius = std::max(meshRadius, mesh.scaleMatrix.TransformVector(vertex.position).Magnitude());
+		}
+
+		std::mt19937 generator{ 7 };
+		std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+
+		const float lightRadius = meshRadius * 0.35f * std::cbrt(16.f / count);
+		const float intensity = 3.f;
+
+		std::vector<PointLight> lights(count);
+		for (PointLight& light : lights)
+		{
+			light.position = center + Vector3{ unit(generator), unit(generator), unit(generator) } * meshRadius;
+			light.radius = lightRadius;
+
+			// Saturated colors, the brightest channel at full intensity
+			ColorRGB color{ unit(generator) * 0.5f + 0.5f, unit(generator) * 0.5f + 0.5f, unit(generator) * 0.5f + 0.5f };
+			const float brightest = std::max({ color.r, color.g, color.b, 0.01f });
+			light.color = color * (intensity / brightest);
+		}
+
+		return lights;
+	}
+
+	// Fragments of one tile waiting for ShadePbrBatch, with the pixels each of them covers
+	struct PbrQueue
+	{
+		// A shading block covers up to 4x4 pixels
+		static constexpr int MaxPixels{ 16 };
+
+		PbrBatch batch{};
+		int pixelIndices[PbrBatch::Size][MaxPixels]{};
+		int pixelCounts[PbrBatch::Size]{};
+	};
+
+	// A tile is rendered start to end by one thread, so every worker keeps its own queue
+	thread_local PbrQueue t_PbrQueue{};
 }
 
-CPU_Renderer::CPU_Renderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes)
+CPU_Renderer::CPU_Renderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes, const IrradianceSH& skyIrradiance)
 	: BaseRenderer(pWindow, pCamera)
+	, m_SkyIrradiance{ skyIrradiance }
 {
 	m_RendererColor = ColorRGB{ 0.39f * 255.f, 0.39f * 255.f, 0.39f * 255 };
 	m_UniformColor = ColorRGB{ 0.1f * 255.f, 0.1f * 255.f, 0.1f * 255 };
 	m_CurrentColor = m_RendererColor;
 
 	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+	SDL_GetWindowSize(pWindow, &m_WindowWidth, &m_WindowHeight);
+
+	// The thruster is transparent, only the vehicle casts traced shadows. Built once in object space, the rays
+	// get transformed into it, so the rotation never needs a rebuild
+	const MeshData& mesh = *pMeshes[0];
+	std::vector<Vector3> positions(mesh.vertices.size());
+	for (size_t index{}; index < mesh.vertices.size(); ++index)
+	{
+		positions[index] = mesh.vertices[index].position;
+	}
+
+	m_pBvh = new Bvh();
+	m_pBvh->Build(positions, mesh.indices);
 
 	//Create Buffers
 	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+	CreateRenderTargets();
+
+	m_pUpscaler = new SpatialUpscaler();
+	m_pRasterWorker = new FrameWorker();
+
+	CreateMeshes(pMeshes);
+}
+
+void CPU_Renderer::CreateRenderTargets()
+{
+	DestroyRenderTargets();
 
-	// Texture maps
+	// Internal resolution, the upscaler brings it back to window size
+	m_RenderScale = RENDER_CONFIG->GetRenderScale();
+	m_Width = std::max(1, static_cast<int>(m_WindowWidth * m_RenderScale));
+	m_Height = std::max(1, static_cast<int>(m_WindowHeight * m_RenderScale));
 
-	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+	m_TiledLayout = TiledLayout{ m_Width, m_Height };
+	m_pColorBufferPixels = new uint32_t[m_TiledLayout.GetPixelCount()];
+	m_pDepthBufferPixels = new float[m_TiledLayout.GetPixelCount()];
 
-	m_pDepthBufferPixels = new float[m_Width * m_Height];
+	m_pShadingRateImage = new ShadingRateImage(m_Width, m_Height);
 
-	CreateMeshes(pMeshes);
+	m_pPostProcessor = new PostProcessor(m_Width, m_Height);
+
+	m_pTransparencyBuffer = new TransparencyBuffer(m_Width, m_Height);
+
+	m_pDepthRasterizer = new DepthRasterizer(m_Width, m_Height);
+
+	m_pLightGrid = new LightGrid(m_Width, m_Height);
+
+	m_pTracedVisibility = new RayTracedVisibility(*m_pBvh, m_TiledLayout);
+
+	BuildFrameGraph();
+
+	// Every frame in flight gets its own back buffer and dirty tiles, new targets hold nothing to reuse
+	m_Frames.resize(std::clamp(RENDER_CONFIG->GetPipelineDepth(), 1, CPU_Mesh::MaxOutputSlots));
+
+	for (int slot{}; slot < static_cast<int>(m_Frames.size()); ++slot)
+	{
+		FrameContext& frame = m_Frames[slot];
+		frame.slot = slot;
+		frame.pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+		frame.pDirtyTiles = new DirtyTileMap(m_Width, m_Height);
+	}
+
+	m_HasPreviousFrame = false;
+}
+
+void CPU_Renderer::DestroyRenderTargets()
+{
+	for (FrameContext& frame : m_Frames)
+	{
+		SDL_FreeSurface(frame.pBackBuffer);
+		delete frame.pDirtyTiles;
+		delete frame.pShadowMap;
+	}
+
+	m_Frames.clear();
+
+	delete[] m_pColorBufferPixels;
+	m_pColorBufferPixels = nullptr;
+
+	delete[] m_pDepthBufferPixels;
+	m_pDepthBufferPixels = nullptr;
+
+	delete m_pShadingRateImage;
+	m_pShadingRateImage = nullptr;
+
+	delete m_pPostProcessor;
+	m_pPostProcessor = nullptr;
+
+	delete m_pTransparencyBuffer;
+	m_pTransparencyBuffer = nullptr;
+
+	delete m_pDepthRasterizer;
+	m_pDepthRasterizer = nullptr;
+
+	delete m_pLightGrid;
+	m_pLightGrid = nullptr;
+
+	delete m_pTracedVisibility;
+	m_pTracedVisibility = nullptr;
 }
 
 
@@ -55,16 +223,36 @@ void CPU_Renderer::CreateMeshes(std::vector<MeshData*>& pMeshes)
 
 CPU_Renderer::~CPU_Renderer()
 {
+	// Frames in flight still reference the meshes and targets
+	delete m_pRasterWorker;
+
 	for (auto* mesh : m_pMeshes)
 	{
 		delete mesh;
 	}
 
-	delete[] m_pDepthBufferPixels;
+	DestroyRenderTargets();
+	delete m_pUpscaler;
+	delete m_pBvh;
 }
 
 void CPU_Renderer::Update(Timer* pTimer)
 {
+	if (m_Profiler.Update(pTimer->GetElapsed()))
+	{
+		const float shadowMapMilliseconds = m_Profiler.GetAverage("Shadow Map");
+		const bool isOverBudget = shadowMapMilliseconds > ShadowMap::BudgetMilliseconds;
+
+		if (isOverBudget && !m_IsShadowMapOverBudget)
+		{
+			std::cout << "\033[33m"; // TEXT COLOR
+			std::cout << "[CPU] Shadow map over budget: " << shadowMapMilliseconds << " ms, budget " << ShadowMap::BudgetMilliseconds << " ms" << std::endl;
+			std::cout << "\033[37m"; // TEXT COLOR WHITE
+		}
+
+		m_IsShadowMapOverBudget = isOverBudget;
+	}
+
 	if (RENDER_CONFIG->ShouldRotate())
 	{
 		for (CPU_Mesh* CPUMesh : m_pMeshes)
@@ -83,411 +271,1637 @@ void CPU_Renderer::Render()
 	// call to base render function for uniform color changes
 	BaseRenderer::Render();
 
-	//@START
-	//Lock BackBuffer
-	SDL_LockSurface(m_pBackBuffer);
-
-	RenderFrame();
+	const int pipelineDepth = std::clamp(RENDER_CONFIG->GetPipelineDepth(), 1, CPU_Mesh::MaxOutputSlots);
 
+	if (RENDER_CONFIG->GetRenderScale() != m_RenderScale || pipelineDepth != static_cast<int>(m_Frames.size()))
+	{
+		// Frames in flight still use the old targets, they never get presented
+		m_pRasterWorker->WaitUntilIdle();
+		CreateRenderTargets();
+	}
 
+	// The context is free again once the frame that used it last left the raster worker
+	FrameContext& frame = m_Frames[m_FrameCount % m_Frames.size()];
+	m_pRasterWorker->Wait(frame.rasterTicket);
 
-	//@END
-	//Update SDL Surface
-	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
-}
+	{
+		StageProfiler::ScopedStage stage{ m_Profiler, "Record" };
+		RecordFrame(frame);
+	}
 
-void CPU_Renderer::RenderFrame()
-{
-	// Transform from World -> View -> Projected -> Raster
-	VertexTransformationFunction();
+	frame.frameIndex = m_FrameCount++;
+	frame.isPresented = false;
+	frame.rasterTicket = m_pRasterWorker->Submit([this, &frame]()
+		{
+			RasterFrame(frame);
+		}
+	);
 
-	// Make float array size of image that will act as depth buffer
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+	// Bounded latency, at most pipelineDepth - 1 frames stay in flight behind the presented one
+	m_pRasterWorker->Wait(m_Frames[m_FrameCount % m_Frames.size()].rasterTicket);
 
-	// Clear back buffer
+	PresentNewestFrame();
+}
 
-	SDL_FillRect(m_pBackBuffer, &m_pBackBuffer->clip_rect, SDL_MapRGB(m_pBackBuffer->format, m_CurrentColor.r, m_CurrentColor.g, m_CurrentColor.b));
+bool CPU_Renderer::HasPendingFrames() const
+{
+	// Reused frames show what is already on screen, the traced occlusion keeps refining a still image
+	return m_IsRefiningTrace || std::any_of(m_Frames.begin(), m_Frames.end(), [](const FrameContext& frame)
+		{
+			return !frame.isPresented && !frame.isReused;
+		}
+	);
+}
 
+void CPU_Renderer::RecordFrame(FrameContext& frame)
+{
 	// Update current rendering mesh
 	auto mesh = m_pMeshes[0];
 	m_pCurrentMeshData = mesh->GetMeshData();
 
-	if (mesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleList)
-	{
-		const uint32_t amountOfTriangles = ((uint32_t)m_pCurrentMeshData->indices.size()) / 3;
+	// Debug visualizations write straight to the back buffer, so they skip the HDR post chain
+	frame.isHDR = RENDER_CONFIG->ShouldUseHDR() && !RENDER_CONFIG->ShouldRenderDepthBuffer() && !RENDER_CONFIG->ShouldRenderBoundingBox();
 
-		concurrency::parallel_for(0u, amountOfTriangles, [=, this](int index)
-			{
-				const Vertex_Out vertex1 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[3 * index]];
-				const Vertex_Out vertex2 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[3 * index + 1]];
-				const Vertex_Out vertex3 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[3 * index + 2]];
-
-				// cull triangles
-				if (vertex1.position.x < 0 || vertex2.position.x < 0 || vertex3.position.x < 0
-					|| vertex1.position.x > m_Width || vertex2.position.x > m_Width || vertex3.position.x > m_Width
-					|| vertex1.position.y < 0 || vertex2.position.y < 0 || vertex3.position.y < 0
-					|| vertex1.position.y > m_Height || vertex2.position.y > m_Height || vertex3.position.y > m_Height
-					)
-				{
-					return;
-				}
+	frame.pTransparentMesh = GetTransparentMesh();
 
-				RenderTriangle(vertex1, vertex2, vertex3);
-			}
-		);
+	// Camera or config changes touch every pixel, a moved mesh only the area it covered and covers now
+	frame.state = CaptureFrameState();
+	frame.pDirtyTiles->Reset();
+
+	// Debug visualizations are unlit, the traced rays start from the depth prepass which needs a triangle list
+	const bool isDebugView = RENDER_CONFIG->ShouldRenderDepthBuffer() || RENDER_CONFIG->ShouldRenderBoundingBox();
+	const bool canTrace = !isDebugView && mesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleList;
+	frame.isShadowRayTraced = canTrace && frame.state.shouldRayTraceShadows;
+	frame.ambientOcclusionSampleCount = canTrace ? frame.state.ambientOcclusionSampleCount : 0;
+
+	// Resolve visibility with the depth-only kernel first, the main pass then only shades the front-most fragments
+	// The traced rays start from its depth, so tracing always needs it
+	const bool isTraced = frame.isShadowRayTraced || frame.ambientOcclusionSampleCount > 0;
+	frame.isDepthPrepassed = (RENDER_CONFIG->ShouldUseDepthPrepass() || isTraced) && !frame.state.shouldRenderBoundingBox
+		&& mesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleList;
+
+	// A still scene keeps its traced result, the occlusion gets more rays every frame until it converged
+	const int tracedFrameIndex = CanReuseTracedVisibility(frame.state) ? m_TracedFrameCount : 0;
+	const bool isRefiningTrace = frame.ambientOcclusionSampleCount > 0 && tracedFrameIndex < RayTracedVisibility::MaxAccumulatedFrames;
+
+	if (!m_HasPreviousFrame || HasViewChanged(frame.state))
+	{
+		frame.pDirtyTiles->MarkAll();
 	}
-	else if (mesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleStrip)
+	else if (frame.state.worldMatrix == m_PreviousFrameState.worldMatrix && frame.state.transparentWorldMatrix == m_PreviousFrameState.transparentWorldMatrix
+		&& !isRefiningTrace)
 	{
-		for (uint32_t indice{}; indice < m_pCurrentMeshData->indices.size() - 2; indice++)
-		{
-			const Vertex_Out vertex1 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[indice]];
-			Vertex_Out vertex2{};
-			Vertex_Out vertex3{};
+		frame.isReused = true;
+		m_IsRefiningTrace = false;
+		return;
+	}
 
-			if (indice & 1)
-			{
-				vertex2 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[indice + 2]];
-				vertex3 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[indice + 1]];
-			}
-			else
-			{
-				vertex2 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[indice + 1]];
-				vertex3 = mesh->GetVerticesOut()[m_pCurrentMeshData->indices[indice + 2]];
-			}
+	frame.isReused = false;
+	frame.tracedFrameIndex = tracedFrameIndex;
+	m_TracedFrameCount = tracedFrameIndex + 1;
+	m_IsRefiningTrace = frame.ambientOcclusionSampleCount > 0 && m_TracedFrameCount < RayTracedVisibility::MaxAccumulatedFrames;
 
-			if (vertex1.position.x < 0 || vertex2.position.x < 0 || vertex3.position.x < 0
-				|| vertex1.position.x > m_Width || vertex2.position.x > m_Width || vertex3.position.x > m_Width
-				|| vertex1.position.y < 0 || vertex2.position.y < 0 || vertex3.position.y < 0
-				|| vertex1.position.y > m_Height || vertex2.position.y > m_Height || vertex3.position.y > m_Height
-				)
-			{
-				return;
-			}
+	frame.isShadowed = RENDER_CONFIG->ShouldRenderShadows() && !frame.isShadowRayTraced && !isDebugView;
+	frame.isFastMath = RENDER_CONFIG->GetCurrentMathQuality() == RenderConfig::MATH_QUALITY::APPROXIMATE;
 
-			RenderTriangle(vertex1, vertex2, vertex3);
-		}
+	frame.isNormalMapObjectSpace = m_pCurrentMeshData->isNormalMapObjectSpace;
+	frame.cameraOrigin = m_pCamera->origin;
+
+	// Observed area only shows the directional light
+	const bool isLit = !RENDER_CONFIG->ShouldRenderDepthBuffer() && !RENDER_CONFIG->ShouldRenderBoundingBox()
+		&& RENDER_CONFIG->GetCurrentShadingMode() != RenderConfig::SHADING_MODE::OBSERVED_AREA;
+	frame.pointLightCount = isLit ? RENDER_CONFIG->GetPointLightCount() : 0;
+
+	// The PBR kernel only knows the directional light and the sky
+	frame.isPbr = isLit && RENDER_CONFIG->GetCurrentShadingMode() == RenderConfig::SHADING_MODE::PBR;
+	if (frame.isPbr)
+	{
+		frame.pointLightCount = 0;
+
+		frame.pbrMaterial.lightDirection = -Shading::LightDirection;
+		frame.pbrMaterial.lightRadiance = ColorRGB{ 1,1,1 } * Shading::LightIntensity;
+		// Glossiness 1 matches the width of the Phong lobe of the combined mode
+		frame.pbrMaterial.roughnessScale = -0.75f;
+		frame.pbrMaterial.roughnessBias = 1.f;
+		frame.pbrMaterial.skyIrradiance = m_SkyIrradiance;
+		frame.pbrMaterial.isFastMath = frame.isFastMath;
 	}
-}
 
-void CPU_Renderer::VertexTransformationFunction() const
-{
-	// Calculate once
-	MeshData* mesh = m_pMeshes[0]->GetMeshData();
+	if (frame.isShadowed)
+	{
+		if (!frame.pShadowMap || frame.pShadowMap->GetResolution() != RENDER_CONFIG->GetShadowMapResolution())
+		{
+			delete frame.pShadowMap;
+			frame.pShadowMap = new ShadowMap(RENDER_CONFIG->GetShadowMapResolution());
+		}
 
-	Matrix worldMatrix = mesh->scaleMatrix * mesh->rotationMatrix * mesh->transformMatrix;
-	const auto worldViewProjectionMatrix = worldMatrix * m_pCamera->viewMatrix * m_pCamera->projectionMatrix;
+		// The vertex stage needs the light frustum for the shadow coordinates
+		mesh->UpdateWorldSpaceVertices();
+		frame.pShadowMap->Fit(mesh->GetWorldPositions(), Shading::LightDirection);
+	}
 
-	m_pMeshes[0]->GetVerticesOut().clear();
+	// Transform from World -> View -> Projected -> Raster, only outputting what the shading mode reads
+	frame.varyingLayout = GetVaryingLayout(frame.isShadowed, frame.pointLightCount > 0);
 
-	// Loop over indices (every 3 indices is triangle)
-	for (const auto& vertex : mesh->vertices)
-	{
-		Vertex_Out rasterVertex{};
+	// Both only read the cached world space vertices, so the shadow map renders next to the vertex stage
+	JOB_SYSTEM->ParallelInvoke(
+		[this, mesh, &frame]
+		{
+			VertexTransformationFunction(mesh, frame.varyingLayout, frame);
+		},
+		[this, mesh, &frame]
+		{
+			if (frame.isShadowed)
+			{
+				StageProfiler::ScopedStage stage{ m_Profiler, "Shadow Map" };
+				frame.pShadowMap->Render(mesh->GetWorldPositions(), m_pCurrentMeshData->indices);
+			}
+		}
+	);
 
+	ScreenRect meshBounds = CalculateMeshBounds(mesh, frame.slot);
 
-		auto position = Vector4{ vertex.position, 1 };
+	// The thruster only reads its diffuse texture
+	if (frame.pTransparentMesh)
+	{
+		VertexTransformationFunction(frame.pTransparentMesh, VaryingLayout::Create(true, false, false, false, false, false), frame);
+		meshBounds.Merge(CalculateMeshBounds(frame.pTransparentMesh, frame.slot));
+	}
 
-		// Transform model to raster (screen space)
-		auto transformedVertex = worldViewProjectionMatrix.TransformPoint(position);
-		rasterVertex.viewDirection = worldMatrix.TransformPoint(vertex.position) - m_pCamera->origin;
+	if (!frame.pDirtyTiles->IsAllDirty())
+	{
+		frame.pDirtyTiles->MarkRect(m_PreviousMeshBounds.minX, m_PreviousMeshBounds.minY, m_PreviousMeshBounds.maxX, m_PreviousMeshBounds.maxY);
+		frame.pDirtyTiles->MarkRect(meshBounds.minX, meshBounds.minY, meshBounds.maxX, meshBounds.maxY);
+	}
 
-		// perspective divide
-		transformedVertex.x /= transformedVertex.w;
-		transformedVertex.y /= transformedVertex.w;
-		transformedVertex.z /= transformedVertex.w;
+	m_PreviousMeshBounds = meshBounds;
+	m_PreviousFrameState = frame.state;
+	m_HasPreviousFrame = true;
+}
 
-		// NDC to raster coordinates
-		transformedVertex.x = ((transformedVertex.x + 1) * (float)m_Width) / 2.f;
-		transformedVertex.y = ((1 - transformedVertex.y) * (float)m_Height) / 2.f;
+void CPU_Renderer::PresentNewestFrame()
+{
+	// Rasterization runs in submission order, so the newest finished frame supersedes all older ones
+	FrameContext* pNewestFrame{};
 
-		// Add vertex to vertices out and color
+	for (FrameContext& frame : m_Frames)
+	{
+		if (!frame.isPresented && m_pRasterWorker->IsCompleted(frame.rasterTicket)
+			&& (!pNewestFrame || frame.frameIndex > pNewestFrame->frameIndex))
+		{
+			pNewestFrame = &frame;
+		}
+	}
 
-		rasterVertex.position = transformedVertex;
-		rasterVertex.uv = vertex.uv;
+	// Still filling the pipeline
+	if (!pNewestFrame)
+	{
+		return;
+	}
 
-		Vector3 transformedNormals = worldMatrix.TransformVector(vertex.normal);
-		transformedNormals.Normalize();
+	for (FrameContext& frame : m_Frames)
+	{
+		if (frame.frameIndex <= pNewestFrame->frameIndex)
+		{
+			frame.isPresented = true;
+		}
+	}
 
-		Vector3 transformedTangent = worldMatrix.TransformVector(vertex.tangent);
-		transformedTangent.Normalize();
+	SDL_Surface* pBackBuffer = pNewestFrame->pBackBuffer;
 
-		rasterVertex.normal = transformedNormals;
-		rasterVertex.tangent = transformedTangent;
+	if (m_Width == m_WindowWidth && m_Height == m_WindowHeight)
+	{
+		SDL_BlitSurface(pBackBuffer, 0, m_pFrontBuffer, 0);
+	}
+	else
+	{
+		StageProfiler::ScopedStage stage{ m_Profiler, "Upscale" };
 
-		m_pMeshes[0]->GetVerticesOut().push_back(rasterVertex);
+		SDL_LockSurface(m_pFrontBuffer);
+		m_pUpscaler->Upscale(pBackBuffer, m_pFrontBuffer);
+		SDL_UnlockSurface(m_pFrontBuffer);
 	}
+
+	SDL_UpdateWindowSurface(m_pWindow);
 }
 
-void CPU_Renderer::RenderTriangle(Vertex_Out vertex1, Vertex_Out vertex2, Vertex_Out vertex3)
+void CPU_Renderer::RasterFrame(FrameContext& frame)
 {
-	const Vector2 v0 = Vector2{ vertex1.position.x, vertex1.position.y };
-	const Vector2 v1 = Vector2{ vertex2.position.x, vertex2.position.y };
-	const Vector2 v2 = Vector2{ vertex3.position.x, vertex3.position.y };
+	m_pRasterFrame = &frame;
 
-	// create and clamp bounding box top left
-	int maxX{}, maxY{};
-	maxX = static_cast<int>(std::max(v0.x, std::max(v1.x, v2.x)));
-	maxY = static_cast<int>(std::max(v0.y, std::max(v1.y, v2.y)));
+	//@START
+	//Lock BackBuffer
+	SDL_LockSurface(frame.pBackBuffer);
 
-	int minX{}, minY{};
-	minX = static_cast<int>(std::min(v0.x, std::min(v1.x, v2.x)));
-	minY = static_cast<int>(std::min(v0.y, std::min(v1.y, v2.y)));
+	if (!frame.isReused)
+	{
+		StageProfiler::ScopedStage stage{ m_Profiler, "Render" };
 
-	minX = std::clamp(minX, 0, m_Width);
-	minY = std::clamp(minY, 0, m_Height);
+		// Resolves into the back buffer and updates the shading rates of the next frame as the tiles finish
+		RenderFrame();
 
-	maxX = std::clamp(maxX, 0, m_Width);
-	maxY = std::clamp(maxY, 0, m_Height);
+		frame.backBufferVersion = ++m_ContentVersion;
 
-	for (int px{ minX }; px <= maxX; ++px)
+		if (!frame.state.shouldUseVariableRateShading)
+		{
+			m_pShadingRateImage->Reset();
+		}
+	}
+	// Reused frames only need the latest result in their own back buffer
+	else if (frame.backBufferVersion != m_ContentVersion)
 	{
-		for (int py{ minY }; py <= maxY; ++py)
+		if (frame.isHDR)
 		{
-			if (RENDER_CONFIG->ShouldRenderBoundingBox())
-			{
-				ColorRGB finalColor{ 1,1,1 };
+			m_pPostProcessor->Resolve(m_pDepthBufferPixels, frame.pBackBuffer, m_Profiler);
+		}
+		else
+		{
+			StageProfiler::ScopedStage stage{ m_Profiler, "Linearize" };
+			m_TiledLayout.Linearize(m_pColorBufferPixels, frame.pBackBuffer);
+		}
+
+		frame.backBufferVersion = m_ContentVersion;
+	}
 
-				//Update Color in Buffer
-				finalColor.MaxToOne();
+	//@END
+	SDL_UnlockSurface(frame.pBackBuffer);
 
-				m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+	m_pRasterFrame = nullptr;
+}
 
-				continue;
-			}
+void CPU_Renderer::RenderFrame()
+{
+	auto mesh = m_pMeshes[0];
+	const uint32_t amountOfIndices = static_cast<uint32_t>(m_pCurrentMeshData->indices.size());
 
-			Vector2 point{ (float)px, (float)py };
+	m_AmountOfTriangles = mesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleList
+		? amountOfIndices / 3
+		: (amountOfIndices >= 3 ? amountOfIndices - 2 : 0);
 
-			// Barycentric coordinates
-			float w0 = EdgeFunction(v1, v2, point);
-			float w1 = EdgeFunction(v2, v0, point);
-			float w2 = EdgeFunction(v0, v1, point);
+	// Only grows, later frames reuse the storage
+	if (m_TriangleSetups.size() < m_AmountOfTriangles)
+	{
+		m_TriangleSetups.resize(m_AmountOfTriangles);
+	}
 
-			// In triangle
-			bool isInTriangle{};
+	if (m_pRasterFrame->isShadowRayTraced || m_pRasterFrame->ambientOcclusionSampleCount > 0)
+	{
+		const FrameState& state = m_pRasterFrame->state;
+		m_pTracedVisibility->Prepare(state.worldMatrix, state.viewMatrix, state.projectionMatrix, Shading::LightDirection,
+			m_pRasterFrame->isShadowRayTraced, m_pRasterFrame->ambientOcclusionSampleCount, m_pRasterFrame->tracedFrameIndex);
+	}
 
-			// culling
-			switch (RENDER_CONFIG->GetCurrentCullMode())
-			{
-				case RenderConfig::CULL_MODE::BACK:
-					{
-						isInTriangle = w0 >= 0 && w1 >= 0 && w2 >= 0;
-					}
-					break;
-				case RenderConfig::CULL_MODE::FRONT:
-					{
-						isInTriangle = w0 < 0 && w1 < 0 && w2 < 0;
-					}
-					break;
-				case RenderConfig::CULL_MODE::NONE:
-					{
-						isInTriangle = (w0 >= 0 && w1 >= 0 && w2 >= 0) || (w0 <= 0 && w1 <= 0 && w2 <= 0);
-					}
-					break;
-			}
+	m_FrameGraph.Run();
+}
 
-			if (isInTriangle)
-			{
-				const float area = w0 + w1 + w2;
-				w0 /= area;
-				w1 /= area;
-				w2 /= area;
+void CPU_Renderer::BuildFrameGraph()
+{
+	// A row of tiles covers FrameTileSize / 2 bloom rows, so the composite of a row only needs the bloom of its neighbours
+	static_assert(PostProcessor::BloomRadius <= FrameTileSize / 2);
 
+	m_FrameTilesX = (m_Width + FrameTileSize - 1) / FrameTileSize;
+	m_FrameTilesY = (m_Height + FrameTileSize - 1) / FrameTileSize;
+	const int tileCount = m_FrameTilesX * m_FrameTilesY;
 
-				// Get the hit point Z with the barycentric weights
-				float z = 1.f / ((w0 / vertex1.position.z) + (w1 / vertex2.position.z) + (w2 / vertex3.position.z));
+	m_OpaqueBins.clear();
+	m_OpaqueBins.resize(BinningTaskCount * tileCount);
+	m_TransparentBins.clear();
+	m_TransparentBins.resize(tileCount);
 
-				if (z < 0 || z > 1)
-				{
-					continue;
-				}
+	m_FrameGraph.Clear();
 
-				const int pixelZIndex = py * m_Width + px;
+	// Raster work is on the critical path of the frame, recording work of the next frame waits for it
+	constexpr JobSystem::PRIORITY priority{ JobSystem::PRIORITY::HIGH };
 
-				// If new z value of pixel is lower than stored:
-				if (z < m_pDepthBufferPixels[pixelZIndex])
-				{
-					m_pDepthBufferPixels[pixelZIndex] = z;
-					const float wInterpolated = 1.f / ((w0 / vertex1.position.w) + (w1 / vertex2.position.w) + (w2 / vertex3.position.w));
-
-					// uv interpolated
-					Vector2 uvInterpolated = (vertex1.uv * (w0 / vertex1.position.w)) + (vertex2.uv * (w1 / vertex2.position.w)) + (vertex3.uv * (w2 / vertex3.position.w));
-					uvInterpolated *= wInterpolated;
-
-					uvInterpolated.x = std::clamp(uvInterpolated.x, 0.f, 1.f);
-					uvInterpolated.y = std::clamp(uvInterpolated.y, 0.f, 1.f);
-
-					// normal interpolated
-					Vector3 normalInterpolated =
-						(vertex1.normal * (w0 / vertex1.position.w)) +
-						(vertex2.normal * (w1 / vertex2.position.w)) +
-						(vertex3.normal * (w2 / vertex3.position.w));
-					normalInterpolated *= wInterpolated;
-					normalInterpolated.Normalize();
-
-					// tangent interpolated
-					Vector3 tangentInterpolated = (vertex1.tangent * (w0 / vertex1.position.w)) + (vertex2.tangent * (w1 / vertex2.position.w)) + (vertex3.tangent * (w2 / vertex3.position.w));
-					tangentInterpolated *= wInterpolated;
-					tangentInterpolated.Normalize();
-
-					// view dir interpolated
-					Vector3 viewDirInterpolated = (vertex1.viewDirection * (w0 / vertex1.position.w)) + (vertex2.viewDirection * (w1 / vertex2.position.w)) + (vertex3.viewDirection * (w2 / vertex3.position.w));
-					viewDirInterpolated *= wInterpolated;
-					viewDirInterpolated.Normalize();
-
-					Vertex_Out fragmentToShade{};
-					fragmentToShade.position = Vector4{ (float)px,(float)py,z, wInterpolated };
-					fragmentToShade.uv = uvInterpolated;
-					fragmentToShade.normal = normalInterpolated;
-					fragmentToShade.tangent = tangentInterpolated;
-					fragmentToShade.viewDirection = viewDirInterpolated;
-
-
-					ColorRGB finalColor{  };
-
-					
-					if (!RENDER_CONFIG->ShouldRenderDepthBuffer() && !RENDER_CONFIG->ShouldRenderBoundingBox())
-					{
-						finalColor = ShadePixel(fragmentToShade);
-					}
-					else if (RENDER_CONFIG->ShouldRenderDepthBuffer())
-					{
-						float depthValue = Utils::Remap(z, 0.995f, 1.f);
-						finalColor = { depthValue, depthValue, depthValue };
-					}
-
-					//Update Color in Buffer
-					finalColor.MaxToOne();
-
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(finalColor.r * 255),
-						static_cast<uint8_t>(finalColor.g * 255),
-						static_cast<uint8_t>(finalColor.b * 255));
-				}
-			}
-		}
+	std::array<TaskGraph::TaskId, BinningTaskCount + 1> binningTasks{};
+	for (int binningTask{}; binningTask < BinningTaskCount; ++binningTask)
+	{
+		binningTasks[binningTask] = m_FrameGraph.AddTask([this, binningTask]() { BinTriangles(binningTask); }, priority);
 	}
-}
+	binningTasks[BinningTaskCount] = m_FrameGraph.AddTask([this]() { BinTransparentTriangles(); }, priority);
 
-ColorRGB CPU_Renderer::ShadePixel(const Vertex_Out& vertex)
-{
-	// Normal map stuff
-	const Vector3 binormal = Vector3::Cross(vertex.normal, vertex.tangent).Normalized();
-	const Matrix tangentSpaceAxis = Matrix{ vertex.tangent, binormal, vertex.normal, {0,0,0} };
+	// Light culling runs next to the binning, a row of tiles only waits for the clusters it reads
+	static_assert(FrameTileSize % LightGrid::TileSize == 0);
+	const TaskGraph::TaskId prepareLightsTask = m_FrameGraph.AddTask([this]() { PrepareLights(); }, priority);
 
-	// Sample normal
-	const ColorRGB normalColor = m_pCurrentMeshData->textures[1]->Sample(vertex.uv);
-	
+	std::vector<TaskGraph::TaskId> bloomTasks(m_FrameTilesY);
+	for (int tileY{}; tileY < m_FrameTilesY; ++tileY)
+	{
+		bloomTasks[tileY] = m_FrameGraph.AddTask([this, tileY]() { BloomTileRow(tileY); }, priority);
 
-	Vector3 normalSample = { normalColor.r, normalColor.g, normalColor.b };
-	normalSample = 2.f * normalSample - Vector3{ 1.f, 1.f, 1.f };
-	normalSample = tangentSpaceAxis.TransformPoint(normalSample);
-	normalSample.Normalize();
+		const TaskGraph::TaskId lightRowTask = m_FrameGraph.AddTask([this, tileY]() { BuildLightRow(tileY); }, priority);
+		m_FrameGraph.AddDependency(lightRowTask, prepareLightsTask);
 
-	// Sample color
-	const ColorRGB color = m_pCurrentMeshData->textures[0]->Sample(vertex.uv);
+		for (int tileX{}; tileX < m_FrameTilesX; ++tileX)
+		{
+			const int tileIndex = tileY * m_FrameTilesX + tileX;
+			const TaskGraph::TaskId tileTask = m_FrameGraph.AddTask([this, tileIndex]() { RenderTile(tileIndex); }, priority);
 
-	// Sample specular
-	const ColorRGB specularColor = m_pCurrentMeshData->textures[2]->Sample(vertex.uv);
+			// Any triangle can touch any tile, so a tile's bins are complete once every binning task finished
+			for (TaskGraph::TaskId binningTask : binningTasks)
+			{
+				m_FrameGraph.AddDependency(tileTask, binningTask);
+			}
 
-	// Sample glossiness
-	const ColorRGB glossinessColor = m_pCurrentMeshData->textures[3]->Sample(vertex.uv);
+			m_FrameGraph.AddDependency(tileTask, lightRowTask);
 
-	// Lights
-	const Vector3 lightDirection = { .577f, -.577f, .577f };
-	const float lightIntensity = 7.f;
-	const float shininess = 25.f;
-	const ColorRGB ambient = { .025f, .025f, .025f };
-	const ColorRGB light = ColorRGB{ 1,1,1 } *lightIntensity;
+			m_FrameGraph.AddDependency(bloomTasks[tileY], tileTask);
+		}
+	}
 
-	float lambertCosine{};
-	if (RENDER_CONFIG->ShouldRenderNormalMap())
+	for (int tileY{}; tileY < m_FrameTilesY; ++tileY)
 	{
-		lambertCosine = Vector3::Dot(normalSample, -lightDirection);
+		const TaskGraph::TaskId compositeTask = m_FrameGraph.AddTask([this, tileY]() { CompositeTileRow(tileY); }, priority);
+
+		for (int neighbourY{ std::max(tileY - 1, 0) }; neighbourY <= std::min(tileY + 1, m_FrameTilesY - 1); ++neighbourY)
+		{
+			m_FrameGraph.AddDependency(compositeTask, bloomTasks[neighbourY]);
+		}
 	}
-	else 
+}
+
+void CPU_Renderer::PrepareLights()
+{
+	const int pointLightCount = m_pRasterFrame->pointLightCount;
+	if (pointLightCount == 0)
 	{
-		lambertCosine = Vector3::Dot(vertex.normal, -lightDirection);
+		return;
 	}
 
-	if (lambertCosine <= 0)
+	// The lights stay put in the world, only a new count scatters them again
+	if (m_pLightGrid->GetLightCount() != pointLightCount)
 	{
-		return { 0,0,0 };
+		m_pLightGrid->SetLights(ScatterPointLights(*m_pCurrentMeshData, pointLightCount));
 	}
 
-	
+	const FrameState& state = m_pRasterFrame->state;
+	m_pLightGrid->Prepare(state.viewMatrix, state.projectionMatrix, Camera::NearPlane, Camera::FarPlane);
+}
 
-	switch (RENDER_CONFIG->GetCurrentShadingMode())
-	{
-	case RenderConfig::SHADING_MODE::OBSERVED_AREA:
-	{
-		return { lambertCosine, lambertCosine, lambertCosine };
-	}
-	break;
-	case RenderConfig::SHADING_MODE::DIFFUSE:
+void CPU_Renderer::BuildLightRow(int tileY)
+{
+	if (m_pRasterFrame->pointLightCount == 0)
 	{
-		const ColorRGB diffuse = Shading::Lambert(1.f, color);
-		return light * diffuse * lambertCosine;
+		return;
 	}
-	break;
-	case RenderConfig::SHADING_MODE::SPECULAR:
-	{
 
-		const auto specularReflectance = specularColor;
-		const auto phongExponent = glossinessColor * shininess;
+	constexpr int lightTilesPerRow = FrameTileSize / LightGrid::TileSize;
+	const int minTileY = tileY * lightTilesPerRow;
+	m_pLightGrid->BuildRows(minTileY, std::min(minTileY + lightTilesPerRow, m_pLightGrid->GetTilesY()) - 1);
+}
 
-		const ColorRGB specular = Shading::Phong(
-			specularReflectance,
-			phongExponent,
-			lightDirection,
-			vertex.viewDirection,
-			vertex.normal
-		);
+void CPU_Renderer::BinTriangles(int binningTask)
+{
+	auto mesh = m_pMeshes[0];
+	const int tileCount = m_FrameTilesX * m_FrameTilesY;
+	std::vector<uint32_t>* pBins = &m_OpaqueBins[binningTask * tileCount];
 
-		return specular;
+	for (int tileIndex{}; tileIndex < tileCount; ++tileIndex)
+	{
+		pBins[tileIndex].clear();
 	}
 
-	break;
-	case RenderConfig::SHADING_MODE::COMBINED:
-	{
-		const auto specularReflectance = specularColor;
-		const auto phongExponent = glossinessColor * shininess;
+	// Contiguous ranges, so reading the bins task after task keeps the submission order
+	const uint32_t firstTriangle = static_cast<uint32_t>(static_cast<uint64_t>(m_AmountOfTriangles) * binningTask / BinningTaskCount);
+	const uint32_t lastTriangle = static_cast<uint32_t>(static_cast<uint64_t>(m_AmountOfTriangles) * (binningTask + 1) / BinningTaskCount);
 
-		const ColorRGB specular = Shading::Phong(
-			specularReflectance,
-			phongExponent,
-			lightDirection,
-			vertex.viewDirection,
-			vertex.normal
-		);
+	for (uint32_t index{ firstTriangle }; index < lastTriangle; ++index)
+	{
+		TriangleSetup& setup = m_TriangleSetups[index];
+		if (!SetupTriangle(GetPrimitive(mesh, index, m_pRasterFrame->varyingLayout.stride), setup))
+		{
+			continue;
+		}
 
-		const ColorRGB diffuse = Shading::Lambert(1.f, color);
+		for (int tileY{ setup.minY / FrameTileSize }; tileY <= setup.maxY / FrameTileSize; ++tileY)
+		{
+			for (int tileX{ setup.minX / FrameTileSize }; tileX <= setup.maxX / FrameTileSize; ++tileX)
+			{
+				pBins[tileY * m_FrameTilesX + tileX].push_back(index);
+			}
+		}
+	}
+}
 
-		return ((diffuse * light) + specular + ambient) * lambertCosine;
+void CPU_Renderer::BinTransparentTriangles()
+{
+	for (std::vector<uint32_t>& bin : m_TransparentBins)
+	{
+		bin.clear();
 	}
 
-	break;
-	case RenderConfig::SHADING_MODE::ENUM_LENGTH:
-		throw std::runtime_error("Unknown mode, bug in code");
+	CPU_Mesh* pMesh = m_pRasterFrame->pTransparentMesh;
+	if (!pMesh)
+	{
+		return;
 	}
 
-	const auto specularReflectance = specularColor;
-	const auto phongExponent = glossinessColor * shininess;
+	const std::vector<uint32_t>& indices = pMesh->GetMeshData()->indices;
+	const uint32_t amountOfTriangles = static_cast<uint32_t>(indices.size()) / 3;
+	constexpr int stride{ 2 };
 
-	const ColorRGB specular = Shading::Phong(
-		specularReflectance,
-		phongExponent,
-		lightDirection,
-		vertex.viewDirection,
-		normalSample
-	);
+	for (uint32_t index{}; index < amountOfTriangles; ++index)
+	{
+		TriangleSetup setup{};
+		if (!SetupTriangle(GetRasterTriangle(pMesh, indices[3 * index], indices[3 * index + 1], indices[3 * index + 2], stride), setup))
+		{
+			continue;
+		}
+
+		for (int tileY{ setup.minY / FrameTileSize }; tileY <= setup.maxY / FrameTileSize; ++tileY)
+		{
+			for (int tileX{ setup.minX / FrameTileSize }; tileX <= setup.maxX / FrameTileSize; ++tileX)
+			{
+				m_TransparentBins[tileY * m_FrameTilesX + tileX].push_back(index);
+			}
+		}
+	}
+}
+
+void CPU_Renderer::RenderTile(int tileIndex)
+{
+	auto mesh = m_pMeshes[0];
+	const int tileCount = m_FrameTilesX * m_FrameTilesY;
+	const int stride = m_pRasterFrame->varyingLayout.stride;
+
+	const int minX = (tileIndex % m_FrameTilesX) * FrameTileSize;
+	const int minY = (tileIndex / m_FrameTilesX) * FrameTileSize;
+	const int maxX = std::min(minX + FrameTileSize, m_Width) - 1;
+	const int maxY = std::min(minY + FrameTileSize, m_Height) - 1;
+
+	// Tiles reused from the previous frame only get resolved again
+	if (m_pRasterFrame->pDirtyTiles->IsRectDirty(minX, minY, maxX, maxY))
+	{
+		ClearDirtyTiles(minX, minY, maxX, maxY);
+
+		if (m_pRasterFrame->isDepthPrepassed)
+		{
+			const RenderConfig::CULL_MODE cullMode = m_pRasterFrame->state.cullMode;
+
+			for (int binningTask{}; binningTask < BinningTaskCount; ++binningTask)
+			{
+				for (uint32_t index : m_OpaqueBins[binningTask * tileCount + tileIndex])
+				{
+					const RasterTriangle triangle = GetPrimitive(mesh, index, stride);
+					const TriangleSetup& setup = m_TriangleSetups[index];
+
+					m_pDepthRasterizer->RenderTriangle(*triangle.pPosition1, *triangle.pPosition2, *triangle.pPosition3, m_pDepthBufferPixels, m_TiledLayout,
+						cullMode, m_pRasterFrame->pDirtyTiles,
+						std::max(setup.minX, minX), std::max(setup.minY, minY), std::min(setup.maxX, maxX), std::min(setup.maxY, maxY));
+				}
+			}
+
+			// The depth of the tile is final now, its shading reads what gets traced from it
+			if (m_pRasterFrame->isShadowRayTraced || m_pRasterFrame->ambientOcclusionSampleCount > 0)
+			{
+				m_pTracedVisibility->TraceRect(m_pDepthBufferPixels, *m_pRasterFrame->pDirtyTiles, minX, minY, maxX, maxY);
+			}
+		}
+
+		for (int binningTask{}; binningTask < BinningTaskCount; ++binningTask)
+		{
+			for (uint32_t index : m_OpaqueBins[binningTask * tileCount + tileIndex])
+			{
+				const RasterTriangle triangle = GetPrimitive(mesh, index, stride);
+
+				// Only the part inside this tile, tiles are aligned to the shading blocks
+				TriangleSetup setup = m_TriangleSetups[index];
+				setup.minX = std::max(setup.minX, minX);
+				setup.minY = std::max(setup.minY, minY);
+				setup.maxX = std::min(setup.maxX, maxX);
+				setup.maxY = std::min(setup.maxY, maxY);
+
+				if (setup.isSmall)
+				{
+					RenderSmallTriangle(triangle, setup);
+				}
+				else
+				{
+					RenderTriangle(triangle, setup);
+				}
+			}
+		}
+
+		// The last partial batch, before anything blends over it
+		if (m_pRasterFrame->isPbr)
+		{
+			FlushPbrFragments();
+		}
+
+		// Transparent geometry blends over the finished opaque pass
+		if (m_pRasterFrame->pTransparentMesh)
+		{
+			RenderTransparentTile(tileIndex, minX, minY, maxX, maxY);
+		}
+	}
+
+	// HDR frames resolve per row of tiles, the bloom needs the neighbouring tiles
+	if (m_pRasterFrame->isHDR)
+	{
+		return;
+	}
+
+	// Still in cache, every frame resolves all tiles since the back buffer can hold an older frame
+	m_TiledLayout.LinearizeRect(m_pColorBufferPixels, m_pRasterFrame->pBackBuffer, minX, minY, maxX, maxY);
+
+	// This frame decides the shading rates of the next one
+	if (m_pRasterFrame->state.shouldUseVariableRateShading)
+	{
+		m_pShadingRateImage->UpdateRect(static_cast<uint32_t*>(m_pRasterFrame->pBackBuffer->pixels), m_pRasterFrame->pBackBuffer->format,
+			minX, minY, maxX, maxY);
+	}
+}
+
+void CPU_Renderer::BloomTileRow(int tileY)
+{
+	if (!m_pRasterFrame->isHDR)
+	{
+		return;
+	}
+
+	m_pPostProcessor->Bloom(tileY * FrameTileSize, std::min((tileY + 1) * FrameTileSize, m_Height) - 1);
+}
+
+void CPU_Renderer::CompositeTileRow(int tileY)
+{
+	if (!m_pRasterFrame->isHDR)
+	{
+		return;
+	}
+
+	const int minY = tileY * FrameTileSize;
+	const int maxY = std::min(minY + FrameTileSize, m_Height) - 1;
+
+	m_pPostProcessor->Composite(minY, maxY, m_pDepthBufferPixels, m_pRasterFrame->pBackBuffer);
+
+	if (m_pRasterFrame->state.shouldUseVariableRateShading)
+	{
+		m_pShadingRateImage->UpdateRect(static_cast<uint32_t*>(m_pRasterFrame->pBackBuffer->pixels), m_pRasterFrame->pBackBuffer->format,
+			0, minY, m_Width - 1, maxY);
+	}
+}
+
+void CPU_Renderer::VertexTransformationFunction(CPU_Mesh* pMesh, const VaryingLayout& layout, const FrameContext& frame) const
+{
+	// World space data only gets recomputed when the mesh moved, camera only frames start from the cache
+	MeshData* mesh = pMesh->GetMeshData();
+	pMesh->UpdateWorldSpaceVertices();
+
+	const std::vector<Vector3>& worldPositions = pMesh->GetWorldPositions();
+	const std::vector<Vector3>& worldNormals = pMesh->GetWorldNormals();
+	const std::vector<Vector3>& worldTangents = pMesh->GetWorldTangents();
+
+	// Calculate once
+	const auto viewProjectionMatrix = m_pCamera->viewMatrix * m_pCamera->projectionMatrix;
+
+	std::vector<Vector4>& positionsOut = pMesh->GetPositionsOut(frame.slot);
+	std::vector<float>& varyingsOut = pMesh->GetVaryingsOut(frame.slot);
+	positionsOut.resize(mesh->vertices.size());
+	varyingsOut.resize(mesh->vertices.size() * layout.stride);
+
+	// Transform world to raster (screen space), perspective divide included
+	SIMD_KERNELS.TransformToRaster(worldPositions.data(), positionsOut.data(), static_cast<int>(mesh->vertices.size()), viewProjectionMatrix,
+		static_cast<float>(m_Width), static_cast<float>(m_Height));
+
+	for (size_t index{}; index < mesh->vertices.size(); ++index)
+	{
+		const Vector3& worldPosition = worldPositions[index];
+
+		// Only the attributes in the layout get stored
+		float* pVaryings = varyingsOut.data() + index * layout.stride;
+
+		if (layout.uv >= 0)
+		{
+			const Vector2& uv = mesh->vertices[index].uv;
+			pVaryings[layout.uv] = uv.x;
+			pVaryings[layout.uv + 1] = uv.y;
+		}
+
+		if (layout.normal >= 0)
+		{
+			const Vector3& normal = worldNormals[index];
+			pVaryings[layout.normal] = normal.x;
+			pVaryings[layout.normal + 1] = normal.y;
+			pVaryings[layout.normal + 2] = normal.z;
+		}
+
+		if (layout.tangent >= 0)
+		{
+			const Vector3& tangent = worldTangents[index];
+			pVaryings[layout.tangent] = tangent.x;
+			pVaryings[layout.tangent + 1] = tangent.y;
+			pVaryings[layout.tangent + 2] = tangent.z;
+		}
+
+		if (layout.normalMapUV >= 0)
+		{
+			const Vector2& normalMapUV = mesh->normalMapUV[index];
+			pVaryings[layout.normalMapUV] = normalMapUV.x;
+			pVaryings[layout.normalMapUV + 1] = normalMapUV.y;
+		}
+
+		if (layout.viewDirection >= 0)
+		{
+			const Vector3 viewDirection = worldPosition - m_pCamera->origin;
+			pVaryings[layout.viewDirection] = viewDirection.x;
+			pVaryings[layout.viewDirection + 1] = viewDirection.y;
+			pVaryings[layout.viewDirection + 2] = viewDirection.z;
+		}
+
+		if (layout.shadowCoord >= 0)
+		{
+			const Vector3 shadowCoord = frame.pShadowMap->GetShadowCoord(worldPosition);
+			pVaryings[layout.shadowCoord] = shadowCoord.x;
+			pVaryings[layout.shadowCoord + 1] = shadowCoord.y;
+			pVaryings[layout.shadowCoord + 2] = shadowCoord.z;
+		}
+	}
+}
+
+VaryingLayout CPU_Renderer::GetVaryingLayout(bool useShadowCoord, bool usePointLights) const
+{
+	// Debug visualizations only need the raster position
+	if (RENDER_CONFIG->ShouldRenderDepthBuffer() || RENDER_CONFIG->ShouldRenderBoundingBox())
+	{
+		return VaryingLayout::Create(false, false, false, false, false, false);
+	}
+
+	const RenderConfig::SHADING_MODE shadingMode = RENDER_CONFIG->GetCurrentShadingMode();
+	const bool useNormalMap = RENDER_CONFIG->ShouldRenderNormalMap();
+	const bool useSpecular = shadingMode == RenderConfig::SHADING_MODE::SPECULAR || shadingMode == RenderConfig::SHADING_MODE::COMBINED
+		|| shadingMode == RenderConfig::SHADING_MODE::PBR;
+
+	// A baked object space normal map has its own coordinates and needs no tangent
+	const bool useTangentSpaceMap = useNormalMap && !m_pCurrentMeshData->isNormalMapObjectSpace;
+	const bool useObjectSpaceMap = useNormalMap && m_pCurrentMeshData->isNormalMapObjectSpace;
+
+	// Observed area without normal map reads nothing but the normal
+	const bool useUV = useTangentSpaceMap || shadingMode != RenderConfig::SHADING_MODE::OBSERVED_AREA;
+
+	// Point lights get the world position back from the view direction
+	return VaryingLayout::Create(useUV, true, useTangentSpaceMap, useObjectSpaceMap, useSpecular || usePointLights, useShadowCoord);
+}
+
+CPU_Mesh* CPU_Renderer::GetTransparentMesh() const
+{
+	// The thruster is the second mesh, debug visualizations only show opaque geometry
+	if (m_pMeshes.size() < 2 || !RENDER_CONFIG->ShouldRenderThruster()
+		|| RENDER_CONFIG->ShouldRenderDepthBuffer() || RENDER_CONFIG->ShouldRenderBoundingBox())
+	{
+		return nullptr;
+	}
+
+	return m_pMeshes[1];
+}
+
+CPU_Renderer::FrameState CPU_Renderer::CaptureFrameState() const
+{
+	FrameState frameState{};
+	frameState.worldMatrix = m_pCurrentMeshData->worldMatrix;
+	frameState.shouldRenderTransparent = GetTransparentMesh() != nullptr;
+	if (frameState.shouldRenderTransparent)
+	{
+		frameState.transparentWorldMatrix = m_pMeshes[1]->GetMeshData()->worldMatrix;
+	}
+	frameState.viewMatrix = m_pCamera->viewMatrix;
+	frameState.projectionMatrix = m_pCamera->projectionMatrix;
+	frameState.clearColor = m_CurrentColor;
+	frameState.shadingMode = RENDER_CONFIG->GetCurrentShadingMode();
+	frameState.cullMode = RENDER_CONFIG->GetCurrentCullMode();
+	frameState.shouldRenderNormalMap = RENDER_CONFIG->ShouldRenderNormalMap();
+	frameState.shouldRenderDepthBuffer = RENDER_CONFIG->ShouldRenderDepthBuffer();
+	frameState.shouldRenderBoundingBox = RENDER_CONFIG->ShouldRenderBoundingBox();
+	frameState.shouldUseVariableRateShading = RENDER_CONFIG->ShouldUseVariableRateShading();
+	frameState.shouldUseHDR = RENDER_CONFIG->ShouldUseHDR();
+	frameState.shadowMapResolution = RENDER_CONFIG->GetShadowMapResolution();
+	frameState.mathQuality = static_cast<int>(RENDER_CONFIG->GetCurrentMathQuality());
+	frameState.pointLightCount = RENDER_CONFIG->GetPointLightCount();
+	frameState.shouldRayTraceShadows = RENDER_CONFIG->ShouldRayTraceShadows();
+	frameState.ambientOcclusionSampleCount = RENDER_CONFIG->GetAmbientOcclusionSampleCount();
+
+	return frameState;
+}
+
+bool CPU_Renderer::HasViewChanged(const FrameState& frameState) const
+{
+	const FrameState& previous = m_PreviousFrameState;
+
+	return !(frameState.viewMatrix == previous.viewMatrix)
+		|| !(frameState.projectionMatrix == previous.projectionMatrix)
+		|| frameState.clearColor.r != previous.clearColor.r
+		|| frameState.clearColor.g != previous.clearColor.g
+		|| frameState.clearColor.b != previous.clearColor.b
+		|| frameState.shadingMode != previous.shadingMode
+		|| frameState.cullMode != previous.cullMode
+		|| frameState.shouldRenderNormalMap != previous.shouldRenderNormalMap
+		|| frameState.shouldRenderDepthBuffer != previous.shouldRenderDepthBuffer
+		|| frameState.shouldRenderBoundingBox != previous.shouldRenderBoundingBox
+		|| frameState.shouldUseVariableRateShading != previous.shouldUseVariableRateShading
+		|| frameState.shouldUseHDR != previous.shouldUseHDR
+		|| frameState.shouldRenderTransparent != previous.shouldRenderTransparent
+		|| frameState.shadowMapResolution != previous.shadowMapResolution
+		|| frameState.mathQuality != previous.mathQuality
+		|| frameState.pointLightCount != previous.pointLightCount
+		|| frameState.shouldRayTraceShadows != previous.shouldRayTraceShadows
+		|| frameState.ambientOcclusionSampleCount != previous.ambientOcclusionSampleCount;
+}
+
+bool CPU_Renderer::CanReuseTracedVisibility(const FrameState& frameState) const
+{
+	const FrameState& previous = m_PreviousFrameState;
+
+	// New render targets hold nothing traced
+	return m_HasPreviousFrame
+		&& frameState.worldMatrix == previous.worldMatrix
+		&& frameState.viewMatrix == previous.viewMatrix
+		&& frameState.projectionMatrix == previous.projectionMatrix
+		&& frameState.cullMode == previous.cullMode
+		&& frameState.shouldRayTraceShadows == previous.shouldRayTraceShadows
+		&& frameState.ambientOcclusionSampleCount == previous.ambientOcclusionSampleCount
+		&& frameState.shouldRenderDepthBuffer == previous.shouldRenderDepthBuffer
+		&& frameState.shouldRenderBoundingBox == previous.shouldRenderBoundingBox;
+}
+
+CPU_Renderer::ScreenRect CPU_Renderer::CalculateMeshBounds(CPU_Mesh* pMesh, int slot) const
+{
+	// Triangles with a vertex off screen get culled, so every rasterized pixel lies within the clamped vertex bounds
+	float minX{ FLT_MAX };
+	float minY{ FLT_MAX };
+	float maxX{ -FLT_MAX };
+	float maxY{ -FLT_MAX };
+
+	for (const Vector4& position : pMesh->GetPositionsOut(slot))
+	{
+		minX = std::min(minX, position.x);
+		minY = std::min(minY, position.y);
+		maxX = std::max(maxX, position.x);
+		maxY = std::max(maxY, position.y);
+	}
+
+	ScreenRect bounds{};
+	if (minX > maxX)
+	{
+		return bounds;
+	}
+
+	bounds.minX = std::max(static_cast<int>(floorf(std::max(minX, 0.f))), 0);
+	bounds.minY = std::max(static_cast<int>(floorf(std::max(minY, 0.f))), 0);
+	bounds.maxX = std::min(static_cast<int>(ceilf(std::min(maxX, static_cast<float>(m_Width)))), m_Width - 1);
+	bounds.maxY = std::min(static_cast<int>(ceilf(std::min(maxY, static_cast<float>(m_Height)))), m_Height - 1);
+
+	return bounds;
+}
+
+void CPU_Renderer::ClearDirtyTiles(int minX, int minY, int maxX, int maxY)
+{
+	const ColorRGB& clearColorRGB = m_pRasterFrame->state.clearColor;
+	const uint32_t clearColor = SDL_MapRGB(m_pRasterFrame->pBackBuffer->format, clearColorRGB.r, clearColorRGB.g, clearColorRGB.b);
+
+	// Frame tiles are aligned to the dirty tiles
+	for (int y{ minY }; y <= maxY; y += DirtyTileMap::TileSize)
+	{
+		for (int x{ minX }; x <= maxX; x += DirtyTileMap::TileSize)
+		{
+			if (!m_pRasterFrame->pDirtyTiles->IsTileDirty(x, y))
+			{
+				continue;
+			}
+
+			const int tileMaxX = std::min(x + DirtyTileMap::TileSize - 1, maxX);
+			const int tileMaxY = std::min(y + DirtyTileMap::TileSize - 1, maxY);
+
+			m_TiledLayout.FillRect(m_pDepthBufferPixels, x, y, tileMaxX, tileMaxY, FLT_MAX);
+
+			if (m_pRasterFrame->isHDR)
+			{
+				m_pPostProcessor->Clear(clearColorRGB / 255.f, x, y, tileMaxX, tileMaxY);
+			}
+			else
+			{
+				m_TiledLayout.FillRect(m_pColorBufferPixels, x, y, tileMaxX, tileMaxY, clearColor);
+			}
+		}
+	}
+}
+
+CPU_Renderer::RasterTriangle CPU_Renderer::GetRasterTriangle(CPU_Mesh* pMesh, uint32_t index1, uint32_t index2, uint32_t index3, int stride) const
+{
+	const Vector4* pPositions = pMesh->GetPositionsOut(m_pRasterFrame->slot).data();
+	const float* pVaryings = pMesh->GetVaryingsOut(m_pRasterFrame->slot).data();
+
+	return RasterTriangle{
+		pPositions + index1, pPositions + index2, pPositions + index3,
+		pVaryings + index1 * stride, pVaryings + index2 * stride, pVaryings + index3 * stride
+	};
+}
+
+CPU_Renderer::RasterTriangle CPU_Renderer::GetPrimitive(CPU_Mesh* pMesh, uint32_t primitive, int stride) const
+{
+	const std::vector<uint32_t>& indices = pMesh->GetMeshData()->indices;
+
+	if (pMesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleStrip)
+	{
+		// Every odd triangle has its winding flipped
+		return (primitive & 1)
+			? GetRasterTriangle(pMesh, indices[primitive], indices[primitive + 2], indices[primitive + 1], stride)
+			: GetRasterTriangle(pMesh, indices[primitive], indices[primitive + 1], indices[primitive + 2], stride);
+	}
+
+	return GetRasterTriangle(pMesh, indices[3 * primitive], indices[3 * primitive + 1], indices[3 * primitive + 2], stride);
+}
+
+bool CPU_Renderer::SetupTriangle(const RasterTriangle& triangle, TriangleSetup& setup) const
+{
+	const Vector4& position1 = *triangle.pPosition1;
+	const Vector4& position2 = *triangle.pPosition2;
+	const Vector4& position3 = *triangle.pPosition3;
+
+	// cull triangles
+	if (position1.x < 0 || position2.x < 0 || position3.x < 0
+		|| position1.x > m_Width || position2.x > m_Width || position3.x > m_Width
+		|| position1.y < 0 || position2.y < 0 || position3.y < 0
+		|| position1.y > m_Height || position2.y > m_Height || position3.y > m_Height
+		)
+	{
+		return false;
+	}
+
+	// Pixels are sampled at integer coordinates, so only those inside the float bounds can be covered
+	const float minX = std::min(position1.x, std::min(position2.x, position3.x));
+	const float minY = std::min(position1.y, std::min(position2.y, position3.y));
+	const float maxX = std::max(position1.x, std::max(position2.x, position3.x));
+	const float maxY = std::max(position1.y, std::max(position2.y, position3.y));
+
+	setup.minX = std::max(static_cast<int>(ceilf(minX)), 0);
+	setup.minY = std::max(static_cast<int>(ceilf(minY)), 0);
+	setup.maxX = std::min(static_cast<int>(maxX), m_Width - 1);
+	setup.maxY = std::min(static_cast<int>(maxY), m_Height - 1);
+
+	// Falls between sample points
+	if (setup.minX > setup.maxX || setup.minY > setup.maxY)
+	{
+		return false;
+	}
+
+	// Only covers tiles that are reused from the previous frame
+	if (!m_pRasterFrame->pDirtyTiles->IsRectDirty(setup.minX, setup.minY, setup.maxX, setup.maxY))
+	{
+		return false;
+	}
+
+	setup.isSmall = (setup.maxX - setup.minX) < 2 && (setup.maxY - setup.minY) < 2 && !m_pRasterFrame->state.shouldRenderBoundingBox;
+
+	return true;
+}
+
+void CPU_Renderer::RenderTriangle(const RasterTriangle& triangle, const TriangleSetup& setup)
+{
+	const int minX = setup.minX;
+	const int minY = setup.minY;
+	const int maxX = setup.maxX;
+	const int maxY = setup.maxY;
+
+	if (m_pRasterFrame->state.shouldRenderBoundingBox)
+	{
+		const uint32_t white = SDL_MapRGB(m_pRasterFrame->pBackBuffer->format, 255, 255, 255);
+
+		for (int py{ minY }; py <= maxY; ++py)
+		{
+			for (int px{ minX }; px <= maxX; ++px)
+			{
+				if (!m_pRasterFrame->pDirtyTiles->IsTileDirty(px, py))
+				{
+					continue;
+				}
+
+				m_pColorBufferPixels[m_TiledLayout.GetIndex(px, py)] = white;
+			}
+		}
+
+		return;
+	}
+
+	// Depth visualization needs a value per pixel, so it always runs at full rate
+	const bool useVariableRate = m_pRasterFrame->state.shouldUseVariableRateShading && !m_pRasterFrame->state.shouldRenderDepthBuffer;
+
+	// Walk the bounding box in blocks of the coarsest rate, the tile rate then decides how many shading blocks that is
+	constexpr int blockSize{ 4 };
+
+	for (int by{ minY - (minY % blockSize) }; by <= maxY; by += blockSize)
+	{
+		for (int bx{ minX - (minX % blockSize) }; bx <= maxX; bx += blockSize)
+		{
+			// Blocks never straddle tiles
+			if (!m_pRasterFrame->pDirtyTiles->IsTileDirty(bx, by))
+			{
+				continue;
+			}
+
+			const ShadingRate rate = useVariableRate ? m_pShadingRateImage->GetRate(bx, by) : ShadingRate::RATE_1X1;
+			const int rateWidth = GetShadingRateWidth(rate);
+			const int rateHeight = GetShadingRateHeight(rate);
+
+			for (int sy{ by }; sy < by + blockSize; sy += rateHeight)
+			{
+				for (int sx{ bx }; sx < bx + blockSize; sx += rateWidth)
+				{
+					RenderShadingBlock(triangle,
+						std::max(sx, minX), std::max(sy, minY),
+						std::min(sx + rateWidth - 1, maxX), std::min(sy + rateHeight - 1, maxY));
+				}
+			}
+		}
+	}
+}
+
+void CPU_Renderer::RenderShadingBlock(const RasterTriangle& triangle, int minX, int minY, int maxX, int maxY)
+{
+	const Vector2 v0 = triangle.pPosition1->GetXY();
+	const Vector2 v1 = triangle.pPosition2->GetXY();
+	const Vector2 v2 = triangle.pPosition3->GetXY();
+
+	// Coverage and depth are resolved per pixel, shading happens once for the whole block
+	bool isBlockShaded{ false };
+	ColorRGB blockColor{};
+	uint32_t packedBlockColor{};
+
+	for (int py{ minY }; py <= maxY; ++py)
+	{
+		for (int px{ minX }; px <= maxX; ++px)
+		{
+			Vector2 point{ (float)px, (float)py };
+
+			// Barycentric coordinates
+			float w0 = DepthRasterizer::EdgeFunction(v1, v2, point);
+			float w1 = DepthRasterizer::EdgeFunction(v2, v0, point);
+			float w2 = DepthRasterizer::EdgeFunction(v0, v1, point);
+
+			if (!IsInsideTriangle(w0, w1, w2))
+			{
+				continue;
+			}
+
+			const int pixelIndex = m_TiledLayout.GetIndex(px, py);
+
+			float z{};
+			if (!TestDepth(triangle, pixelIndex, w0, w1, w2, z))
+			{
+				continue;
+			}
+
+			// The batch writes every pixel of the block once it is shaded
+			if (m_pRasterFrame->isPbr)
+			{
+				if (!isBlockShaded)
+				{
+					QueuePbrFragment(triangle, px, py, w0, w1, w2, z);
+					isBlockShaded = true;
+				}
+
+				AddPbrPixel(pixelIndex);
+				continue;
+			}
+
+			if (!isBlockShaded)
+			{
+				blockColor = ShadeFragment(triangle, px, py, w0, w1, w2, z);
+
+				// HDR frames keep the unclamped color for the post chain
+				if (!m_pRasterFrame->isHDR)
+				{
+					packedBlockColor = PackColor(blockColor);
+				}
+
+				isBlockShaded = true;
+			}
+
+			if (m_pRasterFrame->isHDR)
+			{
+				m_pPostProcessor->Write(pixelIndex, blockColor);
+			}
+			else
+			{
+				m_pColorBufferPixels[pixelIndex] = packedBlockColor;
+			}
+		}
+	}
+}
+
+void CPU_Renderer::RenderSmallTriangle(const RasterTriangle& triangle, const TriangleSetup& setup)
+{
+	// The (at most) 2x2 candidate sample points, one per lane
+	const __m128 pointX = _mm_add_ps(_mm_set1_ps(static_cast<float>(setup.minX)), _mm_setr_ps(0.f, 1.f, 0.f, 1.f));
+	const __m128 pointY = _mm_add_ps(_mm_set1_ps(static_cast<float>(setup.minY)), _mm_setr_ps(0.f, 0.f, 1.f, 1.f));
+
+	int laneMask{ 0b1111 };
+	if (setup.maxX == setup.minX)
+	{
+		laneMask &= 0b0101;
+	}
+	if (setup.maxY == setup.minY)
+	{
+		laneMask &= 0b0011;
+	}
+
+	const __m128 w0 = EdgeFunction4(*triangle.pPosition2, *triangle.pPosition3, pointX, pointY);
+	const __m128 w1 = EdgeFunction4(*triangle.pPosition3, *triangle.pPosition1, pointX, pointY);
+	const __m128 w2 = EdgeFunction4(*triangle.pPosition1, *triangle.pPosition2, pointX, pointY);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 allPositive = _mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_and_ps(_mm_cmpge_ps(w1, zero), _mm_cmpge_ps(w2, zero)));
+
+	__m128 coverage{};
+	switch (m_pRasterFrame->state.cullMode)
+	{
+	case RenderConfig::CULL_MODE::BACK:
+		coverage = allPositive;
+		break;
+	case RenderConfig::CULL_MODE::FRONT:
+		coverage = _mm_and_ps(_mm_cmplt_ps(w0, zero), _mm_and_ps(_mm_cmplt_ps(w1, zero), _mm_cmplt_ps(w2, zero)));
+		break;
+	default:
+		coverage = _mm_or_ps(allPositive, _mm_and_ps(_mm_cmple_ps(w0, zero), _mm_and_ps(_mm_cmple_ps(w1, zero), _mm_cmple_ps(w2, zero))));
+		break;
+	}
+
+	int coveredLanes = _mm_movemask_ps(coverage) & laneMask;
+
+	// Hits no sample center
+	if (coveredLanes == 0)
+	{
+		return;
+	}
+
+	alignas(16) float weights0[4];
+	alignas(16) float weights1[4];
+	alignas(16) float weights2[4];
+	_mm_store_ps(weights0, w0);
+	_mm_store_ps(weights1, w1);
+	_mm_store_ps(weights2, w2);
+
+	for (int lane{}; lane < 4; ++lane)
+	{
+		if ((coveredLanes & (1 << lane)) == 0)
+		{
+			continue;
+		}
+
+		const int px = setup.minX + (lane & 1);
+		const int py = setup.minY + (lane >> 1);
+		const int pixelIndex = m_TiledLayout.GetIndex(px, py);
+
+		if (!m_pRasterFrame->pDirtyTiles->IsTileDirty(px, py))
+		{
+			continue;
+		}
 
-	const ColorRGB diffuse = Shading::Lambert(1.f, color);
+		float w0Lane = weights0[lane];
+		float w1Lane = weights1[lane];
+		float w2Lane = weights2[lane];
 
-	return ((diffuse * light) + specular + ambient) * lambertCosine;
+		float z{};
+		if (!TestDepth(triangle, pixelIndex, w0Lane, w1Lane, w2Lane, z))
+		{
+			continue;
+		}
+
+		if (m_pRasterFrame->isPbr)
+		{
+			QueuePbrFragment(triangle, px, py, w0Lane, w1Lane, w2Lane, z);
+			AddPbrPixel(pixelIndex);
+			continue;
+		}
+
+		const ColorRGB color = ShadeFragment(triangle, px, py, w0Lane, w1Lane, w2Lane, z);
+
+		if (m_pRasterFrame->isHDR)
+		{
+			m_pPostProcessor->Write(pixelIndex, color);
+		}
+		else
+		{
+			m_pColorBufferPixels[pixelIndex] = PackColor(color);
+		}
+	}
+}
+
+void CPU_Renderer::RenderTransparentTile(int tileIndex, int minX, int minY, int maxX, int maxY)
+{
+	const std::vector<uint32_t>& bin = m_TransparentBins[tileIndex];
+	if (bin.empty())
+	{
+		return;
+	}
+
+	CPU_Mesh* pMesh = m_pRasterFrame->pTransparentMesh;
+	const MeshData* pMeshData = pMesh->GetMeshData();
+	const Texture* pTexture = pMeshData->textures[0];
+	const std::vector<uint32_t>& indices = pMeshData->indices;
+	constexpr int stride{ 2 };
+
+	m_pTransparencyBuffer->Clear(minX, minY, maxX, maxY);
+
+	// Submission order does not matter for weighted blended transparency
+	for (uint32_t index : bin)
+	{
+		const RasterTriangle triangle = GetRasterTriangle(pMesh, indices[3 * index], indices[3 * index + 1], indices[3 * index + 2], stride);
+
+		TriangleSetup setup{};
+		SetupTriangle(triangle, setup);
+
+		RenderTransparentTriangle(triangle, pTexture,
+			std::max(setup.minX, minX), std::max(setup.minY, minY),
+			std::min(setup.maxX, maxX), std::min(setup.maxY, maxY));
+	}
+
+	CompositeTransparency(minX, minY, maxX, maxY);
+}
+
+void CPU_Renderer::RenderTransparentTriangle(const RasterTriangle& triangle, const Texture* pTexture, int minX, int minY, int maxX, int maxY)
+{
+	const Vector2 v0 = triangle.pPosition1->GetXY();
+	const Vector2 v1 = triangle.pPosition2->GetXY();
+	const Vector2 v2 = triangle.pPosition3->GetXY();
+
+	for (int py{ minY }; py <= maxY; ++py)
+	{
+		for (int px{ minX }; px <= maxX; ++px)
+		{
+			// Tiles reused from the previous frame already hold the composited result
+			if (!m_pRasterFrame->pDirtyTiles->IsTileDirty(px, py))
+			{
+				continue;
+			}
+
+			const Vector2 point{ (float)px, (float)py };
+
+			float w0 = DepthRasterizer::EdgeFunction(v1, v2, point);
+			float w1 = DepthRasterizer::EdgeFunction(v2, v0, point);
+			float w2 = DepthRasterizer::EdgeFunction(v0, v1, point);
+
+			// No culling, like the hardware thruster effect
+			const bool isFrontFacing = w0 >= 0 && w1 >= 0 && w2 >= 0;
+			const bool isBackFacing = w0 <= 0 && w1 <= 0 && w2 <= 0;
+			const float area = w0 + w1 + w2;
+
+			if ((!isFrontFacing && !isBackFacing) || area == 0.f)
+			{
+				continue;
+			}
+
+			w0 /= area;
+			w1 /= area;
+			w2 /= area;
+
+			// Depth test against the opaque pass, transparent fragments never write depth
+			const int pixelIndex = m_TiledLayout.GetIndex(px, py);
+			const float z = 1.f / ((w0 / triangle.pPosition1->z) + (w1 / triangle.pPosition2->z) + (w2 / triangle.pPosition3->z));
+
+			if (z < 0 || z > 1 || z >= m_pDepthBufferPixels[pixelIndex])
+			{
+				continue;
+			}
+
+			const float weight1 = w0 / triangle.pPosition1->w;
+			const float weight2 = w1 / triangle.pPosition2->w;
+			const float weight3 = w2 / triangle.pPosition3->w;
+			const float wInterpolated = 1.f / (weight1 + weight2 + weight3);
+
+			const Vector2 uv{
+				std::clamp((triangle.pVaryings1[0] * weight1 + triangle.pVaryings2[0] * weight2 + triangle.pVaryings3[0] * weight3) * wInterpolated, 0.f, 1.f),
+				std::clamp((triangle.pVaryings1[1] * weight1 + triangle.pVaryings2[1] * weight2 + triangle.pVaryings3[1] * weight3) * wInterpolated, 0.f, 1.f)
+			};
+
+			float alpha{};
+			const ColorRGB color = pTexture->Sample(uv, alpha);
+
+			if (alpha <= 0.f)
+			{
+				continue;
+			}
+
+			m_pTransparencyBuffer->Accumulate(pixelIndex, color, alpha, wInterpolated);
+		}
+	}
+}
+
+void CPU_Renderer::CompositeTransparency(int minX, int minY, int maxX, int maxY)
+{
+	for (int py{ minY }; py <= maxY; ++py)
+	{
+		for (int px{ minX }; px <= maxX; ++px)
+		{
+			const int pixelIndex = m_TiledLayout.GetIndex(px, py);
+
+			if (m_pRasterFrame->isHDR)
+			{
+				ColorRGB color = m_pPostProcessor->Read(pixelIndex);
+				if (m_pTransparencyBuffer->Composite(pixelIndex, color))
+				{
+					m_pPostProcessor->Write(pixelIndex, color);
+				}
+
+				continue;
+			}
+
+			uint8_t r{}, g{}, b{};
+			SDL_GetRGB(m_pColorBufferPixels[pixelIndex], m_pRasterFrame->pBackBuffer->format, &r, &g, &b);
+
+			ColorRGB color{ r / 255.f, g / 255.f, b / 255.f };
+			if (m_pTransparencyBuffer->Composite(pixelIndex, color))
+			{
+				m_pColorBufferPixels[pixelIndex] = PackColor(color);
+			}
+		}
+	}
+}
+
+bool CPU_Renderer::IsInsideTriangle(float w0, float w1, float w2) const
+{
+	// culling
+	return DepthRasterizer::IsCovered(m_pRasterFrame->state.cullMode, w0, w1, w2);
+}
+
+bool CPU_Renderer::TestDepth(const RasterTriangle& triangle, int pixelIndex, float& w0, float& w1, float& w2, float& z)
+{
+	// Get the hit point Z with the barycentric weights
+	z = DepthRasterizer::InterpolateDepth(w0, w1, w2, triangle.pPosition1->z, triangle.pPosition2->z, triangle.pPosition3->z);
+
+	if (z < 0 || z > 1)
+	{
+		return false;
+	}
+
+	// If new z value of pixel is lower than stored, after the prepass only the front-most depth is left to match
+	if (m_pRasterFrame->isDepthPrepassed ? z > m_pDepthBufferPixels[pixelIndex] : z >= m_pDepthBufferPixels[pixelIndex])
+	{
+		return false;
+	}
+
+	m_pDepthBufferPixels[pixelIndex] = z;
+	return true;
+}
+
+ColorRGB CPU_Renderer::ShadeFragment(const RasterTriangle& triangle, int px, int py, float w0, float w1, float w2, float z)
+{
+	if (m_pRasterFrame->state.shouldRenderDepthBuffer)
+	{
+		float depthValue = Utils::Remap(z, 0.995f, 1.f);
+		return { depthValue, depthValue, depthValue };
+	}
+
+	return ShadePixel(InterpolateFragment(triangle, px, py, w0, w1, w2, z));
+}
+
+Vertex_Out CPU_Renderer::InterpolateFragment(const RasterTriangle& triangle, int px, int py, float w0, float w1, float w2, float z) const
+{
+	// Perspective correct weights, depth stays exact since it has to match the prepass
+	const bool isFastMath = m_pRasterFrame->isFastMath;
+	const float weight1 = w0 / triangle.pPosition1->w;
+	const float weight2 = w1 / triangle.pPosition2->w;
+	const float weight3 = w2 / triangle.pPosition3->w;
+	const float wInterpolated = isFastMath ? FastMath::Reciprocal(weight1 + weight2 + weight3) : 1.f / (weight1 + weight2 + weight3);
+
+	// The varying block only holds what the shading mode reads, so interpolate all of it in one loop
+	const VaryingLayout& layout = m_pRasterFrame->varyingLayout;
+	float varyings[VaryingLayout::MaxStride];
+
+	for (int index{}; index < layout.stride; ++index)
+	{
+		varyings[index] = (triangle.pVaryings1[index] * weight1 + triangle.pVaryings2[index] * weight2 + triangle.pVaryings3[index] * weight3) * wInterpolated;
+	}
+
+	Vertex_Out fragmentToShade{};
+	fragmentToShade.position = Vector4{ (float)px,(float)py,z, wInterpolated };
+
+	if (layout.uv >= 0)
+	{
+		fragmentToShade.uv.x = std::clamp(varyings[layout.uv], 0.f, 1.f);
+		fragmentToShade.uv.y = std::clamp(varyings[layout.uv + 1], 0.f, 1.f);
+	}
+
+	if (layout.normal >= 0)
+	{
+		const Vector3 normal{ varyings[layout.normal], varyings[layout.normal + 1], varyings[layout.normal + 2] };
+		fragmentToShade.normal = isFastMath ? FastMath::Normalized(normal) : normal.Normalized();
+	}
+
+	if (layout.tangent >= 0)
+	{
+		const Vector3 tangent{ varyings[layout.tangent], varyings[layout.tangent + 1], varyings[layout.tangent + 2] };
+		fragmentToShade.tangent = isFastMath ? FastMath::Normalized(tangent) : tangent.Normalized();
+	}
+
+	if (layout.normalMapUV >= 0)
+	{
+		fragmentToShade.normalMapUV.x = std::clamp(varyings[layout.normalMapUV], 0.f, 1.f);
+		fragmentToShade.normalMapUV.y = std::clamp(varyings[layout.normalMapUV + 1], 0.f, 1.f);
+	}
+
+	if (layout.viewDirection >= 0)
+	{
+		const Vector3 viewDirection{ varyings[layout.viewDirection], varyings[layout.viewDirection + 1], varyings[layout.viewDirection + 2] };
+		fragmentToShade.viewDirection = isFastMath ? FastMath::Normalized(viewDirection) : viewDirection.Normalized();
+		fragmentToShade.worldPosition = m_pRasterFrame->cameraOrigin + viewDirection;
+	}
+
+	if (layout.shadowCoord >= 0)
+	{
+		fragmentToShade.shadowCoord = Vector3{ varyings[layout.shadowCoord], varyings[layout.shadowCoord + 1], varyings[layout.shadowCoord + 2] };
+	}
+
+	return fragmentToShade;
+}
+
+void CPU_Renderer::QueuePbrFragment(const RasterTriangle& triangle, int px, int py, float w0, float w1, float w2, float z)
+{
+	PbrQueue& queue = t_PbrQueue;
+	if (queue.batch.count == PbrBatch::Size)
+	{
+		FlushPbrFragments();
+	}
+
+	const Vertex_Out vertex = InterpolateFragment(triangle, px, py, w0, w1, w2, z);
+	const Vector3 normal = GetShadingNormal(vertex);
+
+	const ColorRGB color = m_pCurrentMeshData->textures[0]->Sample(vertex.uv);
+	const ColorRGB specularColor = m_pCurrentMeshData->textures[2]->Sample(vertex.uv);
+	const ColorRGB glossinessColor = m_pCurrentMeshData->textures[3]->Sample(vertex.uv);
+
+	// Facing away the direct light is 0 anyway, only the rest needs the shadows
+	const float visibility = Vector3::Dot(normal, -Shading::LightDirection) > 0.f ? GetLightVisibility(vertex) : 0.f;
+
+	PbrBatch& batch = queue.batch;
+	const int entry = batch.count++;
+	batch.normalX[entry] = normal.x;
+	batch.normalY[entry] = normal.y;
+	batch.normalZ[entry] = normal.z;
+	batch.viewX[entry] = vertex.viewDirection.x;
+	batch.viewY[entry] = vertex.viewDirection.y;
+	batch.viewZ[entry] = vertex.viewDirection.z;
+	batch.albedoR[entry] = color.r;
+	batch.albedoG[entry] = color.g;
+	batch.albedoB[entry] = color.b;
+	batch.specularR[entry] = specularColor.r;
+	batch.specularG[entry] = specularColor.g;
+	batch.specularB[entry] = specularColor.b;
+	batch.glossiness[entry] = glossinessColor.r;
+	batch.visibility[entry] = visibility;
+	batch.ambientOcclusion[entry] = GetAmbientOcclusion(vertex);
+	queue.pixelCounts[entry] = 0;
+}
+
+void CPU_Renderer::AddPbrPixel(int pixelIndex) const
+{
+	PbrQueue& queue = t_PbrQueue;
+	const int entry = queue.batch.count - 1;
+	queue.pixelIndices[entry][queue.pixelCounts[entry]++] = pixelIndex;
+}
+
+void CPU_Renderer::FlushPbrFragments()
+{
+	PbrQueue& queue = t_PbrQueue;
+	if (queue.batch.count == 0)
+	{
+		return;
+	}
+
+	alignas(64) float red[PbrBatch::Capacity];
+	alignas(64) float green[PbrBatch::Capacity];
+	alignas(64) float blue[PbrBatch::Capacity];
+	SIMD_KERNELS.ShadePbrBatch(m_pRasterFrame->pbrMaterial, queue.batch, red, green, blue);
+
+	for (int entry{}; entry < queue.batch.count; ++entry)
+	{
+		const ColorRGB color{ red[entry], green[entry], blue[entry] };
+		const int* pPixelIndices = queue.pixelIndices[entry];
+
+		// HDR frames keep the unclamped color for the post chain
+		if (m_pRasterFrame->isHDR)
+		{
+			for (int pixel{}; pixel < queue.pixelCounts[entry]; ++pixel)
+			{
+				m_pPostProcessor->Write(pPixelIndices[pixel], color);
+			}
+		}
+		else
+		{
+			const uint32_t packedColor = PackColor(color);
+			for (int pixel{}; pixel < queue.pixelCounts[entry]; ++pixel)
+			{
+				m_pColorBufferPixels[pPixelIndices[pixel]] = packedColor;
+			}
+		}
+	}
+
+	queue.batch.count = 0;
+}
+
+uint32_t CPU_Renderer::PackColor(ColorRGB color) const
+{
+	//Update Color in Buffer
+	color.MaxToOne();
+
+	return SDL_MapRGB(m_pRasterFrame->pBackBuffer->format,
+		static_cast<uint8_t>(color.r * 255),
+		static_cast<uint8_t>(color.g * 255),
+		static_cast<uint8_t>(color.b * 255));
+}
+
+ColorRGB CPU_Renderer::ShadePixel(const Vertex_Out& vertex)
+{
+	// Lights
+	const Vector3& lightDirection = Shading::LightDirection;
+	const ColorRGB light = ColorRGB{ 1,1,1 } * Shading::LightIntensity;
+	const bool isFastMath = m_pRasterFrame->isFastMath;
+	const Vector3 normal = GetShadingNormal(vertex);
+
+	float lambertCosine = Vector3::Dot(normal, -lightDirection);
+
+	// Point lights and the sky are not shadowed and also reach what faces away from the directional light
+	const RenderConfig::SHADING_MODE shadingMode = m_pRasterFrame->state.shadingMode;
+	const bool hasUnshadowedLight = m_pRasterFrame->pointLightCount > 0 || shadingMode == RenderConfig::SHADING_MODE::COMBINED;
+
+	if (lambertCosine <= 0 && !hasUnshadowedLight)
+	{
+		return { 0,0,0 };
+	}
+
+	// Occluded light
+	if (lambertCosine > 0)
+	{
+		lambertCosine *= GetLightVisibility(vertex);
+
+		if (lambertCosine <= 0 && !hasUnshadowedLight)
+		{
+			return { 0,0,0 };
+		}
+	}
+
+	lambertCosine = std::max(lambertCosine, 0.f);
+
+	// Textures are only sampled by the modes that read them
+	switch (shadingMode)
+	{
+	case RenderConfig::SHADING_MODE::OBSERVED_AREA:
+	{
+		return { lambertCosine, lambertCosine, lambertCosine };
+	}
+	break;
+	case RenderConfig::SHADING_MODE::DIFFUSE:
+	{
+		// Sample color
+		const ColorRGB color = m_pCurrentMeshData->textures[0]->Sample(vertex.uv);
+
+		ColorRGB pointIrradiance{}, pointSpecular{};
+		ShadePointLights(vertex, normal, 0.f, false, pointIrradiance, pointSpecular);
+
+		const ColorRGB diffuse = Shading::Lambert(1.f, color);
+		return light * diffuse * lambertCosine + diffuse * pointIrradiance;
+	}
+	break;
+	case RenderConfig::SHADING_MODE::SPECULAR:
+	{
+		// Sample specular and glossiness
+		const ColorRGB specularColor = m_pCurrentMeshData->textures[2]->Sample(vertex.uv);
+		const ColorRGB glossinessColor = m_pCurrentMeshData->textures[3]->Sample(vertex.uv);
+
+		const auto specularReflectance = specularColor;
+		const auto phongExponent = glossinessColor * Shading::Shininess;
+
+		ColorRGB pointIrradiance{}, pointSpecular{};
+		ShadePointLights(vertex, normal, phongExponent.r, true, pointIrradiance, pointSpecular);
+
+		if (lambertCosine <= 0)
+		{
+			return specularReflectance * pointSpecular;
+		}
+
+		const ColorRGB specular = Shading::Phong(
+			specularReflectance,
+			phongExponent,
+			lightDirection,
+			vertex.viewDirection,
+			vertex.normal,
+			isFastMath
+		);
+
+		return specular + specularReflectance * pointSpecular;
+	}
+
+	break;
+	case RenderConfig::SHADING_MODE::COMBINED:
+	{
+		const ColorRGB color = m_pCurrentMeshData->textures[0]->Sample(vertex.uv);
+		const ColorRGB specularColor = m_pCurrentMeshData->textures[2]->Sample(vertex.uv);
+		const ColorRGB glossinessColor = m_pCurrentMeshData->textures[3]->Sample(vertex.uv);
+
+		ColorRGB pointIrradiance{}, pointSpecular{};
+		ShadePointLights(vertex, normal, glossinessColor.r * Shading::Shininess, true, pointIrradiance, pointSpecular);
+
+		// The sky irradiance takes the place of the old constant ambient, lit by the shading normal
+		const ColorRGB ambientIrradiance = m_SkyIrradiance.Evaluate(normal) * GetAmbientOcclusion(vertex);
+
+		return Shading::Combined(color, specularColor, glossinessColor, vertex.viewDirection, vertex.normal, lambertCosine,
+			pointIrradiance + ambientIrradiance, pointSpecular, isFastMath);
+	}
+
+	break;
+	case RenderConfig::SHADING_MODE::PBR:
+		throw std::runtime_error("PBR fragments are shaded in batches, bug in code");
+	case RenderConfig::SHADING_MODE::ENUM_LENGTH:
+		throw std::runtime_error("Unknown mode, bug in code");
+	}
+
+	return { 0,0,0 };
+}
+
+Vector3 CPU_Renderer::GetShadingNormal(const Vertex_Out& vertex) const
+{
+	const bool isFastMath = m_pRasterFrame->isFastMath;
+
+	if (m_pRasterFrame->state.shouldRenderNormalMap && m_pRasterFrame->isNormalMapObjectSpace)
+	{
+		// Baked normals only need the rotation of the mesh, the same for every pixel, like the vertex normals
+		const ColorRGB normalColor = m_pCurrentMeshData->textures[1]->Sample(vertex.normalMapUV);
+
+		const Vector3 normalSample = m_pRasterFrame->state.worldMatrix.TransformVector(2.f * normalColor.r - 1.f, 2.f * normalColor.g - 1.f, 2.f * normalColor.b - 1.f);
+		return isFastMath ? FastMath::Normalized(normalSample) : normalSample.Normalized();
+	}
+
+	if (m_pRasterFrame->state.shouldRenderNormalMap)
+	{
+		// Normal map stuff
+		const Vector3 cross = Vector3::Cross(vertex.normal, vertex.tangent);
+		const Vector3 binormal = isFastMath ? FastMath::Normalized(cross) : cross.Normalized();
+		const Matrix tangentSpaceAxis = Matrix{ vertex.tangent, binormal, vertex.normal, {0,0,0} };
+
+		// Sample normal
+		const ColorRGB normalColor = m_pCurrentMeshData->textures[1]->Sample(vertex.uv);
+
+		Vector3 normalSample = { normalColor.r, normalColor.g, normalColor.b };
+		normalSample = 2.f * normalSample - Vector3{ 1.f, 1.f, 1.f };
+		normalSample = tangentSpaceAxis.TransformPoint(normalSample);
+		return isFastMath ? FastMath::Normalized(normalSample) : normalSample.Normalized();
+	}
+
+	return vertex.normal;
+}
+
+float CPU_Renderer::GetLightVisibility(const Vertex_Out& vertex) const
+{
+	// The fragment position is the pixel it was shaded for, with shading blocks one of the block
+	if (m_pRasterFrame->isShadowRayTraced)
+	{
+		return m_pTracedVisibility->GetLightVisibility(m_TiledLayout.GetIndex(static_cast<int>(vertex.position.x), static_cast<int>(vertex.position.y)));
+	}
+
+	// The bias follows the geometric angle to the light
+	if (m_pRasterFrame->isShadowed)
+	{
+		return m_pRasterFrame->pShadowMap->Sample(vertex.shadowCoord, Vector3::Dot(vertex.normal, -Shading::LightDirection));
+	}
+
+	return 1.f;
+}
+
+float CPU_Renderer::GetAmbientOcclusion(const Vertex_Out& vertex) const
+{
+	if (m_pRasterFrame->ambientOcclusionSampleCount == 0)
+	{
+		return 1.f;
+	}
+
+	return m_pTracedVisibility->GetAmbientOcclusion(m_TiledLayout.GetIndex(static_cast<int>(vertex.position.x), static_cast<int>(vertex.position.y)));
 }
 
+void CPU_Renderer::ShadePointLights(const Vertex_Out& vertex, const Vector3& normal, float phongExponent, bool useSpecular, ColorRGB& irradiance, ColorRGB& specular) const
+{
+	irradiance = {};
+	specular = {};
+
+	if (m_pRasterFrame->pointLightCount == 0)
+	{
+		return;
+	}
+
+	// Only the lights whose sphere reaches the cluster of the fragment, the w of the fragment is its view depth
+	int count{};
+	const int32_t* pIndices = m_pLightGrid->GetClusterLights(static_cast<int>(vertex.position.x), static_cast<int>(vertex.position.y), vertex.position.w, count);
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	PointLightArgs args{ m_pLightGrid->GetPositionX(), m_pLightGrid->GetPositionY(), m_pLightGrid->GetPositionZ(), m_pLightGrid->GetInverseRadiusSquared(),
+		m_pLightGrid->GetColorR(), m_pLightGrid->GetColorG(), m_pLightGrid->GetColorB(), pIndices, count };
+	args.position = vertex.worldPosition;
+	args.normal = normal;
+	args.viewDirection = vertex.viewDirection;
+	args.phongExponent = phongExponent;
+	args.useSpecular = useSpecular;
+	args.isFastMath = m_pRasterFrame->isFastMath;
+
+	SIMD_KERNELS.ShadePointLights(args, irradiance, specular);
+}
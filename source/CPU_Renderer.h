@@ -5,36 +5,298 @@
 #include "Timer.h"
 #include "CPU_Mesh.h"
 #include "Mesh.h"
+#include "StageProfiler.h"
+#include "TiledLayout.h"
+#include "TaskGraph.h"
+#include "SphericalHarmonics.h"
+#include "SimdDispatch.h"
 
 class SDL_Surface;
+class ShadingRateImage;
+class SpatialUpscaler;
+class PostProcessor;
+class DirtyTileMap;
+class TransparencyBuffer;
+class DepthRasterizer;
+class ShadowMap;
+class LightGrid;
+class Bvh;
+class RayTracedVisibility;
+class FrameWorker;
 
 class CPU_Renderer : public BaseRenderer
 {
 public:
-	CPU_Renderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes);
+	CPU_Renderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes, const IrradianceSH& skyIrradiance);
 	virtual ~CPU_Renderer() override;
 
 	virtual void Update(Timer* pTimer) override;
 	virtual void Render() override;
+	virtual bool HasPendingFrames() const override;
 
 private:
+	// m_Width and m_Height hold the internal render resolution, which can be lower than the window
+	int m_WindowWidth{};
+	int m_WindowHeight{};
+	float m_RenderScale{ 1.f };
+
 	SDL_Surface* m_pFrontBuffer{ nullptr };
-	SDL_Surface* m_pBackBuffer{ nullptr };
-	uint32_t* m_pBackBufferPixels{};
 
+	// Color and depth are rendered in tile-major order, the back buffer only gets the linearized result
+	TiledLayout m_TiledLayout{};
+	uint32_t* m_pColorBufferPixels{};
 	float* m_pDepthBufferPixels{};
 
+	// Per tile shading rates for variable rate shading
+	ShadingRateImage* m_pShadingRateImage{};
+
+	SpatialUpscaler* m_pUpscaler{};
+
+	// HDR color target and post chain
+	PostProcessor* m_pPostProcessor{};
+
+	// Weighted blended OIT for the thruster, composited per frame tile
+	TransparencyBuffer* m_pTransparencyBuffer{};
+
+	// Depth-only kernel, resolves visibility before the shading pass
+	DepthRasterizer* m_pDepthRasterizer{};
+
+	// Ambient light of the combined mode, replaces the constant ambient term
+	IrradianceSH m_SkyIrradiance{};
+
+	// Clustered point lights, rebuilt by the frame graph before the tiles shade
+	LightGrid* m_pLightGrid{};
+
+	// Hybrid ray traced shadows and ambient occlusion, traced from the depth prepass against the BVH of the opaque mesh
+	Bvh* m_pBvh{};
+	RayTracedVisibility* m_pTracedVisibility{};
+	// Recorded frames the traced result stayed valid for, the occlusion keeps refining while it grows
+	int m_TracedFrameCount{};
+	bool m_IsRefiningTrace{};
+
+	StageProfiler m_Profiler{ "CPU" };
+	// Reported once when the shadow map stage goes over ShadowMap::BudgetMilliseconds
+	bool m_IsShadowMapOverBudget{ false };
+
 	std::vector<CPU_Mesh*> m_pMeshes{};
 	MeshData* m_pCurrentMeshData{};
 
+	// Everything that decides what the frame looks like, compared against the previous frame.
+	// Also the only config the raster stage reads, the main thread handles keys while the frame is in flight
+	struct FrameState
+	{
+		Matrix worldMatrix{};
+		Matrix transparentWorldMatrix{};
+		Matrix viewMatrix{};
+		Matrix projectionMatrix{};
+		ColorRGB clearColor{};
+		RenderConfig::SHADING_MODE shadingMode{};
+		RenderConfig::CULL_MODE cullMode{};
+		bool shouldRenderNormalMap{};
+		bool shouldRenderDepthBuffer{};
+		bool shouldRenderBoundingBox{};
+		bool shouldUseVariableRateShading{};
+		bool shouldUseHDR{};
+		bool shouldRenderTransparent{};
+		int shadowMapResolution{};
+		int mathQuality{};
+		int pointLightCount{};
+		bool shouldRayTraceShadows{};
+		int ambientOcclusionSampleCount{};
+	};
+
+	// Everything one frame in flight owns. Recorded (vertex stage) on the main thread,
+	// rasterized by the raster worker and presented on the main thread again
+	struct FrameContext
+	{
+		// Output slot in the CPU_Meshes
+		int slot{};
+		uint64_t frameIndex{};
+		uint64_t rasterTicket{};
+		bool isPresented{ true };
+
+		FrameState state{};
+		bool isReused{};
+		bool isHDR{};
+		bool isShadowed{};
+		// Depth-only kernel first, the main pass then only shades the front-most fragments
+		bool isDepthPrepassed{};
+		// MATH_QUALITY::APPROXIMATE, the shading uses FastMath instead of <cmath>
+		bool isFastMath{};
+		// MeshData::isNormalMapObjectSpace, the normal map gets rotated by the world matrix instead of the tangent frame
+		bool isNormalMapObjectSpace{};
+		// Point lights the shading evaluates, 0 for the unlit and debug modes
+		int pointLightCount{};
+		// SHADING_MODE::PBR, the opaque fragments get queued per tile and shaded PbrBatch::Size at a time
+		bool isPbr{};
+		PbrMaterial pbrMaterial{};
+		// Of the vertex stage, the interpolated view direction plus the origin gives the world position back
+		Vector3 cameraOrigin{};
+		VaryingLayout varyingLayout{};
+		CPU_Mesh* pTransparentMesh{};
+
+		DirtyTileMap* pDirtyTiles{};
+		// Directional light shadows, the map renders while the vertex stage runs
+		ShadowMap* pShadowMap{};
+		// Ray traced instead of the shadow map, plus occlusion rays per pixel for the sky light.
+		// tracedFrameIndex counts the earlier frames the result is still valid for, 0 traces everything again
+		bool isShadowRayTraced{};
+		int ambientOcclusionSampleCount{};
+		int tracedFrameIndex{};
+
+		// Holds the result with this content version
+		SDL_Surface* pBackBuffer{};
+		uint64_t backBufferVersion{};
+	};
+
+	// Inclusive pixel rect, empty when min > max
+	struct ScreenRect
+	{
+		int minX{};
+		int minY{};
+		int maxX{ -1 };
+		int maxY{ -1 };
+
+		void Merge(const ScreenRect& other)
+		{
+			if (other.minX > other.maxX || other.minY > other.maxY)
+			{
+				return;
+			}
+
+			if (minX > maxX || minY > maxY)
+			{
+				*this = other;
+				return;
+			}
+
+			minX = std::min(minX, other.minX);
+			minY = std::min(minY, other.minY);
+			maxX = std::max(maxX, other.maxX);
+			maxY = std::max(maxY, other.maxY);
+		}
+	};
+
+	// Pipelined frames, the ring holds as many contexts as the pipeline depth
+	std::vector<FrameContext> m_Frames{};
+	FrameWorker* m_pRasterWorker{};
+	uint64_t m_FrameCount{};
+
+	// Frame the raster worker is on, only used by the raster stage functions
+	FrameContext* m_pRasterFrame{};
+
+	// Bumped by every frame that re-renders, reused frames copy the latest version into their back buffer
+	uint64_t m_ContentVersion{};
+
+	// Incremental rendering, only tiles touched by what changed since the previous recorded frame get re-rendered
+	FrameState m_PreviousFrameState{};
+	ScreenRect m_PreviousMeshBounds{};
+	bool m_HasPreviousFrame{ false };
+
+	// Main thread stages
+	void RecordFrame(FrameContext& frame);
+	void PresentNewestFrame();
+	void VertexTransformationFunction(CPU_Mesh* pMesh, const VaryingLayout& layout, const FrameContext& frame) const; //W2 version
+	VaryingLayout GetVaryingLayout(bool useShadowCoord, bool usePointLights) const;
+	CPU_Mesh* GetTransparentMesh() const;
+
+	FrameState CaptureFrameState() const;
+	bool HasViewChanged(const FrameState& frameState) const;
+	// Neither the geometry, the camera nor what gets traced changed since the previous recorded frame
+	bool CanReuseTracedVisibility(const FrameState& frameState) const;
+	ScreenRect CalculateMeshBounds(CPU_Mesh* pMesh, int slot) const;
+
+	// Raster worker stages
+	void RasterFrame(FrameContext& frame);
 	void RenderFrame();
-	void VertexTransformationFunction() const; //W2 version
-	void RenderTriangle(Vertex_Out v1, Vertex_Out v2, Vertex_Out v3);
+
+	struct TriangleSetup
+	{
+		// Inclusive range of covered sample points
+		int minX{};
+		int minY{};
+		int maxX{};
+		int maxY{};
+
+		// At most 2x2 sample points, handled by RenderSmallTriangle
+		bool isSmall{};
+	};
+
+	// Vertex outputs of one triangle, referencing the compact storage of its CPU_Mesh
+	struct RasterTriangle
+	{
+		const Vector4* pPosition1{};
+		const Vector4* pPosition2{};
+		const Vector4* pPosition3{};
+		const float* pVaryings1{};
+		const float* pVaryings2{};
+		const float* pVaryings3{};
+	};
+
+	// Frame graph of the raster stage: binning tasks sort the triangles into frame tiles, every tile rasterizes
+	// and (LDR) resolves once all bins and the light clusters of its row are complete, the HDR post chain runs
+	// per row of tiles once those are done.
+	// Built with the render targets, every frame reuses it and the bin storage
+	static constexpr int FrameTileSize{ 64 };
+	static constexpr int BinningTaskCount{ 16 };
+	TaskGraph m_FrameGraph{};
+	int m_FrameTilesX{};
+	int m_FrameTilesY{};
+
+	// Triangle indices per binning task and tile, in submission order
+	std::vector<std::vector<uint32_t>> m_OpaqueBins{};
+	std::vector<std::vector<uint32_t>> m_TransparentBins{};
+	// Written by the binning tasks, read by the tiles
+	std::vector<TriangleSetup> m_TriangleSetups{};
+	uint32_t m_AmountOfTriangles{};
+
+	void BuildFrameGraph();
+	void BinTriangles(int binningTask);
+	void BinTransparentTriangles();
+	void PrepareLights();
+	void BuildLightRow(int tileY);
+	void RenderTile(int tileIndex);
+	void BloomTileRow(int tileY);
+	void CompositeTileRow(int tileY);
+	void ClearDirtyTiles(int minX, int minY, int maxX, int maxY);
+
+	RasterTriangle GetRasterTriangle(CPU_Mesh* pMesh, uint32_t index1, uint32_t index2, uint32_t index3, int stride) const;
+	// Triangle number primitive of a triangle list or strip
+	RasterTriangle GetPrimitive(CPU_Mesh* pMesh, uint32_t primitive, int stride) const;
+	bool SetupTriangle(const RasterTriangle& triangle, TriangleSetup& setup) const;
+	void RenderTriangle(const RasterTriangle& triangle, const TriangleSetup& setup);
+	void RenderShadingBlock(const RasterTriangle& triangle, int minX, int minY, int maxX, int maxY);
+	void RenderSmallTriangle(const RasterTriangle& triangle, const TriangleSetup& setup);
+
+	void RenderTransparentTile(int tileIndex, int minX, int minY, int maxX, int maxY);
+	void RenderTransparentTriangle(const RasterTriangle& triangle, const Texture* pTexture, int minX, int minY, int maxX, int maxY);
+	void CompositeTransparency(int minX, int minY, int maxX, int maxY);
+
+	bool IsInsideTriangle(float w0, float w1, float w2) const;
+	bool TestDepth(const RasterTriangle& triangle, int pixelIndex, float& w0, float& w1, float& w2, float& z);
+	ColorRGB ShadeFragment(const RasterTriangle& triangle, int px, int py, float w0, float w1, float w2, float z);
+	Vertex_Out InterpolateFragment(const RasterTriangle& triangle, int px, int py, float w0, float w1, float w2, float z) const;
 	ColorRGB ShadePixel(const Vertex_Out& vertex);
+	// Vertex normal or normal map, normalized
+	Vector3 GetShadingNormal(const Vertex_Out& vertex) const;
+	// Directional light that reaches the fragment, from the traced shadows or the shadow map
+	float GetLightVisibility(const Vertex_Out& vertex) const;
+	// Open fraction of the sky above the fragment, 1 without ray traced ambient occlusion
+	float GetAmbientOcclusion(const Vertex_Out& vertex) const;
+	// Adds the fragment to the PBR batch of the calling thread, its pixels follow with AddPbrPixel
+	void QueuePbrFragment(const RasterTriangle& triangle, int px, int py, float w0, float w1, float w2, float z);
+	void AddPbrPixel(int pixelIndex) const;
+	// Shades the queued fragments and writes them in the order they were queued, so later triangles still win
+	void FlushPbrFragments();
+	// Sums of the clustered point lights at the fragment, see SimdKernels::ShadePointLights
+	void ShadePointLights(const Vertex_Out& vertex, const Vector3& normal, float phongExponent, bool useSpecular, ColorRGB& irradiance, ColorRGB& specular) const;
+	uint32_t PackColor(ColorRGB color) const;
 
 
-	// Creation functions
+	// Creation functions, the render targets may only change while the raster worker is idle
 	void CreateMeshes(std::vector<MeshData*>& pMeshes);
+	void CreateRenderTargets();
+	void DestroyRenderTargets();
 };
 
 
@@ -33,6 +33,10 @@ struct Camera
 	float highSpeedPerSecond{ 40.f };
 	float aspectRatio{};
 
+	// Clip planes of projectionMatrix, the view depth of a fragment lies between them
+	static constexpr float NearPlane{ .1f };
+	static constexpr float FarPlane{ 100.f };
+
 	Matrix invViewMatrix{};
 	Matrix viewMatrix{};
 	Matrix projectionMatrix{};
@@ -51,6 +55,13 @@ struct Camera
 		currentSpeedPerSecond = normalSpeedPerSecond;
 	}
 
+	// Held movement keys keep moving the camera without generating new events
+	bool HasMovementInput() const
+	{
+		const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
+		return pKeyboardState[SDL_SCANCODE_W] || pKeyboardState[SDL_SCANCODE_S] || pKeyboardState[SDL_SCANCODE_A] || pKeyboardState[SDL_SCANCODE_D];
+	}
+
 	void Initialize(float ar, float _fovAngle = 90.f, Vector3 _origin = { 0.f,0.f,0.f })
 	{
 		fovAngle = _fovAngle;
@@ -78,7 +89,8 @@ struct Camera
 			Vector4{origin, 1},
 		};
 
-		viewMatrix = invViewMatrix.Inverse();
+		// The static Inverse keeps invViewMatrix intact, the member one inverts in place
+		viewMatrix = Matrix::Inverse(invViewMatrix);
 
 		//ViewMatrix => Matrix::CreateLookAtLH(...) [not implemented yet]
 		//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixlookatlh
@@ -86,10 +98,7 @@ struct Camera
 
 	void CalculateProjectionMatrix()
 	{
-		constexpr float nearPlane = .1f;
-		constexpr float farPlane = 100.f;
-
-		projectionMatrix = Matrix::CreatePerspectiveFovLH(fov, aspectRatio, nearPlane, farPlane);
+		projectionMatrix = Matrix::CreatePerspectiveFovLH(fov, aspectRatio, NearPlane, FarPlane);
 		//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixperspectivefovlh
 	}
 
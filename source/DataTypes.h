@@ -13,13 +13,88 @@ struct Vertex
 	Vector3 tangent{}; //W4
 };
 
+// GPU vertex of meshes with a baked object space normal map, the coordinates into the map replace the tangent
+struct Vertex_Baked
+{
+	Vector3 position{};
+	Vector2 uv{};
+	Vector3 normal{};
+	Vector2 normalMapUV{};
+};
+
 struct Vertex_Out
 {
 	Vector4 position{};
 	Vector2 uv{};
 	Vector3 normal{};
 	Vector3 tangent{};
+	Vector2 normalMapUV{};
 	Vector3 viewDirection{};
+	Vector3 shadowCoord{};
+	// Only filled when the layout has the view direction
+	Vector3 worldPosition{};
+};
+
+/**
+	* Which Vertex_Out attributes the software vertex stage produces and the
+	* rasterizer interpolates, packed as consecutive floats per vertex.
+	* Offsets are -1 for attributes the current shading mode does not use.
+	*/
+struct VaryingLayout
+{
+	// The tangent and the object space normal map coordinates never come together
+	static constexpr int MaxStride{ 14 };
+
+	int uv{ -1 };
+	int normal{ -1 };
+	int tangent{ -1 };
+	int normalMapUV{ -1 };
+	int viewDirection{ -1 };
+	int shadowCoord{ -1 };
+	int stride{};
+
+	static VaryingLayout Create(bool useUV, bool useNormal, bool useTangent, bool useNormalMapUV, bool useViewDirection, bool useShadowCoord)
+	{
+		VaryingLayout layout{};
+
+		if (useUV)
+		{
+			layout.uv = layout.stride;
+			layout.stride += 2;
+		}
+
+		if (useNormal)
+		{
+			layout.normal = layout.stride;
+			layout.stride += 3;
+		}
+
+		if (useTangent)
+		{
+			layout.tangent = layout.stride;
+			layout.stride += 3;
+		}
+
+		if (useNormalMapUV)
+		{
+			layout.normalMapUV = layout.stride;
+			layout.stride += 2;
+		}
+
+		if (useViewDirection)
+		{
+			layout.viewDirection = layout.stride;
+			layout.stride += 3;
+		}
+
+		if (useShadowCoord)
+		{
+			layout.shadowCoord = layout.stride;
+			layout.stride += 3;
+		}
+
+		return layout;
+	}
 };
 
 enum class PrimitiveTopology
@@ -0,0 +1,113 @@
+#include "pch.h"
+#include "DepthRasterizer.h"
+#include "TiledLayout.h"
+#include "DirtyTileMap.h"
+#include "JobSystem.h"
+#include "SimdDispatch.h"
+
+DepthRasterizer::DepthRasterizer(int width, int height)
+	: m_Width{ width }, m_Height{ height }
+{
+	m_BinsX = (width + BinSize - 1) / BinSize;
+	m_BinsY = (height + BinSize - 1) / BinSize;
+	m_Bins.resize(m_BinsX * m_BinsY);
+}
+
+void DepthRasterizer::Render(const std::vector<Vector4>& positions, const std::vector<uint32_t>& indices, float* pDepthBuffer, const TiledLayout& layout,
+	RenderConfig::CULL_MODE cullMode, const DirtyTileMap* pDirtyTiles)
+{
+	for (std::vector<uint32_t>& bin : m_Bins)
+	{
+		bin.clear();
+	}
+
+	const uint32_t amountOfTriangles = static_cast<uint32_t>(indices.size()) / 3;
+
+	for (uint32_t index{}; index < amountOfTriangles; ++index)
+	{
+		int minX{}, minY{}, maxX{}, maxY{};
+		if (!GetTriangleRect(positions[indices[3 * index]], positions[indices[3 * index + 1]], positions[indices[3 * index + 2]], minX, minY, maxX, maxY))
+		{
+			continue;
+		}
+
+		if (pDirtyTiles && !pDirtyTiles->IsRectDirty(minX, minY, maxX, maxY))
+		{
+			continue;
+		}
+
+		for (int binY{ minY / BinSize }; binY <= maxY / BinSize; ++binY)
+		{
+			for (int binX{ minX / BinSize }; binX <= maxX / BinSize; ++binX)
+			{
+				m_Bins[binY * m_BinsX + binX].push_back(index);
+			}
+		}
+	}
+
+	JOB_SYSTEM->ParallelFor(0, m_BinsX * m_BinsY, [=, this, &positions, &indices, &layout](int binIndex)
+		{
+			const int binMinX = (binIndex % m_BinsX) * BinSize;
+			const int binMinY = (binIndex / m_BinsX) * BinSize;
+			const int binMaxX = std::min(binMinX + BinSize, m_Width) - 1;
+			const int binMaxY = std::min(binMinY + BinSize, m_Height) - 1;
+
+			for (uint32_t index : m_Bins[binIndex])
+			{
+				const Vector4& position1 = positions[indices[3 * index]];
+				const Vector4& position2 = positions[indices[3 * index + 1]];
+				const Vector4& position3 = positions[indices[3 * index + 2]];
+
+				int minX{}, minY{}, maxX{}, maxY{};
+				GetTriangleRect(position1, position2, position3, minX, minY, maxX, maxY);
+
+				RenderTriangle(position1, position2, position3, pDepthBuffer, layout, cullMode, pDirtyTiles,
+					std::max(minX, binMinX), std::max(minY, binMinY), std::min(maxX, binMaxX), std::min(maxY, binMaxY));
+			}
+		}
+	);
+}
+
+bool DepthRasterizer::GetTriangleRect(const Vector4& position1, const Vector4& position2, const Vector4& position3, int& minX, int& minY, int& maxX, int& maxY) const
+{
+	// Same culling as the main pass, triangles with a vertex off screen get dropped
+	if (position1.x < 0 || position2.x < 0 || position3.x < 0
+		|| position1.x > m_Width || position2.x > m_Width || position3.x > m_Width
+		|| position1.y < 0 || position2.y < 0 || position3.y < 0
+		|| position1.y > m_Height || position2.y > m_Height || position3.y > m_Height
+		)
+	{
+		return false;
+	}
+
+	minX = std::max(static_cast<int>(ceilf(std::min(position1.x, std::min(position2.x, position3.x)))), 0);
+	minY = std::max(static_cast<int>(ceilf(std::min(position1.y, std::min(position2.y, position3.y)))), 0);
+	maxX = std::min(static_cast<int>(std::max(position1.x, std::max(position2.x, position3.x))), m_Width - 1);
+	maxY = std::min(static_cast<int>(std::max(position1.y, std::max(position2.y, position3.y))), m_Height - 1);
+
+	return minX <= maxX && minY <= maxY;
+}
+
+void DepthRasterizer::RenderTriangle(const Vector4& position1, const Vector4& position2, const Vector4& position3, float* pDepthBuffer, const TiledLayout& layout,
+	RenderConfig::CULL_MODE cullMode, const DirtyTileMap* pDirtyTiles, int minX, int minY, int maxX, int maxY) const
+{
+	// The kernel works on whole tiles of the layout, their depths are contiguous
+	static_assert(TiledLayout::TileSize == 8);
+
+	const DepthTriangle triangle{ position1, position2, position3, cullMode };
+	const SimdKernels& kernels = SIMD_KERNELS;
+
+	for (int tileY{ minY & ~(TiledLayout::TileSize - 1) }; tileY <= maxY; tileY += TiledLayout::TileSize)
+	{
+		for (int tileX{ minX & ~(TiledLayout::TileSize - 1) }; tileX <= maxX; tileX += TiledLayout::TileSize)
+		{
+			// Layout tiles never straddle dirty tiles
+			if (pDirtyTiles && !pDirtyTiles->IsTileDirty(tileX, tileY))
+			{
+				continue;
+			}
+
+			kernels.RasterDepthTile(triangle, tileX, tileY, minX, minY, maxX, maxY, pDepthBuffer + layout.GetIndex(tileX, tileY));
+		}
+	}
+}
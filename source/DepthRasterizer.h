@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Vector2.h"
+#include "Vector4.h"
+#include "RenderConfig.h"
+
+class TiledLayout;
+class DirtyTileMap;
+
+/**
+	* Depth-only triangle rasterizer, used for the depth prepass of the software
+	* rasterizer and for shadow maps. It only reads raster positions (no varyings,
+	* no shading) and tests and writes a whole 8x8 layout tile per kernel call,
+	* as many depth samples at a time as the SimdDispatch level allows.
+	* Triangles get binned into screen areas first, so every worker owns its
+	* pixels and the depth writes need no locking. Coverage, culling and depth
+	* math match the main pass, so a prepassed depth buffer holds exactly the
+	* depth the front-most fragment of the main pass computes.
+	*/
+class DepthRasterizer
+{
+public:
+	static constexpr int BinSize{ 64 };
+
+	DepthRasterizer(int width, int height);
+
+	// Positions are in raster space with the depth in z, the depth buffer uses a TiledLayout of the same size
+	void Render(const std::vector<Vector4>& positions, const std::vector<uint32_t>& indices, float* pDepthBuffer, const TiledLayout& layout,
+		RenderConfig::CULL_MODE cullMode, const DirtyTileMap* pDirtyTiles = nullptr);
+
+	// One triangle, only the sample points inside the inclusive pixel rect. For callers that bin the triangles themselves
+	void RenderTriangle(const Vector4& position1, const Vector4& position2, const Vector4& position3, float* pDepthBuffer, const TiledLayout& layout,
+		RenderConfig::CULL_MODE cullMode, const DirtyTileMap* pDirtyTiles, int minX, int minY, int maxX, int maxY) const;
+
+	// Depth math of the main pass. RasterDepthTile repeats these operations in the same order,
+	// SimdDispatch::Validate checks that both give the same bits
+
+	static float EdgeFunction(const Vector2& a, const Vector2& b, const Vector2& c)
+	{
+		// point to side => c - a
+		// side to end => b - a
+		return Vector2::Cross(b - a, c - a);
+	}
+
+	static bool IsCovered(RenderConfig::CULL_MODE cullMode, float w0, float w1, float w2)
+	{
+		switch (cullMode)
+		{
+		case RenderConfig::CULL_MODE::BACK:
+			return w0 >= 0 && w1 >= 0 && w2 >= 0;
+		case RenderConfig::CULL_MODE::FRONT:
+			return w0 < 0 && w1 < 0 && w2 < 0;
+		case RenderConfig::CULL_MODE::NONE:
+			return (w0 >= 0 && w1 >= 0 && w2 >= 0) || (w0 <= 0 && w1 <= 0 && w2 <= 0);
+		default:
+			return false;
+		}
+	}
+
+	// Normalizes the barycentric weights, the depth is interpolated perspective correct
+	static float InterpolateDepth(float& w0, float& w1, float& w2, float z1, float z2, float z3)
+	{
+		const float area = w0 + w1 + w2;
+		w0 /= area;
+		w1 /= area;
+		w2 /= area;
+
+		return 1.f / ((w0 / z1) + (w1 / z2) + (w2 / z3));
+	}
+
+private:
+	int m_Width{};
+	int m_Height{};
+
+	int m_BinsX{};
+	int m_BinsY{};
+	std::vector<std::vector<uint32_t>> m_Bins{};
+
+	// Inclusive pixel rect of the covered sample points, false if the triangle gets culled
+	bool GetTriangleRect(const Vector4& position1, const Vector4& position2, const Vector4& position3, int& minX, int& minY, int& maxX, int& maxY) const;
+};
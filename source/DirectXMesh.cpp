@@ -7,16 +7,30 @@ DirectXMesh::DirectXMesh(ID3D11Device* pDevice, BaseEffect* effect, MeshData* me
 	m_pEffect = effect;
 	m_pEffectTechnique = m_pEffect->GetTechnique();
 
+	// A baked object space normal map needs no tangents, its coordinates go in their place
+	std::vector<Vertex_Baked> bakedVertices{};
+	if (meshData->isNormalMapObjectSpace)
+	{
+		bakedVertices.reserve(meshData->vertices.size());
+		for (size_t index{}; index < meshData->vertices.size(); ++index)
+		{
+			const Vertex& vertex = meshData->vertices[index];
+			bakedVertices.push_back({ vertex.position, vertex.uv, vertex.normal, meshData->normalMapUV[index] });
+		}
+	}
+
+	m_VertexStride = meshData->isNormalMapObjectSpace ? sizeof(Vertex_Baked) : sizeof(Vertex);
+
 	// Create vertex buffer
 	D3D11_BUFFER_DESC bd{};
 	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(meshData->vertices.size());
+	bd.ByteWidth = m_VertexStride * static_cast<uint32_t>(meshData->vertices.size());
 	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bd.CPUAccessFlags = 0;
 	bd.MiscFlags = 0;
 
 	D3D11_SUBRESOURCE_DATA initData{};
-	initData.pSysMem = meshData->vertices.data();
+	initData.pSysMem = meshData->isNormalMapObjectSpace ? static_cast<const void*>(bakedVertices.data()) : meshData->vertices.data();
 
 	HRESULT result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
 	if (FAILED(result))
@@ -62,7 +76,7 @@ void DirectXMesh::Render(ID3D11DeviceContext* pDeviceContext, Matrix& wvp) const
 	pDeviceContext->IASetInputLayout(m_pEffect->GetInputLayout());
 
 	// Set vertex buffer
-	const UINT stride = sizeof(Vertex);
+	const UINT stride = m_VertexStride;
 	const UINT offset = 0;
 	ID3D11Buffer* pVertexBuffer = m_pVertexBuffer;
 
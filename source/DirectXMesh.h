@@ -48,5 +48,6 @@ private:
 
 
 	uint32_t m_NumIndices{};
+	uint32_t m_VertexStride{};
 };
 
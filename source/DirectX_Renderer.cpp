@@ -261,7 +261,7 @@ HRESULT DirectX_Renderer::InitializeDirectX()
 
 void DirectX_Renderer::CreateMeshes(std::vector<MeshData*>& pMeshes)
 {
-	VehicleEffect* effect = new VehicleEffect(m_pDevice, std::wstring{ L"Resources/PosCol3D.fx" });
+	VehicleEffect* effect = new VehicleEffect(m_pDevice, std::wstring{ L"Resources/PosCol3D.fx" }, pMeshes[0]->isNormalMapObjectSpace);
 	m_pMeshes.push_back(new DirectXMesh(m_pDevice, effect, pMeshes[0]));
 
 	ThrusterEffect* thrusterEffect = new ThrusterEffect(m_pDevice, std::wstring{ L"Resources/Thruster.fx" });
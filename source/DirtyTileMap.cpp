@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "DirtyTileMap.h"
+
+DirtyTileMap::DirtyTileMap(int width, int height)
+	: m_Width{ width }, m_Height{ height }
+{
+	m_TilesX = (width + TileSize - 1) / TileSize;
+	m_TilesY = (height + TileSize - 1) / TileSize;
+
+	m_Tiles.resize(m_TilesX * m_TilesY);
+	MarkAll();
+}
+
+void DirtyTileMap::MarkAll()
+{
+	std::fill(m_Tiles.begin(), m_Tiles.end(), uint8_t{ 1 });
+	m_DirtyTileCount = static_cast<int>(m_Tiles.size());
+}
+
+void DirtyTileMap::MarkRect(int minX, int minY, int maxX, int maxY)
+{
+	minX = std::max(minX, 0);
+	minY = std::max(minY, 0);
+	maxX = std::min(maxX, m_Width - 1);
+	maxY = std::min(maxY, m_Height - 1);
+
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	for (int tileY{ minY / TileSize }; tileY <= maxY / TileSize; ++tileY)
+	{
+		for (int tileX{ minX / TileSize }; tileX <= maxX / TileSize; ++tileX)
+		{
+			uint8_t& tile = m_Tiles[tileY * m_TilesX + tileX];
+			if (tile == 0)
+			{
+				tile = 1;
+				++m_DirtyTileCount;
+			}
+		}
+	}
+}
+
+void DirtyTileMap::Reset()
+{
+	std::fill(m_Tiles.begin(), m_Tiles.end(), uint8_t{ 0 });
+	m_DirtyTileCount = 0;
+}
+
+bool DirtyTileMap::IsRectDirty(int minX, int minY, int maxX, int maxY) const
+{
+	if (IsAllDirty())
+	{
+		return true;
+	}
+
+	for (int tileY{ minY / TileSize }; tileY <= maxY / TileSize; ++tileY)
+	{
+		for (int tileX{ minX / TileSize }; tileX <= maxX / TileSize; ++tileX)
+		{
+			if (m_Tiles[tileY * m_TilesX + tileX] != 0)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+	* Screen tiles that have to be re-rendered this frame.
+	* Tiles that are not marked keep their color and depth from the previous frame.
+	*/
+class DirtyTileMap
+{
+public:
+	static constexpr int TileSize{ 32 };
+
+	DirtyTileMap(int width, int height);
+
+	void MarkAll();
+	// Inclusive pixel rect, clamped to the screen
+	void MarkRect(int minX, int minY, int maxX, int maxY);
+	void Reset();
+
+	bool IsAllDirty() const { return m_DirtyTileCount == static_cast<int>(m_Tiles.size()); };
+	bool IsAnyDirty() const { return m_DirtyTileCount > 0; };
+	int GetDirtyTileCount() const { return m_DirtyTileCount; };
+	int GetTileCount() const { return static_cast<int>(m_Tiles.size()); };
+
+	bool IsTileDirty(int px, int py) const
+	{
+		return m_Tiles[(py / TileSize) * m_TilesX + (px / TileSize)] != 0;
+	}
+
+	// True if any tile overlapping the inclusive pixel rect is dirty
+	bool IsRectDirty(int minX, int minY, int maxX, int maxY) const;
+
+	// Calls function(minX, minY, maxX, maxY) with the inclusive pixel rect of every dirty tile
+	template<typename Function>
+	void ForEachDirtyTile(Function function) const
+	{
+		for (int tileY{}; tileY < m_TilesY; ++tileY)
+		{
+			for (int tileX{}; tileX < m_TilesX; ++tileX)
+			{
+				if (m_Tiles[tileY * m_TilesX + tileX] == 0)
+				{
+					continue;
+				}
+
+				const int minX = tileX * TileSize;
+				const int minY = tileY * TileSize;
+				function(minX, minY, std::min(minX + TileSize, m_Width) - 1, std::min(minY + TileSize, m_Height) - 1);
+			}
+		}
+	}
+
+private:
+	int m_Width{};
+	int m_Height{};
+	int m_TilesX{};
+	int m_TilesY{};
+	int m_DirtyTileCount{};
+
+	std::vector<uint8_t> m_Tiles{};
+};
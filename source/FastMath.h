@@ -0,0 +1,95 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include "MathHelpers.h"
+#include "Vector3.h"
+
+/**
+	* Approximate math for the per-pixel shading paths. Every primitive has an error
+	* budget against the exact <cmath> version over its documented input range, so a
+	* caller can tell whether it is good enough. The budgets leave room for the
+	* estimate instructions of other CPUs, the measured maximum on x64 is noted too.
+	* The wide (SIMD) forms with the same algorithms and coefficients live at the end
+	* of SimdWide.h, SimdDispatch::Validate checks them against the same budgets.
+	*/
+namespace FastMath
+{
+	// Relative error, for normal x > 0, measured 2.8e-7
+	// The hardware estimate has at least 12 bits, one Newton-Raphson step roughly doubles that
+	constexpr float RsqrtMaxError{ 4e-7f };
+	inline float Rsqrt(float x) noexcept
+	{
+#if defined(MATH_SSE)
+		const float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+		// The bit trick guess only has about 4 bits, two extra steps bring it in line with the estimate
+		float y = std::bit_cast<float>(0x5F375A86 - (std::bit_cast<int32_t>(x) >> 1));
+		y = y * (1.5f - 0.5f * x * y * y);
+		y = y * (1.5f - 0.5f * x * y * y);
+#endif
+		return y * (1.5f - 0.5f * x * y * y);
+	}
+
+	// Relative error, for normal x whose reciprocal is normal too, measured 2.1e-7
+	constexpr float ReciprocalMaxError{ 3e-7f };
+	inline float Reciprocal(float x) noexcept
+	{
+#if defined(MATH_SSE)
+		const float y = _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(x)));
+#else
+		// The bit trick guess works on the magnitude, the sign goes back on afterwards
+		const int32_t bits = std::bit_cast<int32_t>(x);
+		float y = std::bit_cast<float>((0x7EF311C7 - (bits & 0x7FFFFFFF)) | (bits & static_cast<int32_t>(0x80000000)));
+		y = y * (2.f - x * y);
+		y = y * (2.f - x * y);
+#endif
+		return y * (2.f - x * y);
+	}
+
+	// Relative error, x is clamped to [-126, 127] so the result stays a normal float, measured 2.4e-7
+	constexpr float Exp2MaxError{ 3e-7f };
+	// Splits x into an integer n, written straight into the exponent bits, and f in [-0.5, 0.5] for the polynomial
+	inline float Exp2(float x) noexcept
+	{
+		x = std::min(std::max(x, -126.f), 127.f);
+#if defined(MATH_SSE)
+		// Round to nearest in one instruction, nearbyintf is a library call on most compilers
+		const int32_t n = _mm_cvtss_si32(_mm_set_ss(x));
+#else
+		const int32_t n = static_cast<int32_t>(x + (x < 0.f ? -0.5f : 0.5f));
+#endif
+		const float f = x - static_cast<float>(n);
+
+		const float p = 1.00000008f + f * (0.693147188f + f * (0.240221075f + f * (0.0555035711f + f * (0.00967603192f + f * 0.00133908634f))));
+		return p * std::bit_cast<float>((n + 127) << 23);
+	}
+
+	// Absolute error for x in [0.5, 2] and relative outside of it, for normal x > 0, measured 1.6e-7
+	constexpr float Log2MaxError{ 2e-7f };
+	// Splits x into an exponent e and a mantissa m in [sqrt(0.5), sqrt(2)), so the polynomial in m - 1 stays small around 0
+	inline float Log2(float x) noexcept
+	{
+		const int32_t bits = std::bit_cast<int32_t>(x);
+		const int32_t e = (bits - 0x3F3504F3) >> 23;
+		const float t = std::bit_cast<float>(bits - (e << 23)) - 1.f;
+
+		const float q = 1.44269499f + t * (-0.721352931f + t * (0.480916708f + t * (-0.360225182f + t * (0.287288882f + t * (-0.249271822f + t * (0.232652579f + t * -0.142759734f))))));
+		return static_cast<float>(e) + t * q;
+	}
+
+	// Exp2(y * Log2(x)), for x >= 0
+	// The Log2 error gets scaled by y, the relative error stays below PowMaxError * (1 + |y * log2(x)|), measured 2.3e-7
+	// For Phong exponents up to 256 that is about 2e-5, far below what an 8 bit color channel shows
+	constexpr float PowMaxError{ 3e-7f };
+	inline float Pow(float x, float y) noexcept
+	{
+		if (x <= 0.f) return 0.f;
+		return Exp2(y * Log2(x));
+	}
+
+	// Normalized() with Rsqrt instead of sqrtf and three divisions, within RsqrtMaxError per component
+	inline Vector3 Normalized(const Vector3& v) noexcept
+	{
+		return v * Rsqrt(Vector3::Dot(v, v));
+	}
+}
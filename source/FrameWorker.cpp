@@ -0,0 +1,83 @@
+#include "pch.h"
+#include "FrameWorker.h"
+
+FrameWorker::FrameWorker()
+{
+	m_Thread = std::thread{ &FrameWorker::Run, this };
+}
+
+FrameWorker::~FrameWorker()
+{
+	// Jobs reference their owner, so everything submitted still runs before the thread stops
+	WaitUntilIdle();
+
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+
+	m_JobSubmitted.notify_one();
+	m_Thread.join();
+}
+
+uint64_t FrameWorker::Submit(std::function<void()> job)
+{
+	uint64_t ticket{};
+
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_Jobs.push_back(std::move(job));
+		ticket = ++m_SubmittedCount;
+	}
+
+	m_JobSubmitted.notify_one();
+	return ticket;
+}
+
+bool FrameWorker::IsCompleted(uint64_t ticket) const
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+	return m_CompletedCount >= ticket;
+}
+
+void FrameWorker::Wait(uint64_t ticket)
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	m_JobCompleted.wait(lock, [this, ticket]() { return m_CompletedCount >= ticket; });
+}
+
+void FrameWorker::WaitUntilIdle()
+{
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	m_JobCompleted.wait(lock, [this]() { return m_CompletedCount == m_SubmittedCount; });
+}
+
+void FrameWorker::Run()
+{
+	while (true)
+	{
+		std::function<void()> job{};
+
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			m_JobSubmitted.wait(lock, [this]() { return m_IsStopping || !m_Jobs.empty(); });
+
+			if (m_Jobs.empty())
+			{
+				return;
+			}
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			++m_CompletedCount;
+		}
+
+		m_JobCompleted.notify_all();
+	}
+}
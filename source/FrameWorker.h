@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/**
+	* One background thread that runs submitted jobs in submission order.
+	* Every job gets a ticket, so the owner can wait for one specific job
+	* (and everything submitted before it) without draining the whole queue.
+	* Ticket 0 stands for "nothing submitted" and always counts as completed.
+	*/
+class FrameWorker
+{
+public:
+	FrameWorker();
+	~FrameWorker();
+
+	FrameWorker(const FrameWorker&) = delete;
+	FrameWorker(FrameWorker&&) noexcept = delete;
+	FrameWorker& operator=(const FrameWorker&) = delete;
+	FrameWorker& operator=(FrameWorker&&) noexcept = delete;
+
+	uint64_t Submit(std::function<void()> job);
+
+	bool IsCompleted(uint64_t ticket) const;
+	void Wait(uint64_t ticket);
+	void WaitUntilIdle();
+
+private:
+	mutable std::mutex m_Mutex{};
+	std::condition_variable m_JobSubmitted{};
+	std::condition_variable m_JobCompleted{};
+
+	std::deque<std::function<void()>> m_Jobs{};
+	uint64_t m_SubmittedCount{};
+	uint64_t m_CompletedCount{};
+	bool m_IsStopping{ false };
+
+	std::thread m_Thread{};
+
+	void Run();
+};
@@ -0,0 +1,196 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+JobSystem* JobSystem::s_Instance{ nullptr };
+
+namespace
+{
+	// Queue index of the calling thread, -1 for threads outside the pool
+	thread_local int t_QueueIndex{ -1 };
+}
+
+JobSystem* JobSystem::GetInstance()
+{
+	if (s_Instance == nullptr)
+	{
+		s_Instance = new JobSystem;
+	}
+
+	return s_Instance;
+}
+
+void JobSystem::DestroyInstance()
+{
+	delete s_Instance;
+	s_Instance = nullptr;
+}
+
+JobSystem::JobSystem()
+{
+	// The threads that wait for their jobs help out, so one core is left for the main thread
+	const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	const int workerCount = hardwareThreads > 1 ? static_cast<int>(hardwareThreads) - 1 : 1;
+
+	for (int index{}; index <= workerCount; ++index)
+	{
+		m_Queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	for (int index{}; index < workerCount; ++index)
+	{
+		m_Workers.emplace_back(&JobSystem::WorkerLoop, this, index);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_SleepMutex };
+		m_IsStopping = true;
+	}
+
+	m_WorkAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+JobSystem::WorkQueue& JobSystem::GetLocalQueue()
+{
+	return t_QueueIndex >= 0 ? *m_Queues[t_QueueIndex] : *m_Queues.back();
+}
+
+void JobSystem::Push(Job job, PRIORITY priority)
+{
+	WorkQueue& queue = GetLocalQueue();
+
+	{
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		queue.jobs[static_cast<int>(priority)].push_back(std::move(job));
+		queue.jobCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	m_QueuedJobCount.fetch_add(1);
+
+	// Taking the lock orders this with a worker that is about to go to sleep
+	{
+		std::lock_guard<std::mutex> lock{ m_SleepMutex };
+	}
+
+	m_WorkAvailable.notify_one();
+}
+
+void JobSystem::Submit(std::function<void()> function, std::atomic<int>& pendingCount, PRIORITY priority)
+{
+	Push(Job{ std::move(function), &pendingCount }, priority);
+}
+
+bool JobSystem::TryPopLocal(Job& job)
+{
+	WorkQueue& queue = GetLocalQueue();
+
+	if (queue.jobCount.load(std::memory_order_relaxed) == 0)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{ queue.mutex };
+
+	for (std::deque<Job>& jobs : queue.jobs)
+	{
+		if (!jobs.empty())
+		{
+			job = std::move(jobs.back());
+			jobs.pop_back();
+			queue.jobCount.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::TrySteal(Job& job)
+{
+	const int queueCount = static_cast<int>(m_Queues.size());
+	const int firstVictim = t_QueueIndex >= 0 ? t_QueueIndex + 1 : 0;
+
+	// High priority work anywhere goes before normal work
+	for (int priority{}; priority < static_cast<int>(PRIORITY::ENUM_LENGTH); ++priority)
+	{
+		for (int offset{}; offset < queueCount; ++offset)
+		{
+			WorkQueue& victim = *m_Queues[(firstVictim + offset) % queueCount];
+
+			if (&victim == &GetLocalQueue() || victim.jobCount.load(std::memory_order_relaxed) == 0)
+			{
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock{ victim.mutex };
+			std::deque<Job>& jobs = victim.jobs[priority];
+
+			if (!jobs.empty())
+			{
+				job = std::move(jobs.front());
+				jobs.pop_front();
+				victim.jobCount.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::RunOne()
+{
+	Job job{};
+
+	if (!TryPopLocal(job) && !TrySteal(job))
+	{
+		return false;
+	}
+
+	m_QueuedJobCount.fetch_sub(1);
+
+	job.function();
+	job.pPendingCount->fetch_sub(1, std::memory_order_release);
+
+	return true;
+}
+
+void JobSystem::Wait(const std::atomic<int>& pendingCount)
+{
+	// Help out instead of blocking, the jobs we wait for may sit in our own queue
+	while (pendingCount.load(std::memory_order_acquire) > 0)
+	{
+		if (!RunOne())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(int queueIndex)
+{
+	t_QueueIndex = queueIndex;
+
+	while (true)
+	{
+		if (RunOne())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{ m_SleepMutex };
+		m_WorkAvailable.wait(lock, [this]() { return m_IsStopping || m_QueuedJobCount.load() > 0; });
+
+		if (m_IsStopping)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,148 @@
+#define JOB_SYSTEM (JobSystem::GetInstance())
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+	* Work-stealing thread pool behind every parallel stage of the software rasterizer.
+	* Every worker owns a deque per priority: it pushes and pops its own jobs at the
+	* back (depth first, cache warm) while idle workers steal from the front of the
+	* others (the biggest pieces of work). Threads outside the pool (main thread,
+	* raster worker) share one queue. A thread that waits for its jobs keeps running
+	* queued jobs meanwhile, so nested ParallelFor calls can not deadlock.
+	* Only uses the standard library, no platform specific APIs.
+	*/
+class JobSystem
+{
+public:
+	enum class PRIORITY
+	{
+		HIGH,
+		NORMAL,
+		ENUM_LENGTH
+	};
+
+	// Singleton getter
+	static JobSystem* GetInstance();
+	static void DestroyInstance();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem(JobSystem&&) noexcept = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	JobSystem& operator=(JobSystem&&) noexcept = delete;
+
+	// Runs function(index) for every index in [begin, end) and returns when all of them are done
+	template<typename Function>
+	void ParallelFor(int begin, int end, const Function& function, PRIORITY priority = PRIORITY::NORMAL);
+
+	// Runs both functions, the second one can get stolen while the calling thread runs the first
+	template<typename Function1, typename Function2>
+	void ParallelInvoke(const Function1& function1, const Function2& function2, PRIORITY priority = PRIORITY::NORMAL);
+
+	// Queues one job, pendingCount gets decremented once it ran. Callers count their jobs in up front
+	void Submit(std::function<void()> function, std::atomic<int>& pendingCount, PRIORITY priority = PRIORITY::NORMAL);
+
+	// Runs queued jobs until pendingCount dropped to zero
+	void Wait(const std::atomic<int>& pendingCount);
+
+	int GetWorkerCount() const { return static_cast<int>(m_Workers.size()); };
+
+private:
+	/************************************************************************/
+	/* Singleton constructor												*/
+	/************************************************************************/
+	JobSystem();
+	~JobSystem();
+
+	static JobSystem* s_Instance;
+
+	struct Job
+	{
+		std::function<void()> function{};
+		std::atomic<int>* pPendingCount{};
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex{};
+		std::deque<Job> jobs[static_cast<int>(PRIORITY::ENUM_LENGTH)]{};
+		std::atomic<int> jobCount{};
+	};
+
+	std::vector<std::thread> m_Workers{};
+	// One per worker plus the shared one of the threads outside the pool (last)
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues{};
+
+	std::atomic<int> m_QueuedJobCount{};
+	std::atomic<bool> m_IsStopping{ false };
+	std::mutex m_SleepMutex{};
+	std::condition_variable m_WorkAvailable{};
+
+	WorkQueue& GetLocalQueue();
+	void Push(Job job, PRIORITY priority);
+	bool TryPopLocal(Job& job);
+	bool TrySteal(Job& job);
+	bool RunOne();
+	void WorkerLoop(int queueIndex);
+
+	// Lazy splitting: only fork while the local queue ran dry, so the grain adapts to how busy the pool is
+	bool IsLocalQueueHungry() { return !m_Workers.empty() && GetLocalQueue().jobCount.load(std::memory_order_relaxed) == 0; };
+
+	template<typename Function>
+	void ForRange(int begin, int end, const Function& function, PRIORITY priority, std::atomic<int>& pendingCount);
+};
+
+template<typename Function>
+void JobSystem::ParallelFor(int begin, int end, const Function& function, PRIORITY priority)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	std::atomic<int> pendingCount{ 0 };
+	ForRange(begin, end, function, priority, pendingCount);
+	Wait(pendingCount);
+}
+
+template<typename Function>
+void JobSystem::ForRange(int begin, int end, const Function& function, PRIORITY priority, std::atomic<int>& pendingCount)
+{
+	while (begin < end)
+	{
+		// Hand the upper half to whoever is idle, keep going on the lower half
+		if (end - begin > 1 && IsLocalQueueHungry())
+		{
+			const int middle = begin + (end - begin) / 2;
+
+			pendingCount.fetch_add(1, std::memory_order_relaxed);
+			Push(Job{ [this, middle, end, &function, priority, &pendingCount]()
+				{
+					ForRange(middle, end, function, priority, pendingCount);
+				}, &pendingCount }, priority);
+
+			end = middle;
+			continue;
+		}
+
+		function(begin);
+		++begin;
+	}
+}
+
+template<typename Function1, typename Function2>
+void JobSystem::ParallelInvoke(const Function1& function1, const Function2& function2, PRIORITY priority)
+{
+	std::atomic<int> pendingCount{ 1 };
+	Push(Job{ [&function2]() { function2(); }, &pendingCount }, priority);
+
+	function1();
+	Wait(pendingCount);
+}
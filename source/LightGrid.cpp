@@ -0,0 +1,220 @@
+#include "pch.h"
+#include "LightGrid.h"
+
+LightGrid::LightGrid(int width, int height)
+	: m_Width{ width }
+	, m_Height{ height }
+	, m_TilesX{ (width + TileSize - 1) / TileSize }
+	, m_TilesY{ (height + TileSize - 1) / TileSize }
+{
+	m_TileEdgesX.resize(m_TilesX + 1);
+	m_TileEdgesY.resize(m_TilesY + 1);
+	m_ClusterOffsets.resize(m_TilesX * m_TilesY * DepthSlices);
+	m_ClusterCounts.resize(m_TilesX * m_TilesY * DepthSlices);
+	m_RowIndices.resize(m_TilesY);
+}
+
+void LightGrid::SetLights(const std::vector<PointLight>& lights)
+{
+	const size_t count = lights.size();
+	m_PositionX.resize(count);
+	m_PositionY.resize(count);
+	m_PositionZ.resize(count);
+	m_Radius.resize(count);
+	m_InverseRadiusSquared.resize(count);
+	m_ColorR.resize(count);
+	m_ColorG.resize(count);
+	m_ColorB.resize(count);
+	m_Bounds.resize(count);
+
+	for (size_t index{}; index < count; ++index)
+	{
+		const PointLight& light = lights[index];
+		m_PositionX[index] = light.position.x;
+		m_PositionY[index] = light.position.y;
+		m_PositionZ[index] = light.position.z;
+		m_Radius[index] = light.radius;
+		m_InverseRadiusSquared[index] = 1.f / (light.radius * light.radius);
+		m_ColorR[index] = light.color.r;
+		m_ColorG[index] = light.color.g;
+		m_ColorB[index] = light.color.b;
+	}
+}
+
+void LightGrid::Prepare(const Matrix& viewMatrix, const Matrix& projectionMatrix, float nearPlane, float farPlane)
+{
+	// The projection has no offsets, so view x / z maps linearly to NDC
+	const float scaleX = projectionMatrix[0].x;
+	const float scaleY = projectionMatrix[1].y;
+
+	for (int tileX{}; tileX <= m_TilesX; ++tileX)
+	{
+		const float px = static_cast<float>(std::min(tileX * TileSize, m_Width));
+		m_TileEdgesX[tileX] = (2.f * px / m_Width - 1.f) / scaleX;
+	}
+
+	// Raster y points down, so the edges get smaller with every row
+	for (int tileY{}; tileY <= m_TilesY; ++tileY)
+	{
+		const float py = static_cast<float>(std::min(tileY * TileSize, m_Height));
+		m_TileEdgesY[tileY] = (1.f - 2.f * py / m_Height) / scaleY;
+	}
+
+	m_SliceScale = DepthSlices / logf(farPlane / nearPlane);
+	m_SliceBias = -logf(nearPlane) * m_SliceScale;
+	for (int slice{}; slice <= DepthSlices; ++slice)
+	{
+		m_SliceDepths[slice] = nearPlane * powf(farPlane / nearPlane, static_cast<float>(slice) / DepthSlices);
+	}
+
+	for (size_t index{}; index < m_Bounds.size(); ++index)
+	{
+		LightBounds& bounds = m_Bounds[index];
+		bounds = LightBounds{};
+		bounds.viewPosition = viewMatrix.TransformPoint(m_PositionX[index], m_PositionY[index], m_PositionZ[index]);
+
+		const Vector3& center = bounds.viewPosition;
+		const float radius = m_Radius[index];
+		const float minDepth = center.z - radius;
+		const float maxDepth = center.z + radius;
+
+		// Outside of the depth range, the bounds stay empty
+		if (maxDepth < nearPlane || minDepth > farPlane)
+		{
+			continue;
+		}
+
+		bounds.minSlice = GetSlice(minDepth);
+		bounds.maxSlice = GetSlice(maxDepth);
+
+		// Crossing the near plane the projected sphere can cover any part of the screen
+		if (minDepth <= nearPlane)
+		{
+			bounds.maxTileX = m_TilesX - 1;
+			bounds.maxTileY = m_TilesY - 1;
+			continue;
+		}
+
+		// x / z and y / z of the bounding box peak at its corners
+		const float minRatioX = std::min((center.x - radius) / minDepth, (center.x - radius) / maxDepth);
+		const float maxRatioX = std::max((center.x + radius) / minDepth, (center.x + radius) / maxDepth);
+		const float minRatioY = std::min((center.y - radius) / minDepth, (center.y - radius) / maxDepth);
+		const float maxRatioY = std::max((center.y + radius) / minDepth, (center.y + radius) / maxDepth);
+
+		const float minX = (minRatioX * scaleX + 1.f) * 0.5f * m_Width;
+		const float maxX = (maxRatioX * scaleX + 1.f) * 0.5f * m_Width;
+		const float minY = (1.f - maxRatioY * scaleY) * 0.5f * m_Height;
+		const float maxY = (1.f - minRatioY * scaleY) * 0.5f * m_Height;
+
+		if (maxX < 0.f || maxY < 0.f || minX >= m_Width || minY >= m_Height)
+		{
+			continue;
+		}
+
+		bounds.minTileX = std::max(static_cast<int>(minX) / TileSize, 0);
+		bounds.minTileY = std::max(static_cast<int>(minY) / TileSize, 0);
+		bounds.maxTileX = std::min(static_cast<int>(maxX) / TileSize, m_TilesX - 1);
+		bounds.maxTileY = std::min(static_cast<int>(maxY) / TileSize, m_TilesY - 1);
+	}
+}
+
+void LightGrid::BuildRows(int minTileY, int maxTileY)
+{
+	for (int tileY{ minTileY }; tileY <= maxTileY; ++tileY)
+	{
+		const int firstCluster = tileY * m_TilesX * DepthSlices;
+		const int clusterCount = m_TilesX * DepthSlices;
+		int32_t* pCounts = m_ClusterCounts.data() + firstCluster;
+		int32_t* pOffsets = m_ClusterOffsets.data() + firstCluster;
+		std::fill(pCounts, pCounts + clusterCount, 0);
+
+		// Count, prefix sum and fill, so the indices of a cluster are contiguous and the row reuses its storage
+		for (size_t light{}; light < m_Bounds.size(); ++light)
+		{
+			const LightBounds& bounds = m_Bounds[light];
+			if (tileY < bounds.minTileY || tileY > bounds.maxTileY)
+			{
+				continue;
+			}
+
+			for (int tileX{ bounds.minTileX }; tileX <= bounds.maxTileX; ++tileX)
+			{
+				for (int slice{ bounds.minSlice }; slice <= bounds.maxSlice; ++slice)
+				{
+					pCounts[tileX * DepthSlices + slice] += IsInCluster(bounds, m_Radius[light], tileX, tileY, slice);
+				}
+			}
+		}
+
+		int32_t offset{};
+		for (int cluster{}; cluster < clusterCount; ++cluster)
+		{
+			pOffsets[cluster] = offset;
+			offset += pCounts[cluster];
+			pCounts[cluster] = 0;
+		}
+
+		std::vector<int32_t>& indices = m_RowIndices[tileY];
+		indices.resize(offset);
+
+		for (size_t light{}; light < m_Bounds.size(); ++light)
+		{
+			const LightBounds& bounds = m_Bounds[light];
+			if (tileY < bounds.minTileY || tileY > bounds.maxTileY)
+			{
+				continue;
+			}
+
+			for (int tileX{ bounds.minTileX }; tileX <= bounds.maxTileX; ++tileX)
+			{
+				for (int slice{ bounds.minSlice }; slice <= bounds.maxSlice; ++slice)
+				{
+					if (IsInCluster(bounds, m_Radius[light], tileX, tileY, slice))
+					{
+						const int cluster = tileX * DepthSlices + slice;
+						indices[pOffsets[cluster] + pCounts[cluster]++] = static_cast<int32_t>(light);
+					}
+				}
+			}
+		}
+	}
+}
+
+const int32_t* LightGrid::GetClusterLights(int px, int py, float viewDepth, int& count) const
+{
+	const int tileX = std::clamp(px / TileSize, 0, m_TilesX - 1);
+	const int tileY = std::clamp(py / TileSize, 0, m_TilesY - 1);
+	const int cluster = (tileY * m_TilesX + tileX) * DepthSlices + GetSlice(viewDepth);
+
+	count = m_ClusterCounts[cluster];
+	return m_RowIndices[tileY].data() + m_ClusterOffsets[cluster];
+}
+
+int LightGrid::GetSlice(float viewDepth) const
+{
+	if (viewDepth <= m_SliceDepths[0])
+	{
+		return 0;
+	}
+
+	return std::min(static_cast<int>(logf(viewDepth) * m_SliceScale + m_SliceBias), DepthSlices - 1);
+}
+
+bool LightGrid::IsInCluster(const LightBounds& bounds, float radius, int tileX, int tileY, int slice) const
+{
+	// View space box of the cluster, the tile edges scale with the depth
+	const float nearDepth = m_SliceDepths[slice];
+	const float farDepth = m_SliceDepths[slice + 1];
+
+	const float minX = std::min(m_TileEdgesX[tileX] * nearDepth, m_TileEdgesX[tileX] * farDepth);
+	const float maxX = std::max(m_TileEdgesX[tileX + 1] * nearDepth, m_TileEdgesX[tileX + 1] * farDepth);
+	const float minY = std::min(m_TileEdgesY[tileY + 1] * nearDepth, m_TileEdgesY[tileY + 1] * farDepth);
+	const float maxY = std::max(m_TileEdgesY[tileY] * nearDepth, m_TileEdgesY[tileY] * farDepth);
+
+	const Vector3& center = bounds.viewPosition;
+	const float distanceX = center.x - std::clamp(center.x, minX, maxX);
+	const float distanceY = center.y - std::clamp(center.y, minY, maxY);
+	const float distanceZ = center.z - std::clamp(center.z, nearDepth, farDepth);
+
+	return distanceX * distanceX + distanceY * distanceY + distanceZ * distanceZ <= radius * radius;
+}
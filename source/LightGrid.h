@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Math.h"
+#include "ColorRGB.h"
+
+struct PointLight
+{
+	Vector3 position{};
+	// Contribution fades to 0 at the radius
+	float radius{ 1.f };
+	ColorRGB color{};
+};
+
+/**
+	* Clustered light culling of the software rasterizer. The screen gets split in
+	* TileSize pixel tiles and every tile in DepthSlices slices of view depth,
+	* exponentially spaced between the camera planes so near clusters stay small.
+	* Each frame the lights get bounded once (Prepare), then every row of tiles
+	* collects the lights whose sphere touches its clusters (BuildRows), so the rows
+	* can be built in parallel. A fragment only evaluates the lights of its cluster,
+	* the cost follows how many lights overlap it rather than how many exist.
+	* Lights are stored as structure of arrays for SimdKernels::ShadePointLights.
+	*/
+class LightGrid
+{
+public:
+	static constexpr int TileSize{ 16 };
+	static constexpr int DepthSlices{ 16 };
+
+	LightGrid(int width, int height);
+
+	void SetLights(const std::vector<PointLight>& lights);
+	int GetLightCount() const { return static_cast<int>(m_PositionX.size()); };
+
+	// Bounds of every light in tiles and slices, call before BuildRows
+	void Prepare(const Matrix& viewMatrix, const Matrix& projectionMatrix, float nearPlane, float farPlane);
+	// Inclusive range of tile rows, different ranges can be built at the same time
+	void BuildRows(int minTileY, int maxTileY);
+
+	int GetTilesY() const { return m_TilesY; };
+
+	// Light indices of the cluster of a pixel, viewDepth is the w of the fragment
+	const int32_t* GetClusterLights(int px, int py, float viewDepth, int& count) const;
+
+	// Structure of arrays, indexed by the cluster light indices
+	const float* GetPositionX() const { return m_PositionX.data(); };
+	const float* GetPositionY() const { return m_PositionY.data(); };
+	const float* GetPositionZ() const { return m_PositionZ.data(); };
+	const float* GetInverseRadiusSquared() const { return m_InverseRadiusSquared.data(); };
+	const float* GetColorR() const { return m_ColorR.data(); };
+	const float* GetColorG() const { return m_ColorG.data(); };
+	const float* GetColorB() const { return m_ColorB.data(); };
+
+private:
+	// Inclusive tile and slice range of a light, empty when minTileX > maxTileX
+	struct LightBounds
+	{
+		Vector3 viewPosition{};
+		int minTileX{};
+		int minTileY{};
+		int maxTileX{ -1 };
+		int maxTileY{ -1 };
+		int minSlice{};
+		int maxSlice{};
+	};
+
+	int m_Width{};
+	int m_Height{};
+	int m_TilesX{};
+	int m_TilesY{};
+
+	std::vector<float> m_PositionX{};
+	std::vector<float> m_PositionY{};
+	std::vector<float> m_PositionZ{};
+	std::vector<float> m_Radius{};
+	std::vector<float> m_InverseRadiusSquared{};
+	std::vector<float> m_ColorR{};
+	std::vector<float> m_ColorG{};
+	std::vector<float> m_ColorB{};
+
+	std::vector<LightBounds> m_Bounds{};
+
+	// Tile corners in view space at depth 1 and the depth range of every slice
+	std::vector<float> m_TileEdgesX{};
+	std::vector<float> m_TileEdgesY{};
+	float m_SliceDepths[DepthSlices + 1]{};
+	float m_SliceScale{};
+	float m_SliceBias{};
+
+	// Per cluster (tile major, slices inner), the offset is into the index list of the tile row
+	std::vector<int32_t> m_ClusterOffsets{};
+	std::vector<int32_t> m_ClusterCounts{};
+	std::vector<std::vector<int32_t>> m_RowIndices{};
+
+	int GetSlice(float viewDepth) const;
+	bool IsInCluster(const LightBounds& bounds, float radius, int tileX, int tileY, int slice) const;
+};
@@ -0,0 +1,415 @@
+#include "pch.h"
+#include "MathBenchmark.h"
+#include "SimdDispatch.h"
+#include "DataTypes.h"
+#include "FastMath.h"
+#include "Shading.h"
+#include "MathCodegen.h"
+#include <random>
+#include <cfloat>
+
+namespace
+{
+	// The scalar Matrix code before the SSE and batched paths, kept as the baseline
+	namespace Reference
+	{
+		Matrix Multiply(const Matrix& m1, const Matrix& m2)
+		{
+			// Matrix::Transpose is SSE and Vector4::Dot inline now, so both are spelled out like they used to be
+			Matrix m2Transposed{};
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					m2Transposed[r][c] = m2[c][r];
+				}
+			}
+
+			Matrix result{};
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					const Vector4& v1 = m1[r];
+					const Vector4& v2 = m2Transposed[c];
+					result[r][c] = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+				}
+			}
+
+			return result;
+		}
+
+		Matrix Inverse(const Matrix& m)
+		{
+			const Vector3 a = m[0];
+			const Vector3 b = m[1];
+			const Vector3 c = m[2];
+			const Vector3 d = m[3];
+
+			const float x = m[0][3];
+			const float y = m[1][3];
+			const float z = m[2][3];
+			const float w = m[3][3];
+
+			Vector3 s = Vector3::Cross(a, b);
+			Vector3 t = Vector3::Cross(c, d);
+			Vector3 u = a * y - b * x;
+			Vector3 v = c * w - d * z;
+
+			const float invDet = 1.f / (Vector3::Dot(s, v) + Vector3::Dot(t, u));
+			s *= invDet; t *= invDet; u *= invDet; v *= invDet;
+
+			const Vector3 r0 = Vector3::Cross(b, v) + t * y;
+			const Vector3 r1 = Vector3::Cross(v, a) - t * x;
+			const Vector3 r2 = Vector3::Cross(d, u) + s * w;
+
+			return {
+				Vector4{ r0.x, r1.x, r2.x, 0.f },
+				Vector4{ r0.y, r1.y, r2.y, 0.f },
+				Vector4{ r0.z, r1.z, r2.z, 0.f },
+				Vector4{ -Vector3::Dot(b, t), Vector3::Dot(a, t), -Vector3::Dot(d, s), Vector3::Dot(c, s) }
+			};
+		}
+
+		// The old per vertex loop of CPU_Mesh::UpdateWorldSpaceVertices
+		void TransformVertices(const Matrix& m, const std::vector<Vertex>& vertices, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<Vector3>& tangents)
+		{
+			const Vector4 row0 = m[0];
+			const Vector4 row1 = m[1];
+			const Vector4 row2 = m[2];
+			const Vector4 row3 = m[3];
+
+			for (size_t index{}; index < vertices.size(); ++index)
+			{
+				const Vertex& vertex = vertices[index];
+				const Vector3& p = vertex.position;
+				const Vector3& n = vertex.normal;
+				const Vector3& t = vertex.tangent;
+
+				positions[index] = Vector3{
+					row0.x * p.x + row1.x * p.y + row2.x * p.z + row3.x,
+					row0.y * p.x + row1.y * p.y + row2.y * p.z + row3.y,
+					row0.z * p.x + row1.z * p.y + row2.z * p.z + row3.z
+				};
+				normals[index] = Vector3{
+					row0.x * n.x + row1.x * n.y + row2.x * n.z,
+					row0.y * n.x + row1.y * n.y + row2.y * n.z,
+					row0.z * n.x + row1.z * n.y + row2.z * n.z
+				}.Normalized();
+				tangents[index] = Vector3{
+					row0.x * t.x + row1.x * t.y + row2.x * t.z,
+					row0.y * t.x + row1.y * t.y + row2.y * t.z,
+					row0.z * t.x + row1.z * t.y + row2.z * t.z
+				}.Normalized();
+			}
+		}
+
+		// The operators as they were in Vector3.cpp, a call each without LTO
+		Vector3 Add(const Vector3& v1, const Vector3& v2) { return v1 + v2; }
+		Vector3 Scale(const Vector3& v, float scale) { return v * scale; }
+		Vector3 Normalized(const Vector3& v) { return v.Normalized(); }
+
+		// Read through volatile, so the optimizer can not see which function gets called and inline it
+		Vector3(* volatile g_pAdd)(const Vector3&, const Vector3&) { &Add };
+		Vector3(* volatile g_pScale)(const Vector3&, float) { &Scale };
+		Vector3(* volatile g_pNormalized)(const Vector3&) { &Normalized };
+
+		// MathCodegen::InterpolateNormals with out of line operators
+		void InterpolateNormals(const Vector3* pA, const Vector3* pB, const Vector3* pC, const float* pW0, const float* pW1, const float* pW2, const float* pW,
+			Vector3* pOut, int count)
+		{
+			const auto pAdd = g_pAdd;
+			const auto pScale = g_pScale;
+			const auto pNormalized = g_pNormalized;
+
+			for (int index{}; index < count; ++index)
+			{
+				const Vector3 normal = pScale(pAdd(pAdd(pScale(pA[index], pW0[index]), pScale(pB[index], pW1[index])), pScale(pC[index], pW2[index])), pW[index]);
+				pOut[index] = pNormalized(normal);
+			}
+		}
+	}
+
+	// Keeps the optimizer from dropping the measured work
+	volatile float g_Sink{};
+
+	// Best of a few runs in nanoseconds per call, the first run also warms the caches
+	template<typename Function>
+	double Measure(int callsPerRun, Function function)
+	{
+		const double nanosecondsPerCount = 1e9 / static_cast<double>(SDL_GetPerformanceFrequency());
+		double best{ DBL_MAX };
+
+		for (int run{}; run < 5; ++run)
+		{
+			const uint64_t start = SDL_GetPerformanceCounter();
+			function();
+			const uint64_t end = SDL_GetPerformanceCounter();
+
+			best = std::min(best, static_cast<double>(end - start) * nanosecondsPerCount / callsPerRun);
+		}
+
+		return best;
+	}
+
+	void Print(const char* pName, double scalarNanoseconds, double simdNanoseconds, const char* pScalarName = "scalar", const char* pSimdName = "SIMD")
+	{
+		std::cout << "\033[36m"; // TEXT COLOR
+		std::cout << "[MATH] " << pName << ": " << pScalarName << " " << scalarNanoseconds << " ns, " << pSimdName << " " << simdNanoseconds << " ns, "
+			<< scalarNanoseconds / simdNanoseconds << "x" << std::endl;
+		std::cout << "\033[37m"; // TEXT COLOR WHITE
+	}
+}
+
+void MathBenchmark::Run()
+{
+	std::mt19937 generator{ 2024 };
+	std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+
+	const Matrix world = Matrix::CreateRotation(0.3f, 1.1f, -0.4f) * Matrix::CreateScale(1.5f, 0.5f, 2.f) * Matrix::CreateTranslation(3.f, -1.f, 2.f);
+	const Matrix viewProjection = Matrix::CreateLookAtLH(Vector3{ 0.f, 0.f, -10.f }, Vector3{ 0.f, 0.f, 1.f }, Vector3{ 0.f, 1.f, 0.f })
+		* Matrix::CreatePerspectiveFovLH(0.8f, 4.f / 3.f, 0.1f, 100.f);
+
+	std::cout << "\033[36m"; // TEXT COLOR
+	std::cout << "[MATH] Benchmarks with the " << SimdDispatch::GetLevelName(SimdDispatch::GetLevel()) << " kernels" << std::endl;
+	std::cout << "\033[37m"; // TEXT COLOR WHITE
+
+	// Chained so every product depends on the previous one, a rotation keeps the values from growing
+	const Matrix rotation = Matrix::CreateRotation(0.01f, 0.02f, 0.03f);
+	constexpr int matrixCalls{ 200000 };
+	const double multiplyScalar = Measure(matrixCalls, [&]()
+		{
+			Matrix product{ world };
+			for (int call{}; call < matrixCalls; ++call)
+			{
+				product = Reference::Multiply(product, rotation);
+			}
+			g_Sink = product[0][0];
+		});
+	const double multiplySimd = Measure(matrixCalls, [&]()
+		{
+			Matrix product{ world };
+			for (int call{}; call < matrixCalls; ++call)
+			{
+				product *= rotation;
+			}
+			g_Sink = product[0][0];
+		});
+	Print("Matrix * Matrix", multiplyScalar, multiplySimd);
+
+	const double inverseScalar = Measure(matrixCalls, [&]()
+		{
+			Matrix inverse{ world };
+			for (int call{}; call < matrixCalls; ++call)
+			{
+				inverse = Reference::Inverse(inverse);
+			}
+			g_Sink = inverse[0][0];
+		});
+	const double inverseSimd = Measure(matrixCalls, [&]()
+		{
+			Matrix inverse{ world };
+			for (int call{}; call < matrixCalls; ++call)
+			{
+				inverse.Inverse();
+			}
+			g_Sink = inverse[0][0];
+		});
+	Print("Matrix::Inverse", inverseScalar, inverseSimd);
+
+	// World space vertex data of CPU_Mesh, per vertex
+	constexpr int vertexCount{ 65536 };
+	std::vector<Vertex> vertices(vertexCount);
+	for (Vertex& vertex : vertices)
+	{
+		vertex.position = Vector3{ unit(generator), unit(generator), unit(generator) };
+		vertex.normal = Vector3{ unit(generator), unit(generator), unit(generator) }.Normalized();
+		vertex.tangent = Vector3{ unit(generator), unit(generator), unit(generator) }.Normalized();
+	}
+
+	std::vector<Vector3> positions(vertexCount), normals(vertexCount), tangents(vertexCount);
+	const double verticesScalar = Measure(vertexCount, [&]()
+		{
+			Reference::TransformVertices(world, vertices, positions, normals, tangents);
+			g_Sink = positions.back().x + normals.back().x + tangents.back().x;
+		});
+	const double verticesSimd = Measure(vertexCount, [&]()
+		{
+			for (size_t index{}; index < vertices.size(); ++index)
+			{
+				positions[index] = vertices[index].position;
+				normals[index] = vertices[index].normal;
+				tangents[index] = vertices[index].tangent;
+			}
+
+			world.TransformPoints(positions, positions);
+			world.TransformVectorsAndNormalize(normals, normals);
+			world.TransformVectorsAndNormalize(tangents, tangents);
+			g_Sink = positions.back().x + normals.back().x + tangents.back().x;
+		});
+	Print("World space vertex", verticesScalar, verticesSimd);
+
+	// Vertex stage positions, scalar kernel against the selected one
+	std::vector<Vector4> rasterPositions(vertexCount);
+	const double rasterScalar = Measure(vertexCount, [&]()
+		{
+			GetScalarKernels()->TransformToRaster(positions.data(), rasterPositions.data(), vertexCount, viewProjection, 640.f, 480.f);
+			g_Sink = rasterPositions.back().x;
+		});
+	const double rasterSimd = Measure(vertexCount, [&]()
+		{
+			SIMD_KERNELS.TransformToRaster(positions.data(), rasterPositions.data(), vertexCount, viewProjection, 640.f, 480.f);
+			g_Sink = rasterPositions.back().x;
+		});
+	Print("World to raster vertex", rasterScalar, rasterSimd);
+
+	// Barycentric interpolation of the fragment normals, check_math_codegen.bat checks the inline loop has no calls left
+	std::vector<float> weights0(vertexCount), weights1(vertexCount), weights2(vertexCount), inverseW(vertexCount);
+	for (int index{}; index < vertexCount; ++index)
+	{
+		weights0[index] = unit(generator) * 0.5f + 0.5f;
+		weights1[index] = (1.f - weights0[index]) * (unit(generator) * 0.5f + 0.5f);
+		weights2[index] = 1.f - weights0[index] - weights1[index];
+		inverseW[index] = unit(generator) + 2.f;
+	}
+
+	std::vector<Vector3> interpolated(vertexCount);
+	const double interpolateOutOfLine = Measure(vertexCount, [&]()
+		{
+			Reference::InterpolateNormals(normals.data(), tangents.data(), positions.data(), weights0.data(), weights1.data(), weights2.data(), inverseW.data(),
+				interpolated.data(), vertexCount);
+			g_Sink = interpolated.back().x;
+		});
+	const double interpolateInline = Measure(vertexCount, [&]()
+		{
+			MathCodegen::InterpolateNormals(normals.data(), tangents.data(), positions.data(), weights0.data(), weights1.data(), weights2.data(), inverseW.data(),
+				interpolated.data(), vertexCount);
+			g_Sink = interpolated.back().x;
+		});
+	Print("Interpolate normals", interpolateOutOfLine, interpolateInline, "out of line", "inline");
+
+	// Per pixel shading math, exact against FastMath like MATH_QUALITY switches it
+	std::vector<float> cosines(vertexCount);
+	for (float& cosine : cosines)
+	{
+		cosine = unit(generator) * 0.5f + 0.5f;
+	}
+
+	const double normalizeExact = Measure(vertexCount, [&]()
+		{
+			for (Vector3& normal : normals)
+			{
+				normal = normal.Normalized();
+			}
+			g_Sink = normals.back().x;
+		});
+	const double normalizeFast = Measure(vertexCount, [&]()
+		{
+			for (Vector3& normal : normals)
+			{
+				normal = FastMath::Normalized(normal);
+			}
+			g_Sink = normals.back().x;
+		});
+	Print("Normalize", normalizeExact, normalizeFast, "exact", "fast");
+
+	const double powExact = Measure(vertexCount, [&]()
+		{
+			float sum{};
+			for (const float cosine : cosines)
+			{
+				sum += std::pow(cosine, 25.f);
+			}
+			g_Sink = sum;
+		});
+	const double powFast = Measure(vertexCount, [&]()
+		{
+			float sum{};
+			for (const float cosine : cosines)
+			{
+				sum += FastMath::Pow(cosine, 25.f);
+			}
+			g_Sink = sum;
+		});
+	Print("Pow", powExact, powFast, "exact", "fast");
+
+	std::vector<float> exponents(vertexCount, 25.f), powers(vertexCount);
+	const double powRow = Measure(vertexCount, [&]()
+		{
+			SIMD_KERNELS.FastMathRow(FAST_MATH_FUNCTION::POW, cosines.data(), exponents.data(), powers.data(), vertexCount);
+			g_Sink = powers.back();
+		});
+	Print("Pow row", powExact, powRow, "exact", "fast SIMD");
+
+	// Light of one pixel once its inputs are sampled: SHADING_MODE::COMBINED against the PBR batches
+	const IrradianceSH skyIrradiance = SphericalHarmonics::ProjectIrradiance(SphericalHarmonics::SkyRadiance, 16);
+	const Vector3 lightDirection{ .577f, -.577f, .577f };
+	const ColorRGB light{ 7.f, 7.f, 7.f };
+
+	std::vector<ColorRGB> albedos(vertexCount), reflectances(vertexCount);
+	for (int index{}; index < vertexCount; ++index)
+	{
+		albedos[index] = ColorRGB{ unit(generator) * 0.5f + 0.5f, unit(generator) * 0.5f + 0.5f, unit(generator) * 0.5f + 0.5f };
+		reflectances[index] = ColorRGB{ cosines[index] * 0.2f, cosines[index] * 0.2f, cosines[index] * 0.2f };
+		normals[index] = vertices[index].normal;
+		tangents[index] = Vector3{ unit(generator), unit(generator), unit(generator) - 2.f }.Normalized();
+	}
+
+	const double shadeCombined = Measure(vertexCount, [&]()
+		{
+			ColorRGB sum{};
+			for (int index{}; index < vertexCount; ++index)
+			{
+				const Vector3& normal = normals[index];
+				const float lambertCosine = std::max(Vector3::Dot(normal, -lightDirection), 0.f);
+				const float exponent = cosines[index] * 25.f;
+
+				const ColorRGB specular = Shading::Phong(reflectances[index], ColorRGB{ exponent, exponent, exponent }, lightDirection, tangents[index], normal);
+				const ColorRGB diffuse = Shading::Lambert(1.f, albedos[index]);
+				sum += ((diffuse * light) + specular) * lambertCosine + diffuse * skyIrradiance.Evaluate(normal);
+			}
+			g_Sink = sum.r;
+		});
+
+	// Filled like CPU_Renderer queues its fragments, one batch after the other
+	std::vector<PbrBatch> batches(vertexCount / PbrBatch::Size);
+	for (int index{}; index < vertexCount; ++index)
+	{
+		PbrBatch& batch = batches[index / PbrBatch::Size];
+		const int entry = batch.count++;
+		batch.normalX[entry] = normals[index].x;
+		batch.normalY[entry] = normals[index].y;
+		batch.normalZ[entry] = normals[index].z;
+		batch.viewX[entry] = tangents[index].x;
+		batch.viewY[entry] = tangents[index].y;
+		batch.viewZ[entry] = tangents[index].z;
+		batch.albedoR[entry] = albedos[index].r;
+		batch.albedoG[entry] = albedos[index].g;
+		batch.albedoB[entry] = albedos[index].b;
+		batch.specularR[entry] = reflectances[index].r;
+		batch.specularG[entry] = reflectances[index].g;
+		batch.specularB[entry] = reflectances[index].b;
+		batch.glossiness[entry] = cosines[index];
+		batch.visibility[entry] = 1.f;
+		batch.ambientOcclusion[entry] = 1.f;
+	}
+
+	PbrMaterial material{};
+	material.lightDirection = -lightDirection;
+	material.lightRadiance = light;
+	material.roughnessScale = -0.75f;
+	material.skyIrradiance = skyIrradiance;
+
+	alignas(64) float red[PbrBatch::Capacity], green[PbrBatch::Capacity], blue[PbrBatch::Capacity];
+	const double shadePbr = Measure(vertexCount, [&]()
+		{
+			float sum{};
+			for (const PbrBatch& batch : batches)
+			{
+				SIMD_KERNELS.ShadePbrBatch(material, batch, red, green, blue);
+				sum += red[0];
+			}
+			g_Sink = sum;
+		});
+	Print("Shading per pixel", shadeCombined, shadePbr, "combined", "PBR batch");
+}
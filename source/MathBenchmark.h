@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+	* Microbenchmarks of the SIMD Matrix paths against the scalar
+	* implementation they replaced. Started with --bench-math, prints the
+	* time per call of both versions and the speedup.
+	*/
+class MathBenchmark
+{
+public:
+	static void Run();
+};
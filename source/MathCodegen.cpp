@@ -0,0 +1,38 @@
+// Built without the precompiled header, check_math_codegen.bat compiles this file alone
+#include "MathCodegen.h"
+#include "Matrix.h"
+#include <algorithm>
+
+void MathCodegen::InterpolateNormals(const Vector3* pA, const Vector3* pB, const Vector3* pC, const float* pW0, const float* pW1, const float* pW2, const float* pW,
+	Vector3* pOut, int count)
+{
+	for (int index{}; index < count; ++index)
+	{
+		const Vector3 normal = ((pA[index] * pW0[index]) + (pB[index] * pW1[index]) + (pC[index] * pW2[index])) * pW[index];
+		pOut[index] = normal.Normalized();
+	}
+}
+
+void MathCodegen::MapNormals(const Vector3* pNormals, const Vector3* pTangents, const Vector3* pSamples, Vector3* pOut, int count)
+{
+	for (int index{}; index < count; ++index)
+	{
+		const Vector3& normal = pNormals[index];
+		const Vector3& tangent = pTangents[index];
+		const Vector3 binormal = Vector3::Cross(normal, tangent).Normalized();
+		const Matrix tangentSpaceAxis = Matrix{ tangent, binormal, normal, {0,0,0} };
+
+		const Vector3 normalSample = 2.f * pSamples[index] - Vector3{ 1.f, 1.f, 1.f };
+		pOut[index] = tangentSpaceAxis.TransformPoint(normalSample).Normalized();
+	}
+}
+
+float MathCodegen::SumLambertCosines(const Vector3* pNormals, const Vector3& towardsLight, int count)
+{
+	float sum{};
+	for (int index{}; index < count; ++index)
+	{
+		sum += std::max(Vector3::Dot(pNormals[index], towardsLight), 0.f);
+	}
+	return sum;
+}
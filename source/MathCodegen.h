@@ -0,0 +1,21 @@
+#pragma once
+#include "Vector3.h"
+
+/**
+	* The per pixel math of RenderTriangle and ShadePixel on the header-only math
+	* types, one loop per function. Built without the precompiled header, so
+	* check_math_codegen.bat can compile this translation unit on its own and fail
+	* if any of the loops still calls out. --bench-math times the same loops.
+	*/
+namespace MathCodegen
+{
+	// (a * w0 + b * w1 + c * w2) * w normalized, the interpolated normals of InterpolateFragment
+	void InterpolateNormals(const Vector3* pA, const Vector3* pB, const Vector3* pC, const float* pW0, const float* pW1, const float* pW2, const float* pW,
+		Vector3* pOut, int count);
+
+	// Tangent space normal mapping of ShadePixel, samples are the normal map colors in 0 to 1
+	void MapNormals(const Vector3* pNormals, const Vector3* pTangents, const Vector3* pSamples, Vector3* pOut, int count);
+
+	// Sum of the clamped cosines between the normals and the direction towards the light
+	float SumLambertCosines(const Vector3* pNormals, const Vector3& towardsLight, int count);
+}
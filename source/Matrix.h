@@ -1,60 +1,401 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include <span>
+#include <type_traits>
+#include "MathHelpers.h"
 #include "Vector3.h"
 #include "Vector4.h"
 
 
+	// Header-only except for the batched transforms, those go through the SimdDispatch kernels.
+	// The SSE paths only run outside of constant evaluation and keep the operation order of the scalar code.
 	struct Matrix
 	{
-		Matrix() = default;
-		Matrix(
+		constexpr Matrix() noexcept = default;
+		constexpr Matrix(
 			const Vector3& xAxis,
 			const Vector3& yAxis,
 			const Vector3& zAxis,
-			const Vector3& t);
+			const Vector3& t) noexcept :
+			Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+		{
+		}
 
-		Matrix(
+		constexpr Matrix(
 			const Vector4& xAxis,
 			const Vector4& yAxis,
 			const Vector4& zAxis,
-			const Vector4& t);
-
-		Matrix(const Matrix& m);
-
-		Vector3 TransformVector(const Vector3& v) const;
-		Vector3 TransformVector(float x, float y, float z) const;
-		Vector3 TransformPoint(const Vector3& p) const;
-		Vector3 TransformPoint(float x, float y, float z) const;
-
-		Vector4 TransformPoint(const Vector4& p) const;
-		Vector4 TransformPoint(float x, float y, float z, float w) const;
-
-		const Matrix& Transpose();
-		const Matrix& Inverse();
-
-		Vector3 GetAxisX() const;
-		Vector3 GetAxisY() const;
-		Vector3 GetAxisZ() const;
-		Vector3 GetTranslation() const;
-
-		static Matrix CreateTranslation(float x, float y, float z);
-		static Matrix CreateTranslation(const Vector3& t);
-		static Matrix CreateRotationX(float pitch);
-		static Matrix CreateRotationY(float yaw);
-		static Matrix CreateRotationZ(float roll);
-		static Matrix CreateRotation(float pitch, float yaw, float roll);
-		static Matrix CreateRotation(const Vector3& r);
-		static Matrix CreateScale(float sx, float sy, float sz);
-		static Matrix CreateScale(const Vector3& s);
-		static Matrix Transpose(const Matrix& m);
-		static Matrix Inverse(const Matrix& m);
-
-		static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
-		static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
-
-		Vector4& operator[](int index);
-		Vector4 operator[](int index) const;
-		Matrix operator*(const Matrix& m) const;
-		const Matrix& operator*=(const Matrix& m);
+			const Vector4& t) noexcept :
+			data{ xAxis, yAxis, zAxis, t }
+		{
+		}
+
+		constexpr Matrix(const Matrix& m) noexcept = default;
+		constexpr Matrix& operator=(const Matrix& m) noexcept = default;
+
+		constexpr Vector3 TransformVector(const Vector3& v) const noexcept
+		{
+			return TransformVector(v.x, v.y, v.z);
+		}
+
+		constexpr Vector3 TransformVector(float x, float y, float z) const noexcept
+		{
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				__m128 result = _mm_mul_ps(_mm_set1_ps(x), Load(data[0]));
+				result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(y), Load(data[1])));
+				result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(z), Load(data[2])));
+				return Store(result).GetXYZ();
+			}
+#endif
+			return Vector3{
+				data[0].x * x + data[1].x * y + data[2].x * z,
+				data[0].y * x + data[1].y * y + data[2].y * z,
+				data[0].z * x + data[1].z * y + data[2].z * z
+			};
+		}
+
+		constexpr Vector3 TransformPoint(const Vector3& p) const noexcept
+		{
+			return TransformPoint(p.x, p.y, p.z);
+		}
+
+		constexpr Vector3 TransformPoint(float x, float y, float z) const noexcept
+		{
+			return TransformPoint(x, y, z, 1.f).GetXYZ();
+		}
+
+		constexpr Vector4 TransformPoint(const Vector4& p) const noexcept
+		{
+			return TransformPoint(p.x, p.y, p.z, p.w);
+		}
+
+		// w is not applied to the translation
+		constexpr Vector4 TransformPoint(float x, float y, float z, float w) const noexcept
+		{
+			(void)w;
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				__m128 result = _mm_mul_ps(_mm_set1_ps(x), Load(data[0]));
+				result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(y), Load(data[1])));
+				result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(z), Load(data[2])));
+				return Store(_mm_add_ps(result, Load(data[3])));
+			}
+#endif
+			return Vector4{
+				data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
+				data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
+				data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
+				data[0].w * x + data[1].w * y + data[2].w * z + data[3].w
+			};
+		}
+
+		// Batched TransformPoint and normalized TransformVector through the SimdDispatch kernels, in and out can be the same span
+		void TransformPoints(std::span<const Vector3> points, std::span<Vector3> out) const;
+		void TransformVectorsAndNormalize(std::span<const Vector3> vectors, std::span<Vector3> out) const;
+
+		constexpr const Matrix& Transpose() noexcept
+		{
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				__m128 row0 = Load(data[0]);
+				__m128 row1 = Load(data[1]);
+				__m128 row2 = Load(data[2]);
+				__m128 row3 = Load(data[3]);
+				_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+				data[0] = Store(row0);
+				data[1] = Store(row1);
+				data[2] = Store(row2);
+				data[3] = Store(row3);
+				return *this;
+			}
+#endif
+			Matrix result{};
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					result[r][c] = data[c][r];
+				}
+			}
+
+			data[0] = result[0];
+			data[1] = result[1];
+			data[2] = result[2];
+			data[3] = result[3];
+
+			return *this;
+		}
+
+		// Affine matrices only, the w column is assumed to be (0, 0, 0, 1)
+		constexpr const Matrix& Inverse() noexcept
+		{
+			//Optimized Inverse as explained in FGED1 - used widely in other libraries too.
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				const __m128 a = Load(data[0]);
+				const __m128 b = Load(data[1]);
+				const __m128 c = Load(data[2]);
+				const __m128 d = Load(data[3]);
+
+				const __m128 x = Splat<3>(a);
+				const __m128 y = Splat<3>(b);
+				const __m128 z = Splat<3>(c);
+				const __m128 w = Splat<3>(d);
+
+				__m128 s = Cross(a, b);
+				__m128 t = Cross(c, d);
+				__m128 u = _mm_sub_ps(_mm_mul_ps(a, y), _mm_mul_ps(b, x));
+				__m128 v = _mm_sub_ps(_mm_mul_ps(c, w), _mm_mul_ps(d, z));
+
+				const float det = Dot(s, v) + Dot(t, u);
+				assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+				const __m128 invDet = _mm_set1_ps(1.f / det);
+
+				s = _mm_mul_ps(s, invDet); t = _mm_mul_ps(t, invDet); u = _mm_mul_ps(u, invDet); v = _mm_mul_ps(v, invDet);
+
+				__m128 r0 = _mm_add_ps(Cross(b, v), _mm_mul_ps(t, y));
+				__m128 r1 = _mm_sub_ps(Cross(v, a), _mm_mul_ps(t, x));
+				__m128 r2 = _mm_add_ps(Cross(d, u), _mm_mul_ps(s, w));
+				__m128 r3 = _mm_setzero_ps();
+
+				// r0, r1 and r2 are the columns of the upper 3x3, the zero row becomes the w column
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+				data[0] = Store(r0);
+				data[1] = Store(r1);
+				data[2] = Store(r2);
+				data[3] = Vector4{ -Dot(b, t), Dot(a, t), -Dot(d, s), Dot(c, s) };
+				return *this;
+			}
+#endif
+			const Vector3 a = data[0];
+			const Vector3 b = data[1];
+			const Vector3 c = data[2];
+			const Vector3 d = data[3];
+
+			const float x = data[0][3];
+			const float y = data[1][3];
+			const float z = data[2][3];
+			const float w = data[3][3];
+
+			Vector3 s = Vector3::Cross(a, b);
+			Vector3 t = Vector3::Cross(c, d);
+			Vector3 u = a * y - b * x;
+			Vector3 v = c * w - d * z;
+
+			const float det = Vector3::Dot(s, v) + Vector3::Dot(t, u);
+			assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+			const float invDet = 1.f / det;
+
+			s *= invDet; t *= invDet; u *= invDet; v *= invDet;
+
+			const Vector3 r0 = Vector3::Cross(b, v) + t * y;
+			const Vector3 r1 = Vector3::Cross(v, a) - t * x;
+			const Vector3 r2 = Vector3::Cross(d, u) + s * w;
+
+			data[0] = Vector4{ r0.x, r1.x, r2.x, 0.f };
+			data[1] = Vector4{ r0.y, r1.y, r2.y, 0.f };
+			data[2] = Vector4{ r0.z, r1.z, r2.z, 0.f };
+			data[3] = Vector4{ -Vector3::Dot(b, t), Vector3::Dot(a, t), -Vector3::Dot(d, s), Vector3::Dot(c, s) };
+
+			return *this;
+		}
+
+		constexpr Vector3 GetAxisX() const noexcept
+		{
+			return data[0];
+		}
+
+		constexpr Vector3 GetAxisY() const noexcept
+		{
+			return data[1];
+		}
+
+		constexpr Vector3 GetAxisZ() const noexcept
+		{
+			return data[2];
+		}
+
+		constexpr Vector3 GetTranslation() const noexcept
+		{
+			return data[3];
+		}
+
+		static constexpr Matrix CreateTranslation(float x, float y, float z) noexcept
+		{
+			return CreateTranslation({ x, y, z });
+		}
+
+		static constexpr Matrix CreateTranslation(const Vector3& t) noexcept
+		{
+			return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+		}
+
+		static Matrix CreateRotationX(float pitch) noexcept
+		{
+			return {
+				{1, 0, 0, 0},
+				{0, cosf(pitch), -sinf(pitch), 0},
+				{0, sinf(pitch), cosf(pitch), 0},
+				{0, 0, 0, 1}
+			};
+		}
+
+		static Matrix CreateRotationY(float yaw) noexcept
+		{
+			return {
+				{cosf(yaw), 0, -sinf(yaw), 0},
+				{0, 1, 0, 0},
+				{sinf(yaw), 0, cosf(yaw), 0},
+				{0, 0, 0, 1}
+			};
+		}
+
+		static Matrix CreateRotationZ(float roll) noexcept
+		{
+			return {
+				{cosf(roll), sinf(roll), 0, 0},
+				{-sinf(roll), cosf(roll), 0, 0},
+				{0, 0, 1, 0},
+				{0, 0, 0, 1}
+			};
+		}
+
+		static Matrix CreateRotation(float pitch, float yaw, float roll) noexcept
+		{
+			return CreateRotation({ pitch, yaw, roll });
+		}
+
+		static Matrix CreateRotation(const Vector3& r) noexcept
+		{
+			return CreateRotationX(r[0]) * CreateRotationY(r[1]) * CreateRotationZ(r[2]);
+		}
+
+		static constexpr Matrix CreateScale(float sx, float sy, float sz) noexcept
+		{
+			return { Vector3{sx, 0, 0}, Vector3{0, sy, 0}, Vector3{0, 0, sz}, Vector3::Zero };
+		}
+
+		static constexpr Matrix CreateScale(const Vector3& s) noexcept
+		{
+			return CreateScale(s[0], s[1], s[2]);
+		}
+
+		static constexpr Matrix Transpose(const Matrix& m) noexcept
+		{
+			Matrix out{ m };
+			out.Transpose();
+
+			return out;
+		}
+
+		static constexpr Matrix Inverse(const Matrix& m) noexcept
+		{
+			Matrix out{ m };
+			out.Inverse();
+
+			return out;
+		}
+
+		static constexpr Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up) noexcept
+		{
+			//TODO W1
+			(void)origin; (void)forward; (void)up;
+
+			return {};
+		}
+
+		static constexpr Matrix CreatePerspectiveFovLH(float fov, float aspect, float zn, float zf) noexcept
+		{
+			const float A = zf / (zf - zn);
+			const float B = (-(zf * zn)) / (zf - zn);
+			const float OneOverAStFOV = (1.f / (aspect * fov));
+			const float OneOverFOV = 1.f / fov;
+
+			return{
+				Vector4{OneOverAStFOV, 0, 0, 0},
+				Vector4{0,OneOverFOV ,0,0},
+				Vector4{0,0,A,1},
+				Vector4{0,0,B,0},
+			};
+		}
+
+#pragma region Operator Overloads
+		constexpr Vector4& operator[](int index) noexcept
+		{
+			assert(index <= 3 && index >= 0);
+			return data[index];
+		}
+
+		constexpr Vector4 operator[](int index) const noexcept
+		{
+			assert(index <= 3 && index >= 0);
+			return data[index];
+		}
+
+		constexpr Matrix operator*(const Matrix& m) const noexcept
+		{
+			Matrix result{ *this };
+			result *= m;
+
+			return result;
+		}
+
+		constexpr const Matrix& operator*=(const Matrix& m) noexcept
+		{
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				// m can be this matrix, all rows get computed before any is stored
+				__m128 rows[4];
+				for (int r{ 0 }; r < 4; ++r)
+				{
+					rows[r] = CombineRows(Load(data[r]), m.data);
+				}
+
+				for (int r{ 0 }; r < 4; ++r)
+				{
+					data[r] = Store(rows[r]);
+				}
+
+				return *this;
+			}
+#endif
+			const Matrix copy{ *this };
+			const Matrix m_transposed = Transpose(m);
+
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					data[r][c] = Vector4::Dot(copy[r], m_transposed[c]);
+				}
+			}
+
+			return *this;
+		}
+
+		constexpr bool operator==(const Matrix& m) const noexcept
+		{
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					if (data[r][c] != m.data[r][c])
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+#pragma endregion
 
 	private:
 
@@ -71,4 +412,50 @@
 		// v1x v1y v1z v1w
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
+
+#if defined(MATH_SSE)
+		static __m128 Load(const Vector4& v) noexcept
+		{
+			return _mm_loadu_ps(&v.x);
+		}
+
+		static Vector4 Store(__m128 value) noexcept
+		{
+			Vector4 v;
+			_mm_storeu_ps(&v.x, value);
+			return v;
+		}
+
+		template<int Lane>
+		static __m128 Splat(__m128 value) noexcept
+		{
+			return _mm_shuffle_ps(value, value, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+		}
+
+		// x * row0 + y * row1 + z * row2 + w * row3, same order as the scalar dot products
+		static __m128 CombineRows(__m128 v, const Vector4* pRows) noexcept
+		{
+			__m128 result = _mm_mul_ps(Splat<0>(v), Load(pRows[0]));
+			result = _mm_add_ps(result, _mm_mul_ps(Splat<1>(v), Load(pRows[1])));
+			result = _mm_add_ps(result, _mm_mul_ps(Splat<2>(v), Load(pRows[2])));
+			return _mm_add_ps(result, _mm_mul_ps(Splat<3>(v), Load(pRows[3])));
+		}
+
+		// Vector3::Cross on the xyz lanes, w ends up 0
+		static __m128 Cross(__m128 a, __m128 b) noexcept
+		{
+			const __m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 aZxy = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+			const __m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 bZxy = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+			return _mm_sub_ps(_mm_mul_ps(aYzx, bZxy), _mm_mul_ps(aZxy, bYzx));
+		}
+
+		// Vector3::Dot on the xyz lanes, summed in the same order
+		static float Dot(__m128 a, __m128 b) noexcept
+		{
+			const __m128 product = _mm_mul_ps(a, b);
+			return _mm_cvtss_f32(product) + _mm_cvtss_f32(Splat<1>(product)) + _mm_cvtss_f32(Splat<2>(product));
+		}
+#endif
 	};
@@ -41,6 +41,11 @@ public:
 	std::array<std::string, 4> texturesLocations{};
 	std::array<Texture*, 4> textures{};
 
+	// The normal map holds object space normals (NormalMapBaker), shading only rotates them and the tangents go unused
+	bool isNormalMapObjectSpace{};
+	// Per vertex coordinates into the layers of the object space normal map
+	std::vector<Vector2> normalMapUV{};
+
 	void AddRotationY(float yaw)
 	{
 		yawRotation += yaw;
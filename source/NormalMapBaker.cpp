@@ -0,0 +1,364 @@
+#include "pch.h"
+#include "NormalMapBaker.h"
+#include "Mesh.h"
+#include "Texture.h"
+#include <map>
+
+namespace
+{
+	// Widest texture Direct3D 11 can create, bounds the amount of layers
+	constexpr int g_MaxBakedWidth{ 16384 };
+
+	// Layers that keep the UVs of the mesh, enough for mirrored halves. Triangles that overlap more often
+	// (repeated bolts, rims) are few and small, they get packed into layers of their own instead
+	constexpr int g_OverlapLayers{ 2 };
+
+	// Gutter texels filled around every UV island, enough for the point and bilinear taps next to a seam
+	constexpr int g_DilationPasses{ 4 };
+
+	// Triangles that write directions further apart than this into one texel belong to different layers
+	constexpr float g_ConflictCosine{ 0.9f };
+
+	struct Layer
+	{
+		std::vector<Vector3> normals{};
+		std::vector<uint8_t> isCovered{};
+	};
+
+	struct BakedTexel
+	{
+		size_t index{};
+		Vector3 normal{};
+	};
+
+	// Where a triangle ends up in the baked map, the offset moves a packed triangle away from its UVs in texels
+	struct Placement
+	{
+		int layer{};
+		int offsetX{};
+		int offsetY{};
+	};
+
+	// Object space normals of every texel the triangle covers in UV space, moved by the offset of its placement
+	void RasterizeTriangle(const Vertex& vertex1, const Vertex& vertex2, const Vertex& vertex3, const Texture& tangentSpaceMap, int width, int height,
+		const Placement& placement, std::vector<BakedTexel>& texels)
+	{
+		texels.clear();
+
+		// Texel space, texel centers sit at + 0.5 like Texture::Sample reads them
+		const Vector2 offset{ static_cast<float>(placement.offsetX), static_cast<float>(placement.offsetY) };
+		const Vector2 position1{ Vector2{ vertex1.uv.x * width, vertex1.uv.y * height } + offset };
+		const Vector2 position2{ Vector2{ vertex2.uv.x * width, vertex2.uv.y * height } + offset };
+		const Vector2 position3{ Vector2{ vertex3.uv.x * width, vertex3.uv.y * height } + offset };
+
+		// Same tangent frame as ShadePixel and PosCol3D.fx built per pixel, only in object space
+		const auto bakeTexel = [&](int x, int y, float weight1, float weight2, float weight3)
+		{
+			const Vector3 normal = Vector3::Lico(weight1, vertex1.normal, weight2, vertex2.normal, weight3, vertex3.normal).Normalized();
+			const Vector3 tangentSum = Vector3::Lico(weight1, vertex1.tangent, weight2, vertex2.tangent, weight3, vertex3.tangent);
+
+			// Triangles without UV area have no tangent (the parser leaves NaN), the map cannot rotate anything there
+			const float tangentLength = tangentSum.SqrMagnitude();
+			if (!std::isfinite(tangentLength) || tangentLength == 0.f)
+			{
+				texels.push_back({ static_cast<size_t>(y) * width + x, normal });
+				return;
+			}
+
+			const Vector3 tangent = tangentSum.Normalized();
+			const Vector3 binormal = Vector3::Cross(normal, tangent).Normalized();
+
+			const ColorRGB color = tangentSpaceMap.Sample(Vector2{ (x + 0.5f - offset.x) / width, (y + 0.5f - offset.y) / height });
+			const Vector3 sample = 2.f * Vector3{ color.r, color.g, color.b } - Vector3{ 1.f, 1.f, 1.f };
+
+			texels.push_back({ static_cast<size_t>(y) * width + x, (tangent * sample.x + binormal * sample.y + normal * sample.z).Normalized() });
+		};
+
+		// Signed, so both UV windings end up with positive weights inside
+		const float area = Vector2::Cross(position2 - position1, position3 - position1);
+		const int minX = std::max(0, static_cast<int>(std::min({ position1.x, position2.x, position3.x })));
+		const int minY = std::max(0, static_cast<int>(std::min({ position1.y, position2.y, position3.y })));
+		const int maxX = std::min(width - 1, static_cast<int>(std::max({ position1.x, position2.x, position3.x })));
+		const int maxY = std::min(height - 1, static_cast<int>(std::max({ position1.y, position2.y, position3.y })));
+
+		for (int y{ minY }; area != 0.f && y <= maxY; ++y)
+		{
+			for (int x{ minX }; x <= maxX; ++x)
+			{
+				const Vector2 center{ x + 0.5f, y + 0.5f };
+				const float weight1 = Vector2::Cross(position3 - position2, center - position2) / area;
+				const float weight2 = Vector2::Cross(position1 - position3, center - position3) / area;
+				const float weight3 = 1.f - weight1 - weight2;
+
+				if (weight1 > 0.f && weight2 > 0.f && weight3 > 0.f)
+				{
+					bakeTexel(x, y, weight1, weight2, weight3);
+				}
+			}
+		}
+
+		// The texel under the centroid always belongs to the triangle, even for slivers between texel centers.
+		// A neighbour that wrote a different direction there conflicts, so the sliver moves instead of reading it
+		const Vector2 centroid{ (position1 + position2 + position3) * (1.f / 3.f) };
+		const int centroidX = static_cast<int>(centroid.x);
+		const int centroidY = static_cast<int>(centroid.y);
+		const size_t centroidIndex = static_cast<size_t>(centroidY) * width + centroidX;
+		if (centroidX >= 0 && centroidX < width && centroidY >= 0 && centroidY < height
+			&& std::none_of(texels.begin(), texels.end(), [centroidIndex](const BakedTexel& texel) { return texel.index == centroidIndex; }))
+		{
+			bakeTexel(centroidX, centroidY, 1.f / 3.f, 1.f / 3.f, 1.f / 3.f);
+		}
+	}
+
+	bool IsCompatible(const Layer& layer, const std::vector<BakedTexel>& texels)
+	{
+		for (const BakedTexel& texel : texels)
+		{
+			if (layer.isCovered[texel.index] && Vector3::Dot(layer.normals[texel.index], texel.normal) < g_ConflictCosine)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Bleeds the islands into the gutters, texels next to a seam must not read undefined directions
+	void Dilate(Layer& layer, int width, int height)
+	{
+		std::vector<uint8_t> isCoveredNext{ layer.isCovered };
+
+		for (int pass{}; pass < g_DilationPasses; ++pass)
+		{
+			for (int y{}; y < height; ++y)
+			{
+				for (int x{}; x < width; ++x)
+				{
+					const size_t texelIndex = static_cast<size_t>(y) * width + x;
+					if (layer.isCovered[texelIndex])
+					{
+						continue;
+					}
+
+					Vector3 sum{};
+					for (int neighbourY{ std::max(y - 1, 0) }; neighbourY <= std::min(y + 1, height - 1); ++neighbourY)
+					{
+						for (int neighbourX{ std::max(x - 1, 0) }; neighbourX <= std::min(x + 1, width - 1); ++neighbourX)
+						{
+							const size_t neighbourIndex = static_cast<size_t>(neighbourY) * width + neighbourX;
+							if (layer.isCovered[neighbourIndex])
+							{
+								sum += layer.normals[neighbourIndex];
+							}
+						}
+					}
+
+					if (sum.SqrMagnitude() > 0.f)
+					{
+						layer.normals[texelIndex] = sum.Normalized();
+						isCoveredNext[texelIndex] = 1;
+					}
+				}
+			}
+
+			layer.isCovered = isCoveredNext;
+		}
+	}
+
+	uint8_t Encode(float value)
+	{
+		return static_cast<uint8_t>(std::clamp(value * 0.5f + 0.5f, 0.f, 1.f) * 255.f + 0.5f);
+	}
+}
+
+bool NormalMapBaker::BakeObjectSpace(MeshData& mesh)
+{
+	const Texture& tangentSpaceMap = *mesh.textures[1];
+	SDL_Surface* pSource = mesh.textures[1]->GetSurface();
+	const int width = pSource->w;
+	const int height = pSource->h;
+	const int maxLayers = g_MaxBakedWidth / width;
+	const size_t texelCount = static_cast<size_t>(width) * height;
+	const int gutter = g_DilationPasses;
+
+	const size_t triangleCount = mesh.indices.size() / 3;
+	const auto getVertex = [&mesh](size_t triangle, size_t corner) -> const Vertex& { return mesh.vertices[mesh.indices[3 * triangle + corner]]; };
+
+	std::vector<Placement> placements(triangleCount);
+	std::vector<size_t> packedTriangles{};
+	std::vector<Layer> layers{};
+	std::vector<BakedTexel> texels{};
+
+	// The first triangle keeps a texel, agreeing ones overwriting it in turn could drift past the conflict angle
+	const auto writeTexels = [&layers, &texels](int layerIndex)
+	{
+		Layer& layer = layers[layerIndex];
+		for (const BakedTexel& texel : texels)
+		{
+			if (!layer.isCovered[texel.index])
+			{
+				layer.normals[texel.index] = texel.normal;
+				layer.isCovered[texel.index] = 1;
+			}
+		}
+	};
+
+	// Every triangle goes to the first layer it agrees with at its own UVs, shared edges of one island write the same directions
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+	{
+		RasterizeTriangle(getVertex(triangle, 0), getVertex(triangle, 1), getVertex(triangle, 2), tangentSpaceMap, width, height, Placement{}, texels);
+
+		int layerIndex{};
+		while (layerIndex < static_cast<int>(layers.size()) && !IsCompatible(layers[layerIndex], texels))
+		{
+			++layerIndex;
+		}
+
+		if (layerIndex == g_OverlapLayers)
+		{
+			packedTriangles.push_back(triangle);
+			continue;
+		}
+
+		if (layerIndex == static_cast<int>(layers.size()))
+		{
+			layers.push_back({ std::vector<Vector3>(texelCount), std::vector<uint8_t>(texelCount) });
+		}
+
+		writeTexels(layerIndex);
+		placements[triangle].layer = layerIndex;
+	}
+
+	// The rest gets shelf packed into fresh layers, a gutter on every side keeps the dilation of neighbours apart
+	int shelfX{ width };
+	int shelfY{};
+	int shelfHeight{};
+
+	for (size_t triangle : packedTriangles)
+	{
+		const Vertex& vertex1 = getVertex(triangle, 0);
+		const Vertex& vertex2 = getVertex(triangle, 1);
+		const Vertex& vertex3 = getVertex(triangle, 2);
+
+		const int minX = std::clamp(static_cast<int>(std::min({ vertex1.uv.x, vertex2.uv.x, vertex3.uv.x }) * width), 0, width - 1);
+		const int minY = std::clamp(static_cast<int>(std::min({ vertex1.uv.y, vertex2.uv.y, vertex3.uv.y }) * height), 0, height - 1);
+		const int maxX = std::clamp(static_cast<int>(std::max({ vertex1.uv.x, vertex2.uv.x, vertex3.uv.x }) * width), 0, width - 1);
+		const int maxY = std::clamp(static_cast<int>(std::max({ vertex1.uv.y, vertex2.uv.y, vertex3.uv.y }) * height), 0, height - 1);
+		const int rectWidth = std::min(maxX - minX + 1 + 2 * gutter, width);
+		const int rectHeight = std::min(maxY - minY + 1 + 2 * gutter, height);
+
+		if (shelfX + rectWidth > width)
+		{
+			shelfX = 0;
+			shelfY += shelfHeight;
+			shelfHeight = 0;
+		}
+
+		if (layers.size() <= g_OverlapLayers || shelfY + rectHeight > height)
+		{
+			layers.push_back({ std::vector<Vector3>(texelCount), std::vector<uint8_t>(texelCount) });
+			shelfX = 0;
+			shelfY = 0;
+			shelfHeight = 0;
+		}
+
+		Placement& placement = placements[triangle];
+		placement.layer = static_cast<int>(layers.size()) - 1;
+		placement.offsetX = shelfX + gutter - minX;
+		placement.offsetY = shelfY + gutter - minY;
+
+		RasterizeTriangle(vertex1, vertex2, vertex3, tangentSpaceMap, width, height, placement, texels);
+		writeTexels(placement.layer);
+
+		shelfX += rectWidth;
+		shelfHeight = std::max(shelfHeight, rectHeight);
+	}
+
+	const int layerCount = static_cast<int>(layers.size());
+	if (layerCount == 0 || layerCount > maxLayers)
+	{
+		std::cout << "\033[33m"; // TEXT COLOR
+		std::cout << "[BAKE] Normal map stays in tangent space, " << layerCount << " layers do not fit in one texture" << std::endl;
+		std::cout << "\033[37m"; // TEXT COLOR WHITE
+		return false;
+	}
+
+	// Same pixel format as the source, so every backend uploads and samples it like the map it replaces
+	SDL_Surface* pBaked = SDL_CreateRGBSurfaceWithFormat(0, width * layerCount, height, pSource->format->BitsPerPixel, pSource->format->format);
+	if (pBaked == nullptr)
+	{
+		throw std::runtime_error("Failed to create the object space normal map surface");
+	}
+
+	for (int layerIndex{}; layerIndex < layerCount; ++layerIndex)
+	{
+		Layer& layer = layers[layerIndex];
+		Dilate(layer, width, height);
+
+		for (int y{}; y < height; ++y)
+		{
+			uint32_t* pRow = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pBaked->pixels) + static_cast<size_t>(y) * pBaked->pitch) + layerIndex * width;
+			for (int x{}; x < width; ++x)
+			{
+				// Never sampled, any unit direction does
+				const size_t texelIndex = static_cast<size_t>(y) * width + x;
+				const Vector3 normal = layer.isCovered[texelIndex] ? layer.normals[texelIndex] : Vector3::UnitZ;
+				pRow[x] = SDL_MapRGBA(pBaked->format, Encode(normal.x), Encode(normal.y), Encode(normal.z), 255);
+			}
+		}
+	}
+
+	// Vertices take the placement of their triangles. A vertex shared across layers gets a copy per layer,
+	// packed triangles are placed one by one so their vertices get a copy per triangle
+	constexpr size_t unplaced{ SIZE_MAX };
+	std::vector<size_t> vertexPlacements(mesh.vertices.size(), unplaced);
+	std::map<std::pair<uint32_t, size_t>, uint32_t> placementCopies{};
+	mesh.normalMapUV.assign(mesh.vertices.size(), Vector2{});
+
+	for (size_t triangle{}; triangle < triangleCount; ++triangle)
+	{
+		// Triangles in the same overlap layer share one placement, packed ones have their own
+		const Placement& placement = placements[triangle];
+		const size_t placementKey = placement.layer < g_OverlapLayers ? placement.layer : g_OverlapLayers + triangle;
+
+		for (size_t corner{}; corner < 3; ++corner)
+		{
+			uint32_t& vertexIndex = mesh.indices[3 * triangle + corner];
+
+			if (vertexPlacements[vertexIndex] == unplaced)
+			{
+				vertexPlacements[vertexIndex] = placementKey;
+			}
+			else if (vertexPlacements[vertexIndex] != placementKey)
+			{
+				const auto [it, isNew] = placementCopies.try_emplace({ vertexIndex, placementKey }, static_cast<uint32_t>(mesh.vertices.size()));
+				if (isNew)
+				{
+					const Vertex copy = mesh.vertices[vertexIndex];
+					mesh.vertices.push_back(copy);
+					mesh.normalMapUV.push_back({});
+					vertexPlacements.push_back(placementKey);
+				}
+
+				vertexIndex = it->second;
+			}
+
+			const Vector2& uv = mesh.vertices[vertexIndex].uv;
+			mesh.normalMapUV[vertexIndex] = {
+				(uv.x + static_cast<float>(placement.offsetX) / width + placement.layer) / layerCount,
+				uv.y + static_cast<float>(placement.offsetY) / height
+			};
+		}
+	}
+
+	delete mesh.textures[1];
+	mesh.textures[1] = Texture::CreateFromSurface(pBaked);
+	mesh.isNormalMapObjectSpace = true;
+
+	std::cout << "\033[33m"; // TEXT COLOR
+	std::cout << "[BAKE] Object space normal map, " << layerCount << " layers of " << width << "x" << height << ", "
+		<< packedTriangles.size() << " triangles packed" << std::endl;
+	std::cout << "\033[37m"; // TEXT COLOR WHITE
+
+	return true;
+}
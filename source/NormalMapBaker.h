@@ -0,0 +1,23 @@
+#pragma once
+
+class MeshData;
+
+/**
+	* Load time bake of a tangent space normal map into an object space one. Every
+	* texel gets the object space frame of the triangle that covers it in UV space,
+	* so shading a rigid mesh only has to rotate the sampled normal by the world
+	* matrix instead of building the tangent frame per pixel.
+	*
+	* UV islands that overlap (mirrored halves, repeated parts) need different
+	* directions in the same texel, the triangles that disagree with what is baked
+	* already move to another layer. Mirrored halves need two, the few triangles that
+	* overlap more often get packed into a layer of their own. Layers sit side by side
+	* in the baked map and MeshData::normalMapUV holds the coordinates of every vertex.
+	*/
+class NormalMapBaker
+{
+public:
+	// Replaces textures[1] of the mesh, vertices shared by triangles of different placements get duplicated.
+	// False when the mesh needs more layers than one texture can hold, it keeps its tangent space map then
+	static bool BakeObjectSpace(MeshData& mesh);
+};
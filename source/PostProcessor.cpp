@@ -0,0 +1,352 @@
+#include "pch.h"
+#include "PostProcessor.h"
+#include "StageProfiler.h"
+#include "JobSystem.h"
+#include <emmintrin.h>
+
+namespace
+{
+	struct ResolveConstants
+	{
+		float exposure;
+		float bloomThreshold;
+		uint8_t redShift;
+		uint8_t greenShift;
+		uint8_t blueShift;
+	};
+
+	inline __m128 Saturate4(__m128 v)
+	{
+		return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.f));
+	}
+
+	inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	// ACES filmic curve fit by Krzysztof Narkowicz
+	inline __m128 TonemapACES(__m128 x)
+	{
+		const __m128 numerator = _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.51f)), _mm_set1_ps(0.03f)));
+		const __m128 denominator = _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.43f)), _mm_set1_ps(0.59f))), _mm_set1_ps(0.14f));
+		return Saturate4(_mm_div_ps(numerator, denominator));
+	}
+
+	inline float TonemapACES(float x)
+	{
+		return Saturate((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f));
+	}
+
+	inline __m128 Luminance(__m128 r, __m128 g, __m128 b)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(0.2126f)), _mm_mul_ps(g, _mm_set1_ps(0.7152f))), _mm_mul_ps(b, _mm_set1_ps(0.0722f)));
+	}
+
+	// Average of 8 consecutive pixels of two rows into 4 half resolution pixels
+	inline __m128 Downsample(const float* pRow0, const float* pRow1)
+	{
+		const __m128 a0 = _mm_loadu_ps(pRow0);
+		const __m128 b0 = _mm_loadu_ps(pRow0 + 4);
+		const __m128 a1 = _mm_loadu_ps(pRow1);
+		const __m128 b1 = _mm_loadu_ps(pRow1 + 4);
+
+		const __m128 sum0 = _mm_add_ps(_mm_shuffle_ps(a0, b0, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a0, b0, _MM_SHUFFLE(3, 1, 3, 1)));
+		const __m128 sum1 = _mm_add_ps(_mm_shuffle_ps(a1, b1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a1, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+		return _mm_mul_ps(_mm_add_ps(sum0, sum1), _mm_set1_ps(0.25f));
+	}
+
+	inline __m128i PackChannel(__m128 channel, uint8_t shift)
+	{
+		return _mm_sll_epi32(_mm_cvtps_epi32(_mm_mul_ps(channel, _mm_set1_ps(255.f))), _mm_cvtsi32_si128(shift));
+	}
+
+	inline void ResolveQuad(const float* pRed, const float* pGreen, const float* pBlue, const float* pDepth,
+		__m128 bloomRed, __m128 bloomGreen, __m128 bloomBlue, const ResolveConstants& constants, uint32_t* pOut)
+	{
+		const __m128 red = _mm_loadu_ps(pRed);
+		const __m128 green = _mm_loadu_ps(pGreen);
+		const __m128 blue = _mm_loadu_ps(pBlue);
+		const __m128 exposure = _mm_set1_ps(constants.exposure);
+
+		// Background keeps its clear color, only bloom bleeds onto it
+		const __m128 isBackground = _mm_cmpeq_ps(_mm_loadu_ps(pDepth), _mm_set1_ps(FLT_MAX));
+
+		const __m128 outRed = Select(isBackground, Saturate4(_mm_add_ps(red, bloomRed)), TonemapACES(_mm_add_ps(_mm_mul_ps(red, exposure), bloomRed)));
+		const __m128 outGreen = Select(isBackground, Saturate4(_mm_add_ps(green, bloomGreen)), TonemapACES(_mm_add_ps(_mm_mul_ps(green, exposure), bloomGreen)));
+		const __m128 outBlue = Select(isBackground, Saturate4(_mm_add_ps(blue, bloomBlue)), TonemapACES(_mm_add_ps(_mm_mul_ps(blue, exposure), bloomBlue)));
+
+		const __m128i packed = _mm_or_si128(PackChannel(outRed, constants.redShift),
+			_mm_or_si128(PackChannel(outGreen, constants.greenShift), PackChannel(outBlue, constants.blueShift)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut), packed);
+	}
+
+	inline uint32_t ResolvePixel(float red, float green, float blue, float depth,
+		float bloomRed, float bloomGreen, float bloomBlue, const ResolveConstants& constants)
+	{
+		if (depth == FLT_MAX)
+		{
+			red = Saturate(red + bloomRed);
+			green = Saturate(green + bloomGreen);
+			blue = Saturate(blue + bloomBlue);
+		}
+		else
+		{
+			red = TonemapACES(red * constants.exposure + bloomRed);
+			green = TonemapACES(green * constants.exposure + bloomGreen);
+			blue = TonemapACES(blue * constants.exposure + bloomBlue);
+		}
+
+		return (static_cast<uint32_t>(red * 255.f + 0.5f) << constants.redShift)
+			| (static_cast<uint32_t>(green * 255.f + 0.5f) << constants.greenShift)
+			| (static_cast<uint32_t>(blue * 255.f + 0.5f) << constants.blueShift);
+	}
+}
+
+PostProcessor::PostProcessor(int width, int height)
+	: m_Width{ width }, m_Height{ height }, m_Layout{ width, height }
+{
+	m_Red.resize(m_Layout.GetPixelCount());
+	m_Green.resize(m_Layout.GetPixelCount());
+	m_Blue.resize(m_Layout.GetPixelCount());
+
+	m_BloomWidth = (width + 1) / 2;
+	m_BloomHeight = (height + 1) / 2;
+	m_BloomStride = (m_BloomWidth + 3) & ~3;
+
+	m_BloomRed.resize(m_BloomStride * m_BloomHeight);
+	m_BloomGreen.resize(m_BloomStride * m_BloomHeight);
+	m_BloomBlue.resize(m_BloomStride * m_BloomHeight);
+
+	// Normalized gaussian, sigma at half the radius
+	const float sigma = BloomRadius * 0.5f;
+	float weightSum{};
+	for (int i{ -BloomRadius }; i <= BloomRadius; ++i)
+	{
+		const float weight = expf(-(i * i) / (2.f * sigma * sigma));
+		m_BloomWeights[i + BloomRadius] = weight;
+		weightSum += weight;
+	}
+
+	for (float& weight : m_BloomWeights)
+	{
+		weight /= weightSum;
+	}
+}
+
+void PostProcessor::Clear(const ColorRGB& color)
+{
+	std::fill(m_Red.begin(), m_Red.end(), color.r);
+	std::fill(m_Green.begin(), m_Green.end(), color.g);
+	std::fill(m_Blue.begin(), m_Blue.end(), color.b);
+}
+
+void PostProcessor::Clear(const ColorRGB& color, int minX, int minY, int maxX, int maxY)
+{
+	m_Layout.FillRect(m_Red.data(), minX, minY, maxX, maxY, color.r);
+	m_Layout.FillRect(m_Green.data(), minX, minY, maxX, maxY, color.g);
+	m_Layout.FillRect(m_Blue.data(), minX, minY, maxX, maxY, color.b);
+}
+
+void PostProcessor::Resolve(const float* pDepthBuffer, SDL_Surface* pTarget, StageProfiler& profiler)
+{
+	{
+		StageProfiler::ScopedStage stage{ profiler, "Post bloom (downsample + bright pass + blur X)" };
+
+		JOB_SYSTEM->ParallelFor(0, m_BloomHeight, [this](int bloomRow)
+			{
+				BloomPass(bloomRow);
+			}, JobSystem::PRIORITY::HIGH
+		);
+	}
+
+	{
+		StageProfiler::ScopedStage stage{ profiler, "Post composite (blur Y + tonemap + pack)" };
+
+		JOB_SYSTEM->ParallelFor(0, m_BloomHeight, [=, this](int bloomRow)
+			{
+				CompositePass(bloomRow, pDepthBuffer, pTarget);
+			}, JobSystem::PRIORITY::HIGH
+		);
+	}
+}
+
+void PostProcessor::Bloom(int minY, int maxY)
+{
+	for (int bloomRow{ minY / 2 }; bloomRow <= std::min(maxY / 2, m_BloomHeight - 1); ++bloomRow)
+	{
+		BloomPass(bloomRow);
+	}
+}
+
+void PostProcessor::Composite(int minY, int maxY, const float* pDepthBuffer, SDL_Surface* pTarget) const
+{
+	for (int bloomRow{ minY / 2 }; bloomRow <= std::min(maxY / 2, m_BloomHeight - 1); ++bloomRow)
+	{
+		CompositePass(bloomRow, pDepthBuffer, pTarget);
+	}
+}
+
+void PostProcessor::BloomPass(int bloomRow)
+{
+	const int paddedWidth = m_BloomStride + 2 * BloomRadius;
+
+	thread_local std::vector<float> scratch{};
+	scratch.resize(3 * paddedWidth);
+
+	float* pRed = scratch.data() + BloomRadius;
+	float* pGreen = pRed + paddedWidth;
+	float* pBlue = pGreen + paddedWidth;
+
+	const int y0 = 2 * bloomRow;
+	const int y1 = std::min(2 * bloomRow + 1, m_Height - 1);
+
+	const __m128 threshold = _mm_set1_ps(m_BloomThreshold);
+	const __m128 epsilon = _mm_set1_ps(1e-4f);
+
+	// Downsample and bright pass
+	int bloomX{};
+	for (; bloomX + 4 <= m_BloomWidth && 2 * bloomX + 8 <= m_Width; bloomX += 4)
+	{
+		// 8 pixels starting at a multiple of 8 are one contiguous tile row
+		const int x = 2 * bloomX;
+		const int row0 = m_Layout.GetIndex(x, y0);
+		const int row1 = m_Layout.GetIndex(x, y1);
+		const __m128 red = Downsample(&m_Red[row0], &m_Red[row1]);
+		const __m128 green = Downsample(&m_Green[row0], &m_Green[row1]);
+		const __m128 blue = Downsample(&m_Blue[row0], &m_Blue[row1]);
+
+		// Only the part of the luminance above the threshold blooms
+		const __m128 luminance = Luminance(red, green, blue);
+		const __m128 factor = _mm_div_ps(_mm_max_ps(_mm_sub_ps(luminance, threshold), _mm_setzero_ps()), _mm_max_ps(luminance, epsilon));
+
+		_mm_storeu_ps(pRed + bloomX, _mm_mul_ps(red, factor));
+		_mm_storeu_ps(pGreen + bloomX, _mm_mul_ps(green, factor));
+		_mm_storeu_ps(pBlue + bloomX, _mm_mul_ps(blue, factor));
+	}
+
+	for (; bloomX < m_BloomWidth; ++bloomX)
+	{
+		const int x0 = 2 * bloomX;
+		const int x1 = std::min(x0 + 1, m_Width - 1);
+		const int i00 = m_Layout.GetIndex(x0, y0);
+		const int i10 = m_Layout.GetIndex(x1, y0);
+		const int i01 = m_Layout.GetIndex(x0, y1);
+		const int i11 = m_Layout.GetIndex(x1, y1);
+
+		const float red = (m_Red[i00] + m_Red[i10] + m_Red[i01] + m_Red[i11]) * 0.25f;
+		const float green = (m_Green[i00] + m_Green[i10] + m_Green[i01] + m_Green[i11]) * 0.25f;
+		const float blue = (m_Blue[i00] + m_Blue[i10] + m_Blue[i01] + m_Blue[i11]) * 0.25f;
+
+		const float luminance = 0.2126f * red + 0.7152f * green + 0.0722f * blue;
+		const float factor = std::max(luminance - m_BloomThreshold, 0.f) / std::max(luminance, 1e-4f);
+
+		pRed[bloomX] = red * factor;
+		pGreen[bloomX] = green * factor;
+		pBlue[bloomX] = blue * factor;
+	}
+
+	// Clamp to edge
+	for (int i{ 1 }; i <= BloomRadius; ++i)
+	{
+		pRed[-i] = pRed[0];
+		pGreen[-i] = pGreen[0];
+		pBlue[-i] = pBlue[0];
+	}
+
+	for (int i{ m_BloomWidth }; i < m_BloomStride + BloomRadius; ++i)
+	{
+		pRed[i] = pRed[m_BloomWidth - 1];
+		pGreen[i] = pGreen[m_BloomWidth - 1];
+		pBlue[i] = pBlue[m_BloomWidth - 1];
+	}
+
+	// Horizontal blur
+	float* pOutRed = &m_BloomRed[bloomRow * m_BloomStride];
+	float* pOutGreen = &m_BloomGreen[bloomRow * m_BloomStride];
+	float* pOutBlue = &m_BloomBlue[bloomRow * m_BloomStride];
+
+	for (int x{}; x < m_BloomStride; x += 4)
+	{
+		__m128 red = _mm_setzero_ps();
+		__m128 green = _mm_setzero_ps();
+		__m128 blue = _mm_setzero_ps();
+
+		for (int tap{ -BloomRadius }; tap <= BloomRadius; ++tap)
+		{
+			const __m128 weight = _mm_set1_ps(m_BloomWeights[tap + BloomRadius]);
+			red = _mm_add_ps(red, _mm_mul_ps(_mm_loadu_ps(pRed + x + tap), weight));
+			green = _mm_add_ps(green, _mm_mul_ps(_mm_loadu_ps(pGreen + x + tap), weight));
+			blue = _mm_add_ps(blue, _mm_mul_ps(_mm_loadu_ps(pBlue + x + tap), weight));
+		}
+
+		_mm_storeu_ps(pOutRed + x, red);
+		_mm_storeu_ps(pOutGreen + x, green);
+		_mm_storeu_ps(pOutBlue + x, blue);
+	}
+}
+
+void PostProcessor::CompositePass(int bloomRow, const float* pDepthBuffer, SDL_Surface* pTarget) const
+{
+	thread_local std::vector<float> scratch{};
+	scratch.resize(3 * m_BloomStride);
+
+	float* pBloomRed = scratch.data();
+	float* pBloomGreen = pBloomRed + m_BloomStride;
+	float* pBloomBlue = pBloomGreen + m_BloomStride;
+
+	// Vertical blur of this bloom row, with the bloom strength folded into the weights
+	for (int x{}; x < m_BloomStride; x += 4)
+	{
+		__m128 red = _mm_setzero_ps();
+		__m128 green = _mm_setzero_ps();
+		__m128 blue = _mm_setzero_ps();
+
+		for (int tap{ -BloomRadius }; tap <= BloomRadius; ++tap)
+		{
+			const int index = std::clamp(bloomRow + tap, 0, m_BloomHeight - 1) * m_BloomStride + x;
+			const __m128 weight = _mm_set1_ps(m_BloomWeights[tap + BloomRadius] * m_BloomStrength);
+			red = _mm_add_ps(red, _mm_mul_ps(_mm_loadu_ps(&m_BloomRed[index]), weight));
+			green = _mm_add_ps(green, _mm_mul_ps(_mm_loadu_ps(&m_BloomGreen[index]), weight));
+			blue = _mm_add_ps(blue, _mm_mul_ps(_mm_loadu_ps(&m_BloomBlue[index]), weight));
+		}
+
+		_mm_storeu_ps(pBloomRed + x, red);
+		_mm_storeu_ps(pBloomGreen + x, green);
+		_mm_storeu_ps(pBloomBlue + x, blue);
+	}
+
+	const ResolveConstants constants{ m_Exposure, m_BloomThreshold, pTarget->format->Rshift, pTarget->format->Gshift, pTarget->format->Bshift };
+
+	// Both full resolution rows covered by this bloom row
+	const int endY = std::min(2 * bloomRow + 2, m_Height);
+	for (int y{ 2 * bloomRow }; y < endY; ++y)
+	{
+		uint32_t* pOut = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pTarget->pixels) + y * pTarget->pitch);
+
+		int x{};
+		for (; x + 8 <= m_Width; x += 8)
+		{
+			// Every bloom texel covers two pixels
+			const __m128 bloomRed = _mm_loadu_ps(pBloomRed + x / 2);
+			const __m128 bloomGreen = _mm_loadu_ps(pBloomGreen + x / 2);
+			const __m128 bloomBlue = _mm_loadu_ps(pBloomBlue + x / 2);
+
+			// Contiguous tile row
+			const int index = m_Layout.GetIndex(x, y);
+			ResolveQuad(&m_Red[index], &m_Green[index], &m_Blue[index], &pDepthBuffer[index],
+				_mm_unpacklo_ps(bloomRed, bloomRed), _mm_unpacklo_ps(bloomGreen, bloomGreen), _mm_unpacklo_ps(bloomBlue, bloomBlue),
+				constants, pOut + x);
+			ResolveQuad(&m_Red[index + 4], &m_Green[index + 4], &m_Blue[index + 4], &pDepthBuffer[index + 4],
+				_mm_unpackhi_ps(bloomRed, bloomRed), _mm_unpackhi_ps(bloomGreen, bloomGreen), _mm_unpackhi_ps(bloomBlue, bloomBlue),
+				constants, pOut + x + 4);
+		}
+
+		for (; x < m_Width; ++x)
+		{
+			const int index = m_Layout.GetIndex(x, y);
+			pOut[x] = ResolvePixel(m_Red[index], m_Green[index], m_Blue[index], pDepthBuffer[index],
+				pBloomRed[x / 2], pBloomGreen[x / 2], pBloomBlue[x / 2], constants);
+		}
+	}
+}
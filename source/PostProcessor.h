@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <array>
+#include "ColorRGB.h"
+#include "TiledLayout.h"
+
+struct SDL_Surface;
+class StageProfiler;
+
+/**
+	* Float HDR color target of the software rasterizer plus its post chain
+	* (bright pass, separable gaussian bloom, exposure and ACES tonemap).
+	* The chain runs as two fused passes over half resolution row bands, so
+	* every HDR pixel is read twice and the back buffer is written once.
+	* The HDR planes and the depth buffer passed to Resolve are tile-major
+	* (TiledLayout), the back buffer gets written row-major.
+	*/
+class PostProcessor
+{
+public:
+	static constexpr int BloomRadius{ 6 };
+
+	PostProcessor(int width, int height);
+
+	void Clear(const ColorRGB& color);
+	// Inclusive pixel rect, used when only part of the frame gets re-rendered
+	void Clear(const ColorRGB& color, int minX, int minY, int maxX, int maxY);
+
+	// Index in the TiledLayout of the render size
+	void Write(int pixelIndex, const ColorRGB& color)
+	{
+		m_Red[pixelIndex] = color.r;
+		m_Green[pixelIndex] = color.g;
+		m_Blue[pixelIndex] = color.b;
+	}
+
+	ColorRGB Read(int pixelIndex) const
+	{
+		return { m_Red[pixelIndex], m_Green[pixelIndex], m_Blue[pixelIndex] };
+	}
+
+	// Bloom + tonemap into the 8 bit target, pixels without geometry keep the clear color
+	void Resolve(const float* pDepthBuffer, SDL_Surface* pTarget, StageProfiler& profiler);
+
+	// The two passes of Resolve for the inclusive full resolution rows [minY, maxY] only, minY even.
+	// Composite reads the bloom of BloomRadius half resolution rows around its own, those have to be bloomed first
+	void Bloom(int minY, int maxY);
+	void Composite(int minY, int maxY, const float* pDepthBuffer, SDL_Surface* pTarget) const;
+
+	void SetExposure(float exposure) { m_Exposure = exposure; };
+	void SetBloomThreshold(float threshold) { m_BloomThreshold = threshold; };
+	void SetBloomStrength(float strength) { m_BloomStrength = strength; };
+
+private:
+	int m_Width{};
+	int m_Height{};
+	TiledLayout m_Layout{};
+
+	// Full resolution HDR planes, tile-major
+	std::vector<float> m_Red{};
+	std::vector<float> m_Green{};
+	std::vector<float> m_Blue{};
+
+	// Half resolution, bright passed and horizontally blurred, rows padded to a multiple of 4
+	int m_BloomWidth{};
+	int m_BloomHeight{};
+	int m_BloomStride{};
+	std::vector<float> m_BloomRed{};
+	std::vector<float> m_BloomGreen{};
+	std::vector<float> m_BloomBlue{};
+
+	std::array<float, 2 * BloomRadius + 1> m_BloomWeights{};
+
+	float m_Exposure{ 1.f };
+	float m_BloomThreshold{ 1.f };
+	float m_BloomStrength{ 0.25f };
+
+	void BloomPass(int bloomRow);
+	void CompositePass(int bloomRow, const float* pDepthBuffer, SDL_Surface* pTarget) const;
+};
@@ -0,0 +1,306 @@
+#include "pch.h"
+#include "RayTracedVisibility.h"
+#include "Bvh.h"
+#include "DirtyTileMap.h"
+#include "SimdDispatch.h"
+
+namespace
+{
+	// Radical inverse of index in base, low discrepancy points for the occlusion rays
+	float Halton(int index, int base)
+	{
+		float result{};
+		float fraction{ 1.f / base };
+
+		while (index > 0)
+		{
+			result += (index % base) * fraction;
+			index /= base;
+			fraction /= base;
+		}
+
+		return result;
+	}
+
+	// Integer hash to [0, 1), rotates the Halton points per pixel so neighbours sample different directions
+	float HashToUnit(uint32_t value)
+	{
+		value ^= value >> 16;
+		value *= 0x7feb352dU;
+		value ^= value >> 15;
+		value *= 0x846ca68bU;
+		value ^= value >> 16;
+
+		return static_cast<float>(value >> 8) * (1.f / 16777216.f);
+	}
+
+	float Fraction(float value)
+	{
+		return value - floorf(value);
+	}
+}
+
+RayTracedVisibility::RayTracedVisibility(const Bvh& bvh, const TiledLayout& layout)
+	: m_Bvh{ bvh }
+	, m_Layout{ layout }
+{
+	// Unlit until traced, nothing reads a pixel that was not
+	m_LightVisibility.resize(m_Layout.GetPixelCount(), 1.f);
+	m_AmbientOcclusion.resize(m_Layout.GetPixelCount(), 1.f);
+
+	if (m_Bvh.GetTriangleCount() > 0)
+	{
+		const BvhNode& root = m_Bvh.GetNodes()[0];
+		const Vector3 diagonal{ root.boundsMax[0] - root.boundsMin[0], root.boundsMax[1] - root.boundsMin[1], root.boundsMax[2] - root.boundsMin[2] };
+		m_AmbientOcclusionRadius = diagonal.Magnitude() * AmbientOcclusionRadiusScale;
+	}
+}
+
+void RayTracedVisibility::Prepare(const Matrix& worldMatrix, const Matrix& viewMatrix, const Matrix& projectionMatrix, const Vector3& lightDirection,
+	bool isShadowTraced, int ambientOcclusionSampleCount, int accumulatedFrames)
+{
+	m_IsShadowTraced = isShadowTraced;
+	m_AmbientOcclusionSampleCount = ambientOcclusionSampleCount;
+	m_AccumulatedFrames = accumulatedFrames;
+
+	// The rows of the inverse view matrix are the camera basis, the projection scales x and y by the field of view
+	const Matrix inverseWorldMatrix = Matrix::Inverse(worldMatrix);
+	const Matrix inverseViewMatrix = Matrix::Inverse(viewMatrix);
+
+	m_Origin = inverseWorldMatrix.TransformPoint(inverseViewMatrix[3].GetXYZ());
+	m_Forward = inverseWorldMatrix.TransformVector(inverseViewMatrix[2].GetXYZ());
+	m_Right = inverseWorldMatrix.TransformVector(inverseViewMatrix[0].GetXYZ() / projectionMatrix[0].x);
+	m_Up = inverseWorldMatrix.TransformVector(inverseViewMatrix[1].GetXYZ() / projectionMatrix[1].y);
+	m_TowardsLight = inverseWorldMatrix.TransformVector(-lightDirection).Normalized();
+
+	m_DepthScale = projectionMatrix[3].z;
+	m_DepthBias = projectionMatrix[2].z;
+
+	// Neighbouring pixels are 2 / width apart in x
+	m_RayOffsetPerDepth = RayOffsetPixels * 2.f * m_Right.Magnitude() / m_Layout.GetWidth();
+}
+
+void RayTracedVisibility::TraceRect(const float* pDepth, const DirtyTileMap& dirtyTiles, int minX, int minY, int maxX, int maxY)
+{
+	// Converged, the result of the previous frames stays
+	const bool isTracingOcclusion = m_AmbientOcclusionSampleCount > 0 && m_AccumulatedFrames < MaxAccumulatedFrames;
+	if (m_AccumulatedFrames > 0 && !isTracingOcclusion)
+	{
+		return;
+	}
+
+	static_assert(DirtyTileMap::TileSize % BlockSize == 0);
+	static_assert(BlockSize * BlockSize <= RayPacket::Capacity);
+
+	for (int tileY{ minY }; tileY <= maxY; tileY += DirtyTileMap::TileSize)
+	{
+		for (int tileX{ minX }; tileX <= maxX; tileX += DirtyTileMap::TileSize)
+		{
+			if (!dirtyTiles.IsTileDirty(tileX, tileY))
+			{
+				continue;
+			}
+
+			const int tileMaxX = std::min(tileX + DirtyTileMap::TileSize - 1, maxX);
+			const int tileMaxY = std::min(tileY + DirtyTileMap::TileSize - 1, maxY);
+
+			for (int blockY{ tileY }; blockY <= tileMaxY; blockY += BlockSize)
+			{
+				for (int blockX{ tileX }; blockX <= tileMaxX; blockX += BlockSize)
+				{
+					TraceBlock(pDepth, blockX, blockY, minX, minY, maxX, maxY);
+				}
+			}
+		}
+	}
+}
+
+void RayTracedVisibility::TraceBlock(const float* pDepth, int blockX, int blockY, int minX, int minY, int maxX, int maxY)
+{
+	int pixelIndices[RayPacket::Capacity]{};
+	Vector3 origins[RayPacket::Capacity]{};
+	Vector3 normals[RayPacket::Capacity]{};
+	int pixelX[RayPacket::Capacity]{};
+	int pixelY[RayPacket::Capacity]{};
+	int pixelCount{};
+
+	// Covered pixels only, the ray starts off the surface by about a pixel so the depth precision can not put it below
+	for (int py{ blockY }; py <= std::min(blockY + BlockSize - 1, maxY); ++py)
+	{
+		for (int px{ blockX }; px <= std::min(blockX + BlockSize - 1, maxX); ++px)
+		{
+			const int pixelIndex = m_Layout.GetIndex(px, py);
+			const float depth = pDepth[pixelIndex];
+			if (depth > 1.f)
+			{
+				continue;
+			}
+
+			const Vector3 position = GetPosition(px, py, depth);
+			const Vector3 normal = GetNormal(pDepth, px, py, depth, position, minX, minY, maxX, maxY);
+			const float viewDepth = m_DepthScale / (depth - m_DepthBias);
+
+			const int pixel = pixelCount++;
+			pixelIndices[pixel] = pixelIndex;
+			normals[pixel] = normal;
+			origins[pixel] = position + normal * (viewDepth * m_RayOffsetPerDepth);
+			pixelX[pixel] = px;
+			pixelY[pixel] = py;
+		}
+	}
+
+	if (pixelCount == 0)
+	{
+		return;
+	}
+
+	// The shadows only change with the geometry, the light or the camera
+	if (m_IsShadowTraced && m_AccumulatedFrames == 0)
+	{
+		RayPacket shadow{};
+		int shadowPixels[RayPacket::Capacity]{};
+
+		for (int pixel{}; pixel < pixelCount; ++pixel)
+		{
+			// Whatever faces away from the light is in its own shadow
+			if (Vector3::Dot(normals[pixel], m_TowardsLight) <= 0.f)
+			{
+				m_LightVisibility[pixelIndices[pixel]] = 0.f;
+				continue;
+			}
+
+			const int lane = shadow.count++;
+			shadowPixels[lane] = pixel;
+			shadow.originX[lane] = origins[pixel].x;
+			shadow.originY[lane] = origins[pixel].y;
+			shadow.originZ[lane] = origins[pixel].z;
+			shadow.directionX[lane] = m_TowardsLight.x;
+			shadow.directionY[lane] = m_TowardsLight.y;
+			shadow.directionZ[lane] = m_TowardsLight.z;
+			shadow.distance[lane] = FLT_MAX;
+		}
+
+		if (shadow.count > 0)
+		{
+			SIMD_KERNELS.TraceRays(m_Bvh.GetNodes(), m_Bvh.GetTriangles(), shadow, true);
+
+			for (int lane{}; lane < shadow.count; ++lane)
+			{
+				m_LightVisibility[pixelIndices[shadowPixels[lane]]] = shadow.primitive[lane] < 0 ? 1.f : 0.f;
+			}
+		}
+	}
+
+	if (m_AmbientOcclusionSampleCount == 0 || m_AccumulatedFrames >= MaxAccumulatedFrames)
+	{
+		return;
+	}
+
+	// One packet per sample, the same sample of neighbouring pixels points roughly the same way
+	int openCounts[RayPacket::Capacity]{};
+
+	for (int sample{}; sample < m_AmbientOcclusionSampleCount; ++sample)
+	{
+		const int sequenceIndex = m_AccumulatedFrames * m_AmbientOcclusionSampleCount + sample + 1;
+		const float haltonU = Halton(sequenceIndex, 2);
+		const float haltonV = Halton(sequenceIndex, 3);
+
+		RayPacket occlusion{};
+		for (int pixel{}; pixel < pixelCount; ++pixel)
+		{
+			const uint32_t pixelHash = static_cast<uint32_t>(pixelY[pixel]) * 7919u + static_cast<uint32_t>(pixelX[pixel]);
+			const float u = Fraction(haltonU + HashToUnit(pixelHash));
+			const float v = Fraction(haltonV + HashToUnit(pixelHash ^ 0x9e3779b9u));
+
+			// Cosine weighted, so the open fraction of the rays is the occlusion term of the diffuse sky light
+			const Vector3& normal = normals[pixel];
+			const float sign = normal.z >= 0.f ? 1.f : -1.f;
+			const float a = -1.f / (sign + normal.z);
+			const float b = normal.x * normal.y * a;
+			const Vector3 tangent{ 1.f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x };
+			const Vector3 bitangent{ b, sign + normal.y * normal.y * a, -normal.y };
+
+			const float radius = sqrtf(u);
+			const float angle = v * 2.f * PI;
+			const Vector3 direction = tangent * (radius * cosf(angle)) + bitangent * (radius * sinf(angle)) + normal * sqrtf(std::max(1.f - u, 0.f));
+
+			const int lane = occlusion.count++;
+			occlusion.originX[lane] = origins[pixel].x;
+			occlusion.originY[lane] = origins[pixel].y;
+			occlusion.originZ[lane] = origins[pixel].z;
+			occlusion.directionX[lane] = direction.x;
+			occlusion.directionY[lane] = direction.y;
+			occlusion.directionZ[lane] = direction.z;
+			occlusion.distance[lane] = m_AmbientOcclusionRadius;
+		}
+
+		SIMD_KERNELS.TraceRays(m_Bvh.GetNodes(), m_Bvh.GetTriangles(), occlusion, true);
+
+		for (int lane{}; lane < occlusion.count; ++lane)
+		{
+			openCounts[lane] += occlusion.primitive[lane] < 0 ? 1 : 0;
+		}
+	}
+
+	// Running average over the frames the scene stood still
+	const float weight = 1.f / (m_AccumulatedFrames + 1);
+	for (int pixel{}; pixel < pixelCount; ++pixel)
+	{
+		const float occlusion = static_cast<float>(openCounts[pixel]) / m_AmbientOcclusionSampleCount;
+		float& average = m_AmbientOcclusion[pixelIndices[pixel]];
+		average = m_AccumulatedFrames == 0 ? occlusion : average + (occlusion - average) * weight;
+	}
+}
+
+Vector3 RayTracedVisibility::GetPosition(int px, int py, float depth) const
+{
+	// The rasterizer samples at the integer pixel coordinates
+	const float x = 2.f * px / m_Layout.GetWidth() - 1.f;
+	const float y = 1.f - 2.f * py / m_Layout.GetHeight();
+	const float viewDepth = m_DepthScale / (depth - m_DepthBias);
+
+	return m_Origin + (m_Forward + m_Right * x + m_Up * y) * viewDepth;
+}
+
+Vector3 RayTracedVisibility::GetNormal(const float* pDepth, int px, int py, float depth, const Vector3& position, int minX, int minY, int maxX, int maxY) const
+{
+	// The neighbour with the closer depth lies on the same surface more likely, the other side can be across an edge
+	const auto getTangent = [&](int stepX, int stepY, Vector3& tangent)
+		{
+			float bestDifference{ FLT_MAX };
+
+			for (int side : { -1, 1 })
+			{
+				const int x = px + stepX * side;
+				const int y = py + stepY * side;
+				if (x < minX || x > maxX || y < minY || y > maxY)
+				{
+					continue;
+				}
+
+				const float neighbourDepth = pDepth[m_Layout.GetIndex(x, y)];
+				const float difference = fabsf(neighbourDepth - depth);
+				if (neighbourDepth > 1.f || difference >= bestDifference)
+				{
+					continue;
+				}
+
+				bestDifference = difference;
+				tangent = (GetPosition(x, y, neighbourDepth) - position) * static_cast<float>(side);
+			}
+
+			return bestDifference != FLT_MAX;
+		};
+
+	const Vector3 towardsCamera = m_Origin - position;
+
+	Vector3 tangentX{}, tangentY{};
+	if (!getTangent(1, 0, tangentX) || !getTangent(0, 1, tangentY))
+	{
+		// A lone pixel, facing the camera is the best guess
+		return towardsCamera.Normalized();
+	}
+
+	const Vector3 normal = Vector3::Cross(tangentX, tangentY).Normalized();
+	return Vector3::Dot(normal, towardsCamera) < 0.f ? -normal : normal;
+}
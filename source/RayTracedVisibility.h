@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include "Math.h"
+#include "TiledLayout.h"
+
+class Bvh;
+class DirtyTileMap;
+
+/**
+	* Hybrid ray traced shadows and ambient occlusion for the software rasterizer.
+	* Once the depth prepass of a tile is done, the position of every covered pixel
+	* comes back from its depth and the normal from the depths next to it. Blocks of
+	* BlockSize x BlockSize pixels then trace their shadow rays towards the directional
+	* light and their occlusion rays as RayPackets against the BVH of the opaque mesh.
+	* The shading pass reads the result instead of the shadow map, so there is no
+	* resolution, bias or light frustum to tune.
+	* While the mesh and the camera stand still the shadows are kept, and every frame
+	* adds its occlusion rays to the running average until MaxAccumulatedFrames.
+	*/
+class RayTracedVisibility
+{
+public:
+	static constexpr int BlockSize{ 4 };
+	// Frames of occlusion rays averaged before a still image stops tracing
+	static constexpr int MaxAccumulatedFrames{ 16 };
+
+	RayTracedVisibility(const Bvh& bvh, const TiledLayout& layout);
+
+	// Once per frame before the tiles trace. accumulatedFrames is 0 when anything moved, the shadows
+	// are only traced then, later frames only add occlusion rays
+	void Prepare(const Matrix& worldMatrix, const Matrix& viewMatrix, const Matrix& projectionMatrix, const Vector3& lightDirection,
+		bool isShadowTraced, int ambientOcclusionSampleCount, int accumulatedFrames);
+
+	// Traces the dirty pixels of an inclusive rect that covers whole blocks, the depth of the rect has to be final.
+	// Only reads the depth inside the rect, so the tiles can trace in parallel
+	void TraceRect(const float* pDepth, const DirtyTileMap& dirtyTiles, int minX, int minY, int maxX, int maxY);
+
+	// Fraction of the directional light that reaches the pixel
+	float GetLightVisibility(int pixelIndex) const { return m_LightVisibility[pixelIndex]; };
+	// Fraction of the hemisphere above the pixel that is open within the occlusion radius
+	float GetAmbientOcclusion(int pixelIndex) const { return m_AmbientOcclusion[pixelIndex]; };
+
+private:
+	// Both relative to the mesh, the occlusion radius to the diagonal of its bounds,
+	// the ray offset to the size of a pixel at the depth of the surface
+	static constexpr float AmbientOcclusionRadiusScale{ 0.1f };
+	static constexpr float RayOffsetPixels{ 1.5f };
+
+	const Bvh& m_Bvh;
+	TiledLayout m_Layout{};
+
+	std::vector<float> m_LightVisibility{};
+	std::vector<float> m_AmbientOcclusion{};
+
+	// The camera and the light in the object space of the BVH. A pixel at depth z sits at
+	// origin + (forward + right * x + up * y) * viewDepth with x, y its raster position in [-1, 1]
+	Vector3 m_Origin{};
+	Vector3 m_Forward{};
+	Vector3 m_Right{};
+	Vector3 m_Up{};
+	Vector3 m_TowardsLight{};
+	// View depth from the depth buffer, viewDepth = m_DepthScale / (z - m_DepthBias)
+	float m_DepthScale{};
+	float m_DepthBias{};
+	float m_RayOffsetPerDepth{};
+	float m_AmbientOcclusionRadius{};
+
+	bool m_IsShadowTraced{};
+	int m_AmbientOcclusionSampleCount{};
+	int m_AccumulatedFrames{};
+
+	void TraceBlock(const float* pDepth, int blockX, int blockY, int minX, int minY, int maxX, int maxY);
+
+	Vector3 GetPosition(int px, int py, float depth) const;
+	// Surface normal from the neighbours on the flattest side of each axis, facing the camera
+	Vector3 GetNormal(const float* pDepth, int px, int py, float depth, const Vector3& position, int minX, int minY, int maxX, int maxY) const;
+};
@@ -0,0 +1,374 @@
+#include "pch.h"
+#include "RayTracer.h"
+#include "SDL.h"
+#include "SDL_surface.h"
+#include "Texture.h"
+#include "Shading.h"
+#include "RenderConfig.h"
+#include "JobSystem.h"
+#include "SimdDispatch.h"
+#include "FastMath.h"
+
+namespace
+{
+	// Radius of the light disk in radians, a wider sun than the real one so the penumbras show
+	constexpr float LightAngularRadius{ 0.03f };
+	// Shadow rays start this far off the surface, in object space
+	constexpr float ShadowRayOffset{ 0.01f };
+
+	// Radical inverse of index in base, low discrepancy points for the samples
+	float Halton(int index, int base)
+	{
+		float result{};
+		float fraction{ 1.f / base };
+
+		while (index > 0)
+		{
+			result += (index % base) * fraction;
+			index /= base;
+			fraction /= base;
+		}
+
+		return result;
+	}
+}
+
+RayTracer::RayTracer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes, const IrradianceSH& skyIrradiance)
+	: BaseRenderer(pWindow, pCamera)
+	, m_pMeshes{ pMeshes }
+	, m_SkyIrradiance{ skyIrradiance }
+{
+	m_RendererColor = ColorRGB{ 0.39f * 255.f, 0.39f * 255.f, 0.39f * 255 };
+	m_UniformColor = ColorRGB{ 0.1f * 255.f, 0.1f * 255.f, 0.1f * 255 };
+	m_CurrentColor = m_RendererColor;
+
+	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
+	m_Accumulation.resize(static_cast<size_t>(m_Width) * m_Height);
+
+	// The thruster is transparent, only the vehicle gets traced
+	const MeshData& mesh = *m_pMeshes[0];
+	std::vector<Vector3> positions(mesh.vertices.size());
+	for (size_t index{}; index < mesh.vertices.size(); ++index)
+	{
+		positions[index] = mesh.vertices[index].position;
+	}
+
+	const uint64_t startCounter = SDL_GetPerformanceCounter();
+	m_pBvh = new Bvh();
+	m_pBvh->Build(positions, mesh.indices);
+	const float milliseconds = static_cast<float>(SDL_GetPerformanceCounter() - startCounter) * 1000.f / SDL_GetPerformanceFrequency();
+
+	std::cout << "\033[36m"; // TEXT COLOR
+	std::cout << "[RT] BVH of " << m_pBvh->GetTriangleCount() << " triangles, " << m_pBvh->GetNodeCount() << " nodes, built in " << milliseconds << " ms" << std::endl;
+	std::cout << "\033[37m"; // TEXT COLOR WHITE
+}
+
+RayTracer::~RayTracer()
+{
+	delete m_pBvh;
+}
+
+void RayTracer::Update(Timer* pTimer)
+{
+	m_Profiler.Update(pTimer->GetElapsed());
+
+	if (RENDER_CONFIG->ShouldRotate())
+	{
+		for (MeshData* mesh : m_pMeshes)
+		{
+			// 1 deg per second
+			const float degreesPerSecond = RENDER_CONFIG->GetRotationSpeed();
+			mesh->AddRotationY((degreesPerSecond * pTimer->GetElapsed()) * TO_RADIANS);
+		}
+	}
+}
+
+bool RayTracer::HasPendingFrames() const
+{
+	return m_SampleCount < MaxSampleCount;
+}
+
+RayTracer::SceneState RayTracer::CaptureSceneState() const
+{
+	SceneState state{};
+	state.worldMatrix = m_pMeshes[0]->worldMatrix;
+	state.viewMatrix = m_pCamera->viewMatrix;
+	state.projectionMatrix = m_pCamera->projectionMatrix;
+	state.backgroundColor = m_CurrentColor;
+	state.shouldRenderNormalMap = RENDER_CONFIG->ShouldRenderNormalMap();
+	state.isFastMath = RENDER_CONFIG->GetCurrentMathQuality() == RenderConfig::MATH_QUALITY::APPROXIMATE;
+
+	return state;
+}
+
+bool RayTracer::HasSceneChanged(const SceneState& state) const
+{
+	const SceneState& previous = m_AccumulatedState;
+
+	return !(state.worldMatrix == previous.worldMatrix)
+		|| !(state.viewMatrix == previous.viewMatrix)
+		|| !(state.projectionMatrix == previous.projectionMatrix)
+		|| state.backgroundColor.r != previous.backgroundColor.r
+		|| state.backgroundColor.g != previous.backgroundColor.g
+		|| state.backgroundColor.b != previous.backgroundColor.b
+		|| state.shouldRenderNormalMap != previous.shouldRenderNormalMap
+		|| state.isFastMath != previous.isFastMath;
+}
+
+void RayTracer::Render()
+{
+	// call to base render function for uniform color changes
+	BaseRenderer::Render();
+
+	StageProfiler::ScopedStage stage{ m_Profiler, "Trace" };
+
+	const SceneState state = CaptureSceneState();
+	if (m_SampleCount == 0 || HasSceneChanged(state))
+	{
+		std::fill(m_Accumulation.begin(), m_Accumulation.end(), ColorRGB{});
+		m_SampleCount = 0;
+		m_AccumulatedState = state;
+	}
+
+	// A converged image only gets resolved again, another renderer can have drawn over it
+	SampleContext context{};
+	context.state = state;
+	context.isTracing = m_SampleCount < MaxSampleCount;
+	context.inverseSampleCount = 1.f / (context.isTracing ? m_SampleCount + 1 : m_SampleCount);
+	context.inverseWorldMatrix = Matrix::Inverse(state.worldMatrix);
+
+	context.origin = m_pCamera->origin;
+	context.forward = m_pCamera->forward;
+	context.right = m_pCamera->right * (m_pCamera->aspectRatio * m_pCamera->fov);
+	context.up = m_pCamera->up * m_pCamera->fov;
+
+	// The first sample looks through the pixel centers at the center of the light
+	Vector2 lightOffset{};
+	if (m_SampleCount == 0)
+	{
+		context.pixelOffset = Vector2{ 0.5f, 0.5f };
+	}
+	else
+	{
+		context.pixelOffset = Vector2{ Halton(m_SampleCount, 2), Halton(m_SampleCount, 3) };
+
+		// Uniform over the disk of the light
+		const float radius = sqrtf(Halton(m_SampleCount, 5)) * LightAngularRadius;
+		const float angle = Halton(m_SampleCount, 7) * 2.f * PI;
+		lightOffset = Vector2{ radius * cosf(angle), radius * sinf(angle) };
+	}
+
+	const Vector3 towardsLight = -Shading::LightDirection;
+	const Vector3 lightTangent = Vector3::Cross(Vector3::UnitY, towardsLight).Normalized();
+	const Vector3 lightBitangent = Vector3::Cross(towardsLight, lightTangent);
+	const Vector3 sampleLightDirection = (towardsLight + lightTangent * lightOffset.x + lightBitangent * lightOffset.y).Normalized();
+	context.lightDirection = context.inverseWorldMatrix.TransformVector(sampleLightDirection);
+
+	SDL_LockSurface(m_pFrontBuffer);
+
+	const int tilesX = (m_Width + TileSize - 1) / TileSize;
+	const int tilesY = (m_Height + TileSize - 1) / TileSize;
+	JOB_SYSTEM->ParallelFor(0, tilesX * tilesY, [&](int tileIndex)
+		{
+			RenderTile(tileIndex, tilesX, context);
+		});
+
+	SDL_UnlockSurface(m_pFrontBuffer);
+	SDL_UpdateWindowSurface(m_pWindow);
+
+	if (context.isTracing)
+	{
+		++m_SampleCount;
+	}
+}
+
+void RayTracer::RenderTile(int tileIndex, int tilesX, const SampleContext& context)
+{
+	const int minX = (tileIndex % tilesX) * TileSize;
+	const int minY = (tileIndex / tilesX) * TileSize;
+	const int maxX = std::min(minX + TileSize, m_Width);
+	const int maxY = std::min(minY + TileSize, m_Height);
+
+	for (int packetY{ minY }; packetY < maxY; packetY += PacketSize)
+	{
+		for (int packetX{ minX }; packetX < maxX; packetX += PacketSize)
+		{
+			RenderPacket(packetX, packetY, context);
+		}
+	}
+}
+
+void RayTracer::RenderPacket(int minX, int minY, const SampleContext& context)
+{
+	const int maxX = std::min(minX + PacketSize, m_Width);
+	const int maxY = std::min(minY + PacketSize, m_Height);
+
+	if (context.isTracing)
+	{
+		// Primary rays in object space, the world matrix only rotates and translates so the distances stay the same
+		RayPacket primary{};
+		int pixelIndices[RayPacket::Capacity]{};
+		Vector3 viewDirections[RayPacket::Capacity]{};
+		const Vector3 objectOrigin = context.inverseWorldMatrix.TransformPoint(context.origin);
+
+		for (int py{ minY }; py < maxY; ++py)
+		{
+			for (int px{ minX }; px < maxX; ++px)
+			{
+				const float x = 2.f * (px + context.pixelOffset.x) / m_Width - 1.f;
+				const float y = 1.f - 2.f * (py + context.pixelOffset.y) / m_Height;
+				const Vector3 direction = context.forward + context.right * x + context.up * y;
+				const Vector3 objectDirection = context.inverseWorldMatrix.TransformVector(direction);
+
+				const int lane = primary.count++;
+				pixelIndices[lane] = py * m_Width + px;
+				viewDirections[lane] = context.state.isFastMath ? FastMath::Normalized(direction) : direction.Normalized();
+
+				primary.originX[lane] = objectOrigin.x;
+				primary.originY[lane] = objectOrigin.y;
+				primary.originZ[lane] = objectOrigin.z;
+				primary.directionX[lane] = objectDirection.x;
+				primary.directionY[lane] = objectDirection.y;
+				primary.directionZ[lane] = objectDirection.z;
+				// Forward has unit length, so the distance is the view depth like the far plane of the rasterizers
+				primary.distance[lane] = Camera::FarPlane;
+			}
+		}
+
+		SIMD_KERNELS.TraceRays(m_pBvh->GetNodes(), m_pBvh->GetTriangles(), primary, false);
+
+		// Shadow rays for the hits that face the light, whatever faces away is in its own shadow
+		RayPacket shadow{};
+		int shadowLanes[RayPacket::Capacity]{};
+		float lightVisibility[RayPacket::Capacity]{};
+
+		for (int lane{}; lane < primary.count; ++lane)
+		{
+			if (primary.primitive[lane] < 0)
+			{
+				continue;
+			}
+
+			const Vector3 direction{ primary.directionX[lane], primary.directionY[lane], primary.directionZ[lane] };
+			Vector3 faceNormal = GetFaceNormal(primary.primitive[lane]);
+
+			// Both sides of a triangle can be hit, lift the ray off the side it was seen from
+			if (Vector3::Dot(faceNormal, direction) > 0.f)
+			{
+				faceNormal = -faceNormal;
+			}
+
+			if (Vector3::Dot(faceNormal, context.lightDirection) <= 0.f)
+			{
+				continue;
+			}
+
+			const Vector3 position = Vector3{ primary.originX[lane], primary.originY[lane], primary.originZ[lane] } + direction * primary.distance[lane];
+			const Vector3 origin = position + faceNormal * ShadowRayOffset;
+
+			const int shadowLane = shadow.count++;
+			shadowLanes[shadowLane] = lane;
+			shadow.originX[shadowLane] = origin.x;
+			shadow.originY[shadowLane] = origin.y;
+			shadow.originZ[shadowLane] = origin.z;
+			shadow.directionX[shadowLane] = context.lightDirection.x;
+			shadow.directionY[shadowLane] = context.lightDirection.y;
+			shadow.directionZ[shadowLane] = context.lightDirection.z;
+			shadow.distance[shadowLane] = FLT_MAX;
+		}
+
+		if (shadow.count > 0)
+		{
+			SIMD_KERNELS.TraceRays(m_pBvh->GetNodes(), m_pBvh->GetTriangles(), shadow, true);
+
+			for (int shadowLane{}; shadowLane < shadow.count; ++shadowLane)
+			{
+				lightVisibility[shadowLanes[shadowLane]] = shadow.primitive[shadowLane] < 0 ? 1.f : 0.f;
+			}
+		}
+
+		const ColorRGB backgroundColor = context.state.backgroundColor / 255.f;
+		for (int lane{}; lane < primary.count; ++lane)
+		{
+			m_Accumulation[pixelIndices[lane]] += primary.primitive[lane] < 0
+				? backgroundColor
+				: ShadeHit(primary, lane, viewDirections[lane], lightVisibility[lane], context);
+		}
+	}
+
+	// Average of the samples so far
+	uint32_t* pPixels = static_cast<uint32_t*>(m_pFrontBuffer->pixels);
+	const int pixelsPerRow = m_pFrontBuffer->pitch / static_cast<int>(sizeof(uint32_t));
+
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		for (int px{ minX }; px < maxX; ++px)
+		{
+			ColorRGB color = m_Accumulation[py * m_Width + px] * context.inverseSampleCount;
+			color.MaxToOne();
+
+			pPixels[py * pixelsPerRow + px] = SDL_MapRGB(m_pFrontBuffer->format,
+				static_cast<uint8_t>(color.r * 255),
+				static_cast<uint8_t>(color.g * 255),
+				static_cast<uint8_t>(color.b * 255));
+		}
+	}
+}
+
+ColorRGB RayTracer::ShadeHit(const RayPacket& packet, int lane, const Vector3& viewDirection, float lightVisibility, const SampleContext& context) const
+{
+	const bool isFastMath = context.state.isFastMath;
+	const Matrix& worldMatrix = context.state.worldMatrix;
+
+	const MeshData& mesh = *m_pMeshes[0];
+	const int primitive = packet.primitive[lane];
+	const uint32_t index0 = mesh.indices[primitive * 3];
+	const uint32_t index1 = mesh.indices[primitive * 3 + 1];
+	const uint32_t index2 = mesh.indices[primitive * 3 + 2];
+	const Vertex& vertex0 = mesh.vertices[index0];
+	const Vertex& vertex1 = mesh.vertices[index1];
+	const Vertex& vertex2 = mesh.vertices[index2];
+
+	const float weight1 = packet.u[lane];
+	const float weight2 = packet.v[lane];
+	const float weight0 = 1.f - weight1 - weight2;
+
+	Vector2 uv = vertex0.uv * weight0 + vertex1.uv * weight1 + vertex2.uv * weight2;
+	uv.x = std::clamp(uv.x, 0.f, 1.f);
+	uv.y = std::clamp(uv.y, 0.f, 1.f);
+
+	const Vector3 interpolatedNormal = worldMatrix.TransformVector(vertex0.normal * weight0 + vertex1.normal * weight1 + vertex2.normal * weight2);
+	const Vector3 vertexNormal = isFastMath ? FastMath::Normalized(interpolatedNormal) : interpolatedNormal.Normalized();
+
+	// Every loaded normal map gets baked to object space, the rotation of the mesh is all it needs
+	Vector3 normal = vertexNormal;
+	if (context.state.shouldRenderNormalMap && mesh.isNormalMapObjectSpace)
+	{
+		const Vector2 normalMapUV = mesh.normalMapUV[index0] * weight0 + mesh.normalMapUV[index1] * weight1 + mesh.normalMapUV[index2] * weight2;
+		const ColorRGB normalColor = mesh.textures[1]->Sample(normalMapUV);
+
+		const Vector3 normalSample = worldMatrix.TransformVector(2.f * normalColor.r - 1.f, 2.f * normalColor.g - 1.f, 2.f * normalColor.b - 1.f);
+		normal = isFastMath ? FastMath::Normalized(normalSample) : normalSample.Normalized();
+	}
+
+	const float lambertCosine = std::max(Vector3::Dot(normal, -Shading::LightDirection), 0.f) * lightVisibility;
+
+	const ColorRGB color = mesh.textures[0]->Sample(uv);
+	const ColorRGB specularColor = mesh.textures[2]->Sample(uv);
+	const ColorRGB glossinessColor = mesh.textures[3]->Sample(uv);
+
+	// The combined mode of the rasterizer, without the point lights
+	return Shading::Combined(color, specularColor, glossinessColor, viewDirection, vertexNormal, lambertCosine,
+		m_SkyIrradiance.Evaluate(normal), ColorRGB{}, isFastMath);
+}
+
+Vector3 RayTracer::GetFaceNormal(int primitive) const
+{
+	const MeshData& mesh = *m_pMeshes[0];
+	const Vector3& position0 = mesh.vertices[mesh.indices[primitive * 3]].position;
+	const Vector3& position1 = mesh.vertices[mesh.indices[primitive * 3 + 1]].position;
+	const Vector3& position2 = mesh.vertices[mesh.indices[primitive * 3 + 2]].position;
+
+	return Vector3::Cross(position1 - position0, position2 - position0).Normalized();
+}
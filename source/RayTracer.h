@@ -0,0 +1,93 @@
+#pragma once
+#include "BaseRenderer.h"
+#include "DataTypes.h"
+#include "Camera.h"
+#include "Timer.h"
+#include "Mesh.h"
+#include "StageProfiler.h"
+#include "SphericalHarmonics.h"
+
+struct SDL_Surface;
+struct RayPacket;
+class Bvh;
+
+/**
+	* Software ray tracing backend on the BVH of the opaque mesh. Every 4x4 block of
+	* pixels traces its primary rays as one RayPacket, then the shadow rays towards the
+	* directional light of the lit ones, and shades the hits with the materials and
+	* lights of SHADING_MODE::COMBINED. Tiles run on the JobSystem.
+	* The BVH is built once in object space, the rays get transformed into it, so the
+	* rotating mesh never needs a rebuild.
+	* While nothing changes every frame adds a sample with another subpixel position
+	* and another point on the light, the average converges to an antialiased image
+	* with soft shadows after MaxSampleCount frames.
+	*/
+class RayTracer : public BaseRenderer
+{
+public:
+	RayTracer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes, const IrradianceSH& skyIrradiance);
+	virtual ~RayTracer() override;
+
+	virtual void Update(Timer* pTimer) override;
+	virtual void Render() override;
+	// Still converging
+	virtual bool HasPendingFrames() const override;
+
+private:
+	static constexpr int TileSize{ 16 };
+	static constexpr int PacketSize{ 4 };
+	static constexpr int MaxSampleCount{ 64 };
+
+	SDL_Surface* m_pFrontBuffer{ nullptr };
+
+	std::vector<MeshData*> m_pMeshes{};
+	Bvh* m_pBvh{};
+	IrradianceSH m_SkyIrradiance{};
+
+	StageProfiler m_Profiler{ "RT" };
+
+	// Sum of the samples per pixel and what they were rendered with
+	std::vector<ColorRGB> m_Accumulation{};
+	int m_SampleCount{};
+
+	// Everything that decides what the image looks like, a change restarts the accumulation
+	struct SceneState
+	{
+		Matrix worldMatrix{};
+		Matrix viewMatrix{};
+		Matrix projectionMatrix{};
+		ColorRGB backgroundColor{};
+		bool shouldRenderNormalMap{};
+		bool isFastMath{};
+	};
+	SceneState m_AccumulatedState{};
+
+	// Shared by all tiles of one sample
+	struct SampleContext
+	{
+		SceneState state{};
+		Matrix inverseWorldMatrix{};
+		// Camera ray of a pixel: origin + forward + right * x + up * y with x, y the pixel in [-1, 1]
+		Vector3 origin{};
+		Vector3 forward{};
+		Vector3 right{};
+		Vector3 up{};
+		Vector2 pixelOffset{};
+		// Towards the light in object space, moved over the disk of the light per sample
+		Vector3 lightDirection{};
+		// A converged image only gets resolved
+		bool isTracing{};
+		float inverseSampleCount{};
+	};
+
+	SceneState CaptureSceneState() const;
+	bool HasSceneChanged(const SceneState& state) const;
+
+	void RenderTile(int tileIndex, int tilesX, const SampleContext& context);
+	void RenderPacket(int minX, int minY, const SampleContext& context);
+
+	// COMBINED shading of the hit of a lane of the packet, lightVisibility is 0 when its shadow ray was blocked
+	ColorRGB ShadeHit(const RayPacket& packet, int lane, const Vector3& viewDirection, float lightVisibility, const SampleContext& context) const;
+	// Object space geometric normal of a primitive, to lift the shadow rays off the surface
+	Vector3 GetFaceNormal(int primitive) const;
+};
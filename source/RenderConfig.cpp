@@ -4,6 +4,21 @@
 
 RenderConfig* RenderConfig::s_RenderInstance{ nullptr };
 
+// Internal resolution of the software rasterizer relative to the window
+static constexpr float g_RenderScales[]{ 1.f, 0.75f, 0.67f, 0.5f };
+
+// Shadow map size of the software rasterizer, 0 turns shadows off
+static constexpr int g_ShadowMapResolutions[]{ 0, 512, 1024, 2048 };
+
+// Point lights the software rasterizer scatters around the mesh, next to the directional light
+static constexpr int g_PointLightCounts[]{ 0, 16, 64, 256 };
+
+// Ambient occlusion rays per pixel and frame of the software rasterizer, a still image keeps adding them
+static constexpr int g_AmbientOcclusionSampleCounts[]{ 0, 1, 2, 4 };
+
+// Frames the software rasterizer keeps in flight, 1 is fully sequential
+static constexpr int g_MaxPipelineDepth{ 3 };
+
 RenderConfig* RenderConfig::GetInstance()
 {
 	if (s_RenderInstance == nullptr)
@@ -36,6 +51,9 @@ void RenderConfig::CycleRenderer()
 	case API::CPU:
 		std::cout << "API: CPU" << "\n";
 		break;
+	case API::RAY_TRACER:
+		std::cout << "API: CPU ray tracer" << "\n";
+		break;
 	case API::ENUM_LENGTH:
 		throw std::runtime_error("Unknown API, bug in code");
 	}
@@ -60,6 +78,24 @@ void RenderConfig::ToggleRotation()
 	}
 }
 
+void RenderConfig::ToggleOnDemandRendering()
+{
+	m_ShouldRenderOnDemand = !m_ShouldRenderOnDemand;
+
+	if (m_ShouldRenderOnDemand)
+	{
+		std::cout << "\033[33m"; // TEXT COLOR
+		std::cout << "[ENABLE] On-demand rendering (only redraw on changes)" << std::endl;
+		std::cout << "\033[37m"; // TEXT COLOR WHITE
+	}
+	else 
+	{
+		std::cout << "\033[33m"; // TEXT COLOR
+		std::cout << "[DISABLE] On-demand rendering" << std::endl;
+		std::cout << "\033[37m"; // TEXT COLOR WHITE
+	}
+}
+
 void RenderConfig::ToggleThruster()
 {
 	m_ShouldRenderThruster = !m_ShouldRenderThruster;
@@ -147,6 +183,9 @@ void RenderConfig::CycleShadingMode()
 	case SHADING_MODE::SPECULAR:
 		std::cout << "Shading mode: Specular" << "\n";
 		break;
+	case SHADING_MODE::PBR:
+		std::cout << "Shading mode: PBR" << "\n";
+		break;
 	case SHADING_MODE::ENUM_LENGTH:
 		throw std::runtime_error("Unknown API, bug in code");
 	}
@@ -208,6 +247,161 @@ void RenderConfig::ToggleBoundingBox()
 	}
 }
 
+void RenderConfig::ToggleVariableRateShading()
+{
+	m_ShouldUseVariableRateShading = !m_ShouldUseVariableRateShading;
+
+	if (m_ShouldUseVariableRateShading)
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[ENABLE] Variable rate shading" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+	else
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[DISABLE] Variable rate shading" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+}
+
+void RenderConfig::CycleRenderScale()
+{
+	constexpr int amountOfScales = sizeof(g_RenderScales) / sizeof(g_RenderScales[0]);
+	m_CurrentRenderScaleIndex = (m_CurrentRenderScaleIndex + 1) % amountOfScales;
+
+	std::cout << "\033[35m"; // TEXT COLOR
+	std::cout << "Render scale: " << static_cast<int>(g_RenderScales[m_CurrentRenderScaleIndex] * 100.f) << "%" << std::endl;
+	std::cout << "\033[38m"; // TEXT COLOR
+}
+
+void RenderConfig::ToggleHDR()
+{
+	m_ShouldUseHDR = !m_ShouldUseHDR;
+
+	if (m_ShouldUseHDR)
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[ENABLE] HDR post processing (bloom + tonemap)" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+	else
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[DISABLE] HDR post processing" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+}
+
+void RenderConfig::ToggleDepthPrepass()
+{
+	m_ShouldUseDepthPrepass = !m_ShouldUseDepthPrepass;
+
+	if (m_ShouldUseDepthPrepass)
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[ENABLE] Depth prepass" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+	else
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[DISABLE] Depth prepass" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+}
+
+void RenderConfig::CycleShadowMapResolution()
+{
+	constexpr int amountOfResolutions = sizeof(g_ShadowMapResolutions) / sizeof(g_ShadowMapResolutions[0]);
+	m_CurrentShadowMapResolutionIndex = (m_CurrentShadowMapResolutionIndex + 1) % amountOfResolutions;
+
+	std::cout << "\033[35m"; // TEXT COLOR
+	if (ShouldRenderShadows())
+	{
+		std::cout << "Shadow map: " << GetShadowMapResolution() << "x" << GetShadowMapResolution() << std::endl;
+	}
+	else
+	{
+		std::cout << "Shadow map: OFF" << std::endl;
+	}
+	std::cout << "\033[38m"; // TEXT COLOR
+}
+
+void RenderConfig::CyclePointLightCount()
+{
+	constexpr int amountOfCounts = sizeof(g_PointLightCounts) / sizeof(g_PointLightCounts[0]);
+	m_CurrentPointLightCountIndex = (m_CurrentPointLightCountIndex + 1) % amountOfCounts;
+
+	std::cout << "\033[35m"; // TEXT COLOR
+	std::cout << "Point lights: " << GetPointLightCount() << std::endl;
+	std::cout << "\033[38m"; // TEXT COLOR
+}
+
+void RenderConfig::ToggleRayTracedShadows()
+{
+	m_ShouldRayTraceShadows = !m_ShouldRayTraceShadows;
+
+	if (m_ShouldRayTraceShadows)
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[ENABLE] Ray traced shadows, replace the shadow map" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+	else
+	{
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "[DISABLE] Ray traced shadows" << std::endl;
+		std::cout << "\033[38m"; // TEXT COLOR
+	}
+}
+
+void RenderConfig::CycleAmbientOcclusionSampleCount()
+{
+	constexpr int amountOfCounts = sizeof(g_AmbientOcclusionSampleCounts) / sizeof(g_AmbientOcclusionSampleCounts[0]);
+	m_CurrentAmbientOcclusionSampleCountIndex = (m_CurrentAmbientOcclusionSampleCountIndex + 1) % amountOfCounts;
+
+	std::cout << "\033[35m"; // TEXT COLOR
+	if (GetAmbientOcclusionSampleCount() > 0)
+	{
+		std::cout << "Ray traced ambient occlusion: " << GetAmbientOcclusionSampleCount() << " rays per pixel and frame" << std::endl;
+	}
+	else
+	{
+		std::cout << "Ray traced ambient occlusion: OFF" << std::endl;
+	}
+	std::cout << "\033[38m"; // TEXT COLOR
+}
+
+void RenderConfig::CyclePipelineDepth()
+{
+	m_PipelineDepth = (m_PipelineDepth % g_MaxPipelineDepth) + 1;
+
+	std::cout << "\033[35m"; // TEXT COLOR
+	std::cout << "Pipeline depth: " << m_PipelineDepth << (m_PipelineDepth == 1 ? " frame (sequential)" : " frames") << std::endl;
+	std::cout << "\033[38m"; // TEXT COLOR
+}
+
+void RenderConfig::CycleMathQuality()
+{
+	const auto qualityIndex = static_cast<int8_t>(m_CurrentMathQuality);
+	m_CurrentMathQuality = static_cast<MATH_QUALITY>((qualityIndex + 1) % static_cast<int8_t>(MATH_QUALITY::ENUM_LENGTH));
+
+	std::cout << "\033[35m"; // TEXT COLOR
+	switch (m_CurrentMathQuality)
+	{
+	case MATH_QUALITY::EXACT:
+		std::cout << "Math quality: Exact" << std::endl;
+		break;
+	case MATH_QUALITY::APPROXIMATE:
+		std::cout << "Math quality: Approximate (fast rsqrt, reciprocal and pow)" << std::endl;
+		break;
+	case MATH_QUALITY::ENUM_LENGTH:
+		throw std::runtime_error("Unknown math quality, bug in code");
+	}
+	std::cout << "\033[38m"; // TEXT COLOR
+}
+
 bool RenderConfig::ShouldRenderNormalMap()
 {
 	return m_ShouldRenderNormalMap;
@@ -223,11 +417,66 @@ bool RenderConfig::ShouldRenderBoundingBox()
 	return m_ShouldRenderBoundingBox;
 }
 
+bool RenderConfig::ShouldUseVariableRateShading()
+{
+	return m_ShouldUseVariableRateShading;
+}
+
+float RenderConfig::GetRenderScale()
+{
+	return g_RenderScales[m_CurrentRenderScaleIndex];
+}
+
+bool RenderConfig::ShouldUseHDR()
+{
+	return m_ShouldUseHDR;
+}
+
+bool RenderConfig::ShouldUseDepthPrepass()
+{
+	return m_ShouldUseDepthPrepass;
+}
+
+bool RenderConfig::ShouldRenderShadows()
+{
+	return GetShadowMapResolution() > 0;
+}
+
+int RenderConfig::GetShadowMapResolution()
+{
+	return g_ShadowMapResolutions[m_CurrentShadowMapResolutionIndex];
+}
+
+int RenderConfig::GetPointLightCount()
+{
+	return g_PointLightCounts[m_CurrentPointLightCountIndex];
+}
+
+bool RenderConfig::ShouldRayTraceShadows()
+{
+	return m_ShouldRayTraceShadows;
+}
+
+int RenderConfig::GetAmbientOcclusionSampleCount()
+{
+	return g_AmbientOcclusionSampleCounts[m_CurrentAmbientOcclusionSampleCountIndex];
+}
+
+int RenderConfig::GetPipelineDepth()
+{
+	return m_PipelineDepth;
+}
+
 RenderConfig::SHADING_MODE RenderConfig::GetCurrentShadingMode()
 {
 	return m_CurrentShadingMode;
 }
 
+RenderConfig::MATH_QUALITY RenderConfig::GetCurrentMathQuality()
+{
+	return m_CurrentMathQuality;
+}
+
 void RenderConfig::ToggleVulkan()
 {
 	m_ShouldUseVulkan = !m_ShouldUseVulkan;
@@ -317,6 +566,11 @@ bool RenderConfig::ShouldPrintFPS()
 	return m_ShouldPrintFPS;
 }
 
+bool RenderConfig::ShouldRenderOnDemand()
+{
+	return m_ShouldRenderOnDemand;
+}
+
 float RenderConfig::GetRotationSpeed()
 {
 	return m_RotationSpeed;
@@ -326,23 +580,34 @@ void RenderConfig::PrintInstructions()
 {
 	std::cout << "\033[33m"; // TEXT COLOR
 	std::cout << "[Key Bindings - SHARED]" << std::endl;
-	std::cout << "\t[F1] Toggle Rasterizer Mode (HARDWARE/SOFTWARE)" << std::endl;
+	std::cout << "\t[F1] Toggle Rasterizer Mode (HARDWARE/SOFTWARE/RAY TRACED)" << std::endl;
 	std::cout << "\t[F2] Toggle Vehicle Rotation (ON/OFF)" << std::endl;
+	std::cout << "\t[F3] Toggle FireFX (ON/OFF)" << std::endl;
 	std::cout << "\t[F9] Cycle CullMode (BACK/FRONT/NONE)" << std::endl;
 	std::cout << "\t[F10] Toggle Uniform ClearColor (ON/OFF)" << std::endl;
 	std::cout << "\t[F11] Toggle Print FPS (ON/OFF)" << std::endl;
+	std::cout << "\t[O] Toggle On-Demand Rendering, idle until something changes (ON/OFF)" << std::endl;
 	std::cout << std::endl;
 	std::cout << "\033[32m"; // TEXT COLOR
 	std::cout << "[Key Bindings - HARDWARE]" << std::endl;
-	std::cout << "\t[F3] Toggle FireFX (ON / OFF)" << std::endl;
 	std::cout << "\t[F4] Cycle Sampler State (POINT / LINEAR / ANISOTROPIC)" << std::endl;
 	std::cout << std::endl;
 	std::cout << "\033[35m"; // TEXT COLOR
 	std::cout << "[Key Bindings - SOFTWARE]" << std::endl;
-	std::cout << "\t[F5] Cycle Shading Mode (COMBINED / OBSERVED_AREA / DIFFUSE / SPECULAR)" << std::endl;
+	std::cout << "\t[F5] Cycle Shading Mode (COMBINED / OBSERVED_AREA / DIFFUSE / SPECULAR / PBR)" << std::endl;
 	std::cout << "\t[F6] Toggle NormalMap (ON / OFF" << std::endl;
 	std::cout << "\t[F7] Toggle DepthBuffer Visualization (ON / OFF)" << std::endl;
 	std::cout << "\t[F8] Toggle BoundingBox Visualization (ON / OFF)" << std::endl;
+	std::cout << "\t[R] Toggle Variable Rate Shading (ON / OFF)" << std::endl;
+	std::cout << "\t[U] Cycle Render Scale + Upscaling (100% / 75% / 67% / 50%)" << std::endl;
+	std::cout << "\t[H] Toggle HDR Bloom + Tonemapping (ON / OFF)" << std::endl;
+	std::cout << "\t[Z] Toggle Depth Prepass, only front-most fragments get shaded (ON / OFF)" << std::endl;
+	std::cout << "\t[M] Cycle Shadow Map (OFF / 512 / 1024 / 2048)" << std::endl;
+	std::cout << "\t[L] Cycle Point Lights, clustered (0 / 16 / 64 / 256)" << std::endl;
+	std::cout << "\t[T] Toggle Ray Traced Shadows, replace the shadow map (ON / OFF)" << std::endl;
+	std::cout << "\t[K] Cycle Ray Traced Ambient Occlusion, rays per pixel and frame (0 / 1 / 2 / 4)" << std::endl;
+	std::cout << "\t[P] Cycle Pipeline Depth, frames in flight (1 / 2 / 3)" << std::endl;
+	std::cout << "\t[Q] Cycle Shading Math Quality (EXACT / APPROXIMATE)" << std::endl;
 	std::cout << "\033[0m"; // TEXT COLOR
 	std::cout << std::endl;
 	std::cout << "\033[31m"; // TEXT COLOR
@@ -10,6 +10,8 @@ public:
 	{
 		DIRECTX,
 		CPU,
+		// Software ray tracing on the JobSystem, converges while the scene stands still
+		RAY_TRACER,
 		ENUM_LENGTH
 	};
 
@@ -35,6 +37,15 @@ public:
 		OBSERVED_AREA,
 		DIFFUSE,
 		SPECULAR,
+		// GGX / Smith / Schlick on batches of pixels, software rasterizer only
+		PBR,
+		ENUM_LENGTH
+	};
+
+	enum class MATH_QUALITY
+	{
+		EXACT,
+		APPROXIMATE,
 		ENUM_LENGTH
 	};
 
@@ -47,10 +58,12 @@ public:
 	void ToggleUniformColor();
 	void ToggleRotation();
 	void TogglePrintFPS();
+	void ToggleOnDemandRendering();
 
 	bool ShouldRotate();
 	bool ShouldUseUniformColor();
 	bool ShouldPrintFPS();
+	bool ShouldRenderOnDemand();
 
 	float GetRotationSpeed();
 	void PrintInstructions();
@@ -73,10 +86,31 @@ public:
 	void ToggleNormapMap();
 	void ToggleDepthBuffer();
 	void ToggleBoundingBox();
+	void ToggleVariableRateShading();
+	void CycleRenderScale();
+	void ToggleHDR();
+	void ToggleDepthPrepass();
+	void CycleShadowMapResolution();
+	void CyclePointLightCount();
+	void ToggleRayTracedShadows();
+	void CycleAmbientOcclusionSampleCount();
+	void CyclePipelineDepth();
+	void CycleMathQuality();
 	bool ShouldRenderNormalMap();
 	bool ShouldRenderDepthBuffer();
 	bool ShouldRenderBoundingBox();
+	bool ShouldUseVariableRateShading();
+	float GetRenderScale();
+	bool ShouldUseHDR();
+	bool ShouldUseDepthPrepass();
+	bool ShouldRenderShadows();
+	int GetShadowMapResolution();
+	int GetPointLightCount();
+	bool ShouldRayTraceShadows();
+	int GetAmbientOcclusionSampleCount();
+	int GetPipelineDepth();
 	SHADING_MODE GetCurrentShadingMode();
+	MATH_QUALITY GetCurrentMathQuality();
 
 	/************************************************************************/
 	/* Vulkan																*/
@@ -97,6 +131,7 @@ private:
 	bool m_ShouldRotate{ true };
 	bool m_ShouldUseUniformColor{ false };
 	bool m_ShouldPrintFPS{ false };
+	bool m_ShouldRenderOnDemand{ false };
 
 	float m_RotationSpeed{ 25.f };
 	
@@ -113,7 +148,17 @@ private:
 	bool m_ShouldRenderNormalMap{true};
 	bool m_ShouldRenderDepthBuffer{ false };
 	bool m_ShouldRenderBoundingBox{ false };
+	bool m_ShouldUseVariableRateShading{ false };
+	int m_CurrentRenderScaleIndex{};
+	bool m_ShouldUseHDR{ false };
+	bool m_ShouldUseDepthPrepass{ true };
+	int m_CurrentShadowMapResolutionIndex{ 2 };
+	int m_CurrentPointLightCountIndex{};
+	bool m_ShouldRayTraceShadows{ false };
+	int m_CurrentAmbientOcclusionSampleCountIndex{};
+	int m_PipelineDepth{ 2 };
 	SHADING_MODE m_CurrentShadingMode{ SHADING_MODE::COMBINED };
+	MATH_QUALITY m_CurrentMathQuality{ MATH_QUALITY::EXACT };
 	
 	/************************************************************************/
 	/* Vulkan																*/
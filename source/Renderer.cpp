@@ -14,6 +14,8 @@
 #include "DirectX_Renderer.h"
 #include "Mesh.h"
 #include "RenderConfig.h"
+#include "NormalMapBaker.h"
+#include "RayTracer.h"
 
 Renderer::Renderer(SDL_Window* pWindow) :
 	m_pWindow(pWindow)
@@ -32,10 +34,14 @@ Renderer::Renderer(SDL_Window* pWindow) :
 	SetupThruster(fireFileLocation);
 
 	LoadTextures();
+	BakeNormalMaps();
 
-	m_pCPURenderer = new CPU_Renderer(pWindow, m_pCamera, m_pMeshes);
+	m_SkyIrradiance = SphericalHarmonics::ProjectIrradiance(SphericalHarmonics::SkyRadiance);
+
+	m_pCPURenderer = new CPU_Renderer(pWindow, m_pCamera, m_pMeshes, m_SkyIrradiance);
 	m_pDirectXRenderer = new DirectX_Renderer(pWindow, m_pCamera, m_pMeshes);
-	m_pVulkanRenderer = new VulkanRenderer(pWindow, m_pCamera, m_pMeshes);
+	m_pVulkanRenderer = new VulkanRenderer(pWindow, m_pCamera, m_pMeshes, m_SkyIrradiance);
+	m_pRayTracer = new RayTracer(pWindow, m_pCamera, m_pMeshes, m_SkyIrradiance);
 
 	m_pCurrentRenderer = m_pCPURenderer; 
 
@@ -53,6 +59,7 @@ Renderer::~Renderer()
 	delete m_pCPURenderer;
 	delete m_pDirectXRenderer;
 	delete m_pVulkanRenderer;
+	delete m_pRayTracer;
 }
 
 void Renderer::Update(Timer* pTimer)
@@ -60,6 +67,19 @@ void Renderer::Update(Timer* pTimer)
 	m_pCamera->Update(pTimer);
 
 	m_pCurrentRenderer->Update(pTimer);
+
+	// Camera moved since the last rendered frame
+	if (!(m_pCamera->viewMatrix == m_RenderedViewMatrix) || !(m_pCamera->projectionMatrix == m_RenderedProjectionMatrix))
+	{
+		m_IsDirty = true;
+	}
+}
+
+bool Renderer::NeedsRender() const
+{
+	// A rotating scene or held camera keys change the image every frame, pipelined frames still have to reach the screen
+	return m_IsDirty || RENDER_CONFIG->ShouldRotate() || m_pCamera->HasMovementInput()
+		|| (m_pCurrentRenderer && m_pCurrentRenderer->HasPendingFrames());
 }
 
 void Renderer::Render()
@@ -80,12 +100,19 @@ void Renderer::Render()
 		case RenderConfig::API::CPU:
 			m_pCurrentRenderer = m_pCPURenderer;
 			break;
+		case RenderConfig::API::RAY_TRACER:
+			m_pCurrentRenderer = m_pRayTracer;
+			break;
 		case RenderConfig::API::ENUM_LENGTH:
 			throw std::runtime_error("Unknown API, bug in code");
 		}
 	}
 
 	m_pCurrentRenderer->Render();
+
+	m_RenderedViewMatrix = m_pCamera->viewMatrix;
+	m_RenderedProjectionMatrix = m_pCamera->projectionMatrix;
+	m_IsDirty = false;
 }
 
 void Renderer::SetMoveSpeedFast()
@@ -165,3 +192,17 @@ void Renderer::LoadTextures()
 		}
 	}
 }
+
+void Renderer::BakeNormalMaps()
+{
+	// None of the meshes deform, so their normal maps can move from tangent space to object space once
+	for (MeshData* mesh : m_pMeshes)
+	{
+		if (mesh->textures[1] == nullptr)
+		{
+			continue;
+		}
+
+		NormalMapBaker::BakeObjectSpace(*mesh);
+	}
+}
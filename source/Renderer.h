@@ -6,6 +6,7 @@
 #include "Camera.h"
 #include "DataTypes.h"
 #include "VulkanRenderer.h"
+#include "SphericalHarmonics.h"
 
 struct SDL_Window;
 struct SDL_Surface;
@@ -18,6 +19,7 @@ class Timer;
 class BaseRenderer;
 class CPU_Renderer;
 class DirectX_Renderer;
+class RayTracer;
 
 class Renderer final
 {
@@ -37,11 +39,16 @@ public:
 	void SetMoveSpeedNormal();
 	void ToggleRotation();
 
+	// On-demand rendering, input and config changes come in through MarkDirty
+	bool NeedsRender() const;
+	void MarkDirty() { m_IsDirty = true; };
+
 private:
 	SDL_Window* m_pWindow{};
 	CPU_Renderer* m_pCPURenderer{};
 	DirectX_Renderer* m_pDirectXRenderer{};
 	VulkanRenderer* m_pVulkanRenderer{};
+	RayTracer* m_pRayTracer{};
 
 	BaseRenderer* m_pCurrentRenderer{};
 	Camera* m_pCamera{};
@@ -49,12 +56,21 @@ private:
 	// List of meshes
 	std::vector<MeshData*> m_pMeshes{};
 
+	// Ambient light of the CPU and Vulkan renderers, projected from the sky once
+	IrradianceSH m_SkyIrradiance{};
+
 	void SetupVehicle(std::string& meshSrc);
 	void SetupThruster(std::string& meshSrc);
 	void LoadTextures();
+	void BakeNormalMaps();
 
 	int m_Width{};
 	int m_Height{};
 
 	bool m_ShouldRotate{ true };
+
+	// Dirtiness since the last rendered frame
+	bool m_IsDirty{ true };
+	Matrix m_RenderedViewMatrix{};
+	Matrix m_RenderedProjectionMatrix{};
 };
@@ -73,6 +73,23 @@ struct VS_OUTPUT
 	float3 Tangent: TANGENT;
 };
 
+// Baked object space normal map, the coordinates into its layers replace the tangent
+struct VS_INPUT_OBJECT_SPACE
+{
+	float3 Position: POSITION;
+	float2 Uv: TEXCOORD0;
+	float3 Normal: NORMAL;
+	float2 NormalMapUv: TEXCOORD1;
+};
+
+struct VS_OUTPUT_OBJECT_SPACE
+{
+	float4 Position: SV_POSITION;
+	float4 WorldPosition: WORLDPOSITION;
+	float2 Uv: TEXCOORD0;
+	float2 NormalMapUv: TEXCOORD1;
+};
+
 /// Vertex shader
 VS_OUTPUT VS(VS_INPUT input)
 {
@@ -87,6 +104,18 @@ VS_OUTPUT VS(VS_INPUT input)
 	return output;
 }
 
+VS_OUTPUT_OBJECT_SPACE VS_ObjectSpace(VS_INPUT_OBJECT_SPACE input)
+{
+	VS_OUTPUT_OBJECT_SPACE output = (VS_OUTPUT_OBJECT_SPACE)0;
+
+	output.Uv = input.Uv;
+	output.NormalMapUv = input.NormalMapUv;
+	output.Position = mul(float4(input.Position, 1.f), gWorldViewProj);
+	output.WorldPosition = mul(input.Position, gWorld);
+
+	return output;
+}
+
 float CalculatePhong(float3 specular, float phongExponent, float3 lightDirection, float3 viewDirection, float3 normal)
 {
 	float3 reflected = reflect(normal, lightDirection);
@@ -101,25 +130,19 @@ float3 CalculateLambert(float kd, float3 color)
 	return mul(color, kd / PI);
 }
 
-// Pixel shader
-float4 PS(VS_OUTPUT input) : SV_TARGET
+// Shading with the normal already in world space
+float4 Shade(float2 uv, float3 worldPosition, float3 normal)
 {
-	float3 binormal = normalize(cross(input.Normal, input.Tangent));
-	float3x3 tangentSpaceAxis = float3x3(normalize(input.Tangent), binormal, normalize(input.Normal));
-	float3 normalMapSample = gNormalMap.Sample(gSamplerState, input.Uv).xyz;
-	float3 mappedNormal = 2.f * normalMapSample - 1.f;
-	float3 tangentSpaceNormal = normalize(mul(mappedNormal, tangentSpaceAxis));
-
-	float observedArea = dot(tangentSpaceNormal, -gLightDir);
+	float observedArea = dot(normal, -gLightDir);
 	//observedArea = saturate(observedArea);
 
-	float3 viewDirection = normalize(input.WorldPosition.xyz - gViewInverse[3].xyz);
+	float3 viewDirection = normalize(worldPosition - gViewInverse[3].xyz);
 
-	float3 specularMapSample = gSpecularMap.Sample(gSamplerState, input.Uv).xyz;
-	float3 glossinessMapSample = gGlossinessMap.Sample(gSamplerState, input.Uv).xyz;
-	float3 diffuseMapSample = gDiffuseMap.Sample(gSamplerState, input.Uv).xyz;
+	float3 specularMapSample = gSpecularMap.Sample(gSamplerState, uv).xyz;
+	float3 glossinessMapSample = gGlossinessMap.Sample(gSamplerState, uv).xyz;
+	float3 diffuseMapSample = gDiffuseMap.Sample(gSamplerState, uv).xyz;
 
-	float phongValue = CalculatePhong(specularMapSample, glossinessMapSample.x * SHININESS, gLightDir, viewDirection, tangentSpaceNormal);
+	float phongValue = CalculatePhong(specularMapSample, glossinessMapSample.x * SHININESS, gLightDir, viewDirection, normal);
 	float3 diffuse = CalculateLambert(1.f, diffuseMapSample);
 
 	// ((diffuse * int) + phong + ambient) * obser
@@ -129,6 +152,27 @@ float4 PS(VS_OUTPUT input) : SV_TARGET
 	return float4(finalColor, 1);
 }
 
+// Pixel shader
+float4 PS(VS_OUTPUT input) : SV_TARGET
+{
+	float3 binormal = normalize(cross(input.Normal, input.Tangent));
+	float3x3 tangentSpaceAxis = float3x3(normalize(input.Tangent), binormal, normalize(input.Normal));
+	float3 normalMapSample = gNormalMap.Sample(gSamplerState, input.Uv).xyz;
+	float3 mappedNormal = 2.f * normalMapSample - 1.f;
+	float3 tangentSpaceNormal = normalize(mul(mappedNormal, tangentSpaceAxis));
+
+	return Shade(input.Uv, input.WorldPosition.xyz, tangentSpaceNormal);
+}
+
+// The baked normal only needs the rotation of the mesh
+float4 PS_ObjectSpace(VS_OUTPUT_OBJECT_SPACE input) : SV_TARGET
+{
+	float3 normalMapSample = gNormalMap.Sample(gSamplerState, input.NormalMapUv).xyz;
+	float3 worldNormal = normalize(mul(2.f * normalMapSample - 1.f, (float3x3)gWorld));
+
+	return Shade(input.Uv, input.WorldPosition.xyz, worldNormal);
+}
+
 // Technique
 technique11 DefaultTechnique
 {
@@ -141,4 +185,17 @@ technique11 DefaultTechnique
 		SetGeometryShader(NULL);
 		SetPixelShader(CompileShader(ps_5_0, PS()));
 	}
+}
+
+technique11 ObjectSpaceNormalTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+        SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_ObjectSpace()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS_ObjectSpace()));
+	}
 }
\ No newline at end of file
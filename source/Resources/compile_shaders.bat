@@ -1,4 +1,6 @@
 C:\VulkanSDK\1.3.231.1\Bin\glslangValidator.exe -V shader.vert
 C:\VulkanSDK\1.3.231.1\Bin\glslangValidator.exe -V shader.frag
+C:\VulkanSDK\1.3.231.1\Bin\spirv-val.exe vert.spv
+C:\VulkanSDK\1.3.231.1\Bin\spirv-val.exe frag.spv
 
 pause
\ No newline at end of file
@@ -6,10 +6,36 @@ layout(location = 1) in vec2 fragUV;
 layout(location = 2) in vec3 fragNormal;
 layout(location = 3) in vec3 fragTangent;
 
+// Layout of VulkanRenderer::UboViewProjection
+layout(set = 0, binding = 0) uniform UboViewProjection {
+    mat4 projection;
+    mat4 view;
+    vec4 lightDirection; // xyz direction, w intensity
+    vec4 skyIrradiance[9];
+} uboViewProjection;
+
 layout(set = 1, binding = 0) uniform sampler2D textureSampler;
 
 layout(location = 0) out vec4 outColor;
 
+const float PI = 3.14159265;
+
+// IrradianceSH::Evaluate, the coefficients already hold the basis constants and the cosine convolution
+vec3 EvaluateIrradiance(vec3 n) {
+    return uboViewProjection.skyIrradiance[0].rgb
+        + uboViewProjection.skyIrradiance[1].rgb * n.y + uboViewProjection.skyIrradiance[2].rgb * n.z + uboViewProjection.skyIrradiance[3].rgb * n.x
+        + uboViewProjection.skyIrradiance[4].rgb * (n.x * n.y) + uboViewProjection.skyIrradiance[5].rgb * (n.y * n.z)
+        + uboViewProjection.skyIrradiance[6].rgb * (3.0 * n.z * n.z - 1.0)
+        + uboViewProjection.skyIrradiance[7].rgb * (n.x * n.z) + uboViewProjection.skyIrradiance[8].rgb * (n.x * n.x - n.y * n.y);
+}
+
 void main() {
-    outColor = texture(textureSampler, fragUV);
+    vec4 albedo = texture(textureSampler, fragUV);
+    vec3 normal = normalize(fragNormal);
+
+    // Lambert of the directional light plus the sky, like the diffuse part of the CPU renderer
+    float lambertCosine = max(dot(normal, -uboViewProjection.lightDirection.xyz), 0.0);
+    vec3 irradiance = uboViewProjection.lightDirection.w * lambertCosine + EvaluateIrradiance(normal);
+
+    outColor = vec4(albedo.rgb / PI * irradiance, albedo.a);
 }
\ No newline at end of file
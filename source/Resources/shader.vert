@@ -8,6 +8,8 @@ layout(location = 3) in vec3 tangent;
 layout(set = 0, binding = 0) uniform UboViewProjection {
     mat4 projection;
     mat4 view;
+    vec4 lightDirection;
+    vec4 skyIrradiance[9];
 } uboViewProjection;
 
 // NOT IN USE LEFT FOR REFERENCE
@@ -29,6 +31,7 @@ void main() {
     gl_Position = uboViewProjection.projection * uboViewProjection.view * pushModel.model * vec4(pos, 1.0);
     fragPos = pos;
     fragUV = uv;
-    fragNormal = normal;
+    // World space, the fragment shader lights it with the world space light direction
+    fragNormal = mat3(pushModel.model) * normal;
     fragTangent = tangent;
 }
\ No newline at end of file
@@ -3,22 +3,42 @@
 
 #include "ColorRGB.h"
 #include "Vector3.h"
+#include "FastMath.h"
 
 
 namespace Shading
 {
+	// The directional light of the CPU backends, pointing away from the light
+	constexpr Vector3 LightDirection{ .577f, -.577f, .577f };
+	constexpr float LightIntensity{ 7.f };
+	// Scales the glossiness map to the Phong exponent
+	constexpr float Shininess{ 25.f };
+
 	static ColorRGB Lambert(float kd, const ColorRGB& cd)
 	{
 		return cd * (kd / (float)M_PI);
 	}
 
-	static ColorRGB Phong(ColorRGB ks, ColorRGB exp, const Vector3& l, const Vector3& v, const Vector3& n)
+	// isFastMath swaps powf for FastMath::Pow, see its error budget
+	static ColorRGB Phong(ColorRGB ks, ColorRGB exp, const Vector3& l, const Vector3& v, const Vector3& n, bool isFastMath = false)
 	{
 		const auto reflect = (2.f * (Vector3::Dot(n, l) * n)) - l;
 		const auto angle = std::max(0.f, Vector3::Dot(reflect, v));
-		const auto reflection = ks * std::powf(angle, exp.r);
+		const auto reflection = ks * (isFastMath ? FastMath::Pow(angle, exp.r) : powf(angle, exp.r));
 
 		// return reflection for all color
 		return ColorRGB{ reflection.r, reflection.g, reflection.b };
 	}
+
+	// The combined mode, Lambert and Phong of the directional light with lambertCosine already shadowed.
+	// The unshadowed irradiance only lights the diffuse, pointSpecular holds the Phong lobes of the point lights
+	static ColorRGB Combined(const ColorRGB& albedo, const ColorRGB& specularReflectance, const ColorRGB& glossiness, const Vector3& viewDirection,
+		const Vector3& vertexNormal, float lambertCosine, const ColorRGB& irradiance, const ColorRGB& pointSpecular, bool isFastMath = false)
+	{
+		const ColorRGB light = ColorRGB{ 1,1,1 } * LightIntensity;
+		const ColorRGB specular = Phong(specularReflectance, glossiness * Shininess, LightDirection, viewDirection, vertexNormal, isFastMath);
+		const ColorRGB diffuse = Lambert(1.f, albedo);
+
+		return ((diffuse * light) + specular) * lambertCosine + diffuse * irradiance + specularReflectance * pointSpecular;
+	}
 }
@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "ShadingRateImage.h"
+#include "JobSystem.h"
+
+namespace
+{
+	// Luminance variance thresholds (luminance in [0, 1])
+	constexpr float VarianceThreshold4x4{ 0.0004f };
+	constexpr float VarianceThreshold2x2{ 0.0015f };
+	constexpr float VarianceThreshold1x2{ 0.004f };
+}
+
+ShadingRateImage::ShadingRateImage(int width, int height)
+	: m_Width{ width }, m_Height{ height }
+{
+	m_TilesX = (width + TileSize - 1) / TileSize;
+	m_TilesY = (height + TileSize - 1) / TileSize;
+
+	m_Rates.resize(m_TilesX * m_TilesY);
+	Reset();
+}
+
+void ShadingRateImage::Update(const uint32_t* pPixels, const SDL_PixelFormat* pFormat)
+{
+	JOB_SYSTEM->ParallelFor(0, m_TilesX * m_TilesY, [=, this](int tileIndex)
+		{
+			const int tileX = tileIndex % m_TilesX;
+			const int tileY = tileIndex / m_TilesX;
+
+			m_Rates[tileIndex] = ComputeTileRate(tileX, tileY, pPixels, pFormat);
+		}
+	);
+}
+
+void ShadingRateImage::UpdateRect(const uint32_t* pPixels, const SDL_PixelFormat* pFormat, int minX, int minY, int maxX, int maxY)
+{
+	for (int tileY{ minY / TileSize }; tileY <= maxY / TileSize; ++tileY)
+	{
+		for (int tileX{ minX / TileSize }; tileX <= maxX / TileSize; ++tileX)
+		{
+			m_Rates[tileY * m_TilesX + tileX] = ComputeTileRate(tileX, tileY, pPixels, pFormat);
+		}
+	}
+}
+
+void ShadingRateImage::Reset()
+{
+	std::fill(m_Rates.begin(), m_Rates.end(), ShadingRate::RATE_1X1);
+}
+
+ShadingRate ShadingRateImage::ComputeTileRate(int tileX, int tileY, const uint32_t* pPixels, const SDL_PixelFormat* pFormat) const
+{
+	const int startX = tileX * TileSize;
+	const int startY = tileY * TileSize;
+	const int endX = std::min(startX + TileSize, m_Width);
+	const int endY = std::min(startY + TileSize, m_Height);
+
+	float sum{};
+	float sumSquared{};
+
+	for (int py{ startY }; py < endY; ++py)
+	{
+		for (int px{ startX }; px < endX; ++px)
+		{
+			uint8_t r{}, g{}, b{};
+			SDL_GetRGB(pPixels[px + (py * m_Width)], pFormat, &r, &g, &b);
+
+			// Rec. 709 luma
+			const float luminance = (0.2126f * r + 0.7152f * g + 0.0722f * b) / 255.f;
+			sum += luminance;
+			sumSquared += luminance * luminance;
+		}
+	}
+
+	const float count = static_cast<float>((endX - startX) * (endY - startY));
+	const float mean = sum / count;
+	const float variance = sumSquared / count - mean * mean;
+
+	if (variance < VarianceThreshold4x4)
+	{
+		return ShadingRate::RATE_4X4;
+	}
+
+	if (variance < VarianceThreshold2x2)
+	{
+		return ShadingRate::RATE_2X2;
+	}
+
+	if (variance < VarianceThreshold1x2)
+	{
+		return ShadingRate::RATE_1X2;
+	}
+
+	return ShadingRate::RATE_1X1;
+}
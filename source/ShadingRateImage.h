@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+struct SDL_PixelFormat;
+
+/**
+	* Coarse shading rates, expressed as the size of the pixel block
+	* that shares one ShadePixel invocation.
+	*/
+enum class ShadingRate : uint8_t
+{
+	RATE_1X1,
+	RATE_1X2,
+	RATE_2X2,
+	RATE_4X4
+};
+
+inline int GetShadingRateWidth(ShadingRate rate)
+{
+	switch (rate)
+	{
+	case ShadingRate::RATE_2X2: return 2;
+	case ShadingRate::RATE_4X4: return 4;
+	default: return 1;
+	}
+}
+
+inline int GetShadingRateHeight(ShadingRate rate)
+{
+	switch (rate)
+	{
+	case ShadingRate::RATE_1X2: return 2;
+	case ShadingRate::RATE_2X2: return 2;
+	case ShadingRate::RATE_4X4: return 4;
+	default: return 1;
+	}
+}
+
+/**
+	* Per screen tile shading rate, derived from the luminance variance
+	* of the previously rendered frame. Flat tiles get shaded coarser.
+	*/
+class ShadingRateImage
+{
+public:
+	static constexpr int TileSize{ 16 };
+
+	ShadingRateImage(int width, int height);
+
+	// Recompute all tile rates from the frame that was just rendered
+	void Update(const uint32_t* pPixels, const SDL_PixelFormat* pFormat);
+	// Only the tiles inside the inclusive pixel rect, the rect has to start at a tile
+	void UpdateRect(const uint32_t* pPixels, const SDL_PixelFormat* pFormat, int minX, int minY, int maxX, int maxY);
+
+	// Force every tile back to full rate (used when VRS gets toggled on)
+	void Reset();
+
+	ShadingRate GetRate(int px, int py) const
+	{
+		return m_Rates[(py / TileSize) * m_TilesX + (px / TileSize)];
+	}
+
+private:
+	int m_Width{};
+	int m_Height{};
+	int m_TilesX{};
+	int m_TilesY{};
+
+	std::vector<ShadingRate> m_Rates{};
+
+	ShadingRate ComputeTileRate(int tileX, int tileY, const uint32_t* pPixels, const SDL_PixelFormat* pFormat) const;
+};
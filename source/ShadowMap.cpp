@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "ShadowMap.h"
+#include <emmintrin.h>
+#include <cfloat>
+
+ShadowMap::ShadowMap(int resolution)
+	: m_Resolution{ resolution }
+	, m_Layout{ resolution, resolution }
+	, m_Rasterizer{ resolution, resolution }
+{
+	m_Depth.resize(m_Layout.GetPixelCount());
+}
+
+void ShadowMap::Fit(const std::vector<Vector3>& worldPositions, const Vector3& lightDirection)
+{
+	// Light basis like the camera ONB, orthonormal so the inverse is the transpose
+	const Vector3 forward = lightDirection.Normalized();
+	const Vector3 right = Vector3::Cross(Vector3::UnitY, forward).Normalized();
+	const Vector3 up = Vector3::Cross(forward, right).Normalized();
+
+	const Matrix worldToLight = Matrix::Transpose({
+		Vector4{ right, 0 },
+		Vector4{ up, 0 },
+		Vector4{ forward, 0 },
+		Vector4{ 0, 0, 0, 1 },
+	});
+
+	Vector3 minimum{ FLT_MAX, FLT_MAX, FLT_MAX };
+	Vector3 maximum{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	m_TransformedPositions.resize(worldPositions.size());
+	worldToLight.TransformPoints(worldPositions, m_TransformedPositions);
+
+	for (const Vector3& lightPosition : m_TransformedPositions)
+	{
+		minimum = Vector3{ std::min(minimum.x, lightPosition.x), std::min(minimum.y, lightPosition.y), std::min(minimum.z, lightPosition.z) };
+		maximum = Vector3{ std::max(maximum.x, lightPosition.x), std::max(maximum.y, lightPosition.y), std::max(maximum.z, lightPosition.z) };
+	}
+
+	if (minimum.x > maximum.x)
+	{
+		return;
+	}
+
+	// Square texels, the casters end up inside the border on both axes
+	const float usableTexels = m_Resolution - 2.f * BorderTexels;
+	const float extent = std::max(std::max(maximum.x - minimum.x, maximum.y - minimum.y), FLT_EPSILON);
+	const float texelsPerUnit = usableTexels / extent;
+	const float depthRange = std::max(maximum.z - minimum.z, FLT_EPSILON);
+
+	// Light space to texels, y flipped like raster space
+	const Matrix lightToShadow{
+		Vector4{ texelsPerUnit, 0, 0, 0 },
+		Vector4{ 0, -texelsPerUnit, 0, 0 },
+		Vector4{ 0, 0, 1.f / depthRange, 0 },
+		Vector4{ BorderTexels - minimum.x * texelsPerUnit, BorderTexels + maximum.y * texelsPerUnit, -minimum.z / depthRange, 1 },
+	};
+
+	m_WorldToShadow = worldToLight * lightToShadow;
+	m_DepthPerTexel = 1.f / (texelsPerUnit * depthRange);
+}
+
+void ShadowMap::Render(const std::vector<Vector3>& worldPositions, const std::vector<uint32_t>& indices)
+{
+	m_Positions.resize(worldPositions.size());
+
+	m_TransformedPositions.resize(worldPositions.size());
+	m_WorldToShadow.TransformPoints(worldPositions, m_TransformedPositions);
+
+	for (size_t index{}; index < worldPositions.size(); ++index)
+	{
+		const Vector3& shadowCoord = m_TransformedPositions[index];
+		m_Positions[index] = Vector4{ shadowCoord.x, shadowCoord.y, 1.f / (2.f - shadowCoord.z), 1.f };
+	}
+
+	std::fill(m_Depth.begin(), m_Depth.end(), FLT_MAX);
+
+	// Both sides cast, the bias in Sample keeps lit faces from shadowing themselves
+	m_Rasterizer.Render(m_Positions, indices, m_Depth.data(), m_Layout, RenderConfig::CULL_MODE::NONE);
+}
+
+float ShadowMap::Sample(const Vector3& shadowCoord, float cosine) const
+{
+	// Slope scaled bias, receivers at grazing angles to the light cover more depth per texel
+	const float sine = sqrtf(std::max(1.f - cosine * cosine, 0.f));
+	const float slope = std::min(sine / std::max(cosine, FLT_EPSILON), MaxBiasSlope);
+	const float receiverDepth = shadowCoord.z - BiasTexels * m_DepthPerTexel * (1.f + slope);
+	const __m128 receiver = _mm_set1_ps(1.f / (2.f - receiverDepth));
+
+	// Texel centers sit on integer coordinates, 3 bilinear lookups per axis span 4 texels
+	const int x0 = static_cast<int>(floorf(shadowCoord.x));
+	const int y0 = static_cast<int>(floorf(shadowCoord.y));
+	const float fractionX = shadowCoord.x - x0;
+	const float fractionY = shadowCoord.y - y0;
+
+	const __m128 columnWeights = _mm_setr_ps(1.f - fractionX, 1.f, 1.f, fractionX);
+	const float rowWeights[4]{ 1.f - fractionY, 1.f, 1.f, fractionY };
+
+	int columns[4];
+	for (int tap{}; tap < 4; ++tap)
+	{
+		columns[tap] = std::clamp(x0 - 1 + tap, 0, m_Resolution - 1);
+	}
+
+	__m128 lit = _mm_setzero_ps();
+
+	for (int row{}; row < 4; ++row)
+	{
+		const int y = std::clamp(y0 - 1 + row, 0, m_Resolution - 1);
+
+		const __m128 occluders = _mm_setr_ps(
+			m_Depth[m_Layout.GetIndex(columns[0], y)], m_Depth[m_Layout.GetIndex(columns[1], y)],
+			m_Depth[m_Layout.GetIndex(columns[2], y)], m_Depth[m_Layout.GetIndex(columns[3], y)]);
+
+		const __m128 isLit = _mm_cmple_ps(receiver, occluders);
+		lit = _mm_add_ps(lit, _mm_mul_ps(_mm_and_ps(isLit, columnWeights), _mm_set1_ps(rowWeights[row])));
+	}
+
+	alignas(16) float taps[4];
+	_mm_store_ps(taps, lit);
+
+	return (taps[0] + taps[1] + taps[2] + taps[3]) / 9.f;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Math.h"
+#include "TiledLayout.h"
+#include "DepthRasterizer.h"
+
+/**
+	* Orthographic shadow map of the directional light of the software rasterizer.
+	* The light frustum gets fitted around the casters every frame and the map is
+	* rendered with the depth-only DepthRasterizer. Lookups do a 3x3 bilinear PCF
+	* (16 taps, one row of 4 per SSE compare).
+	* Overhead budget: the map renders next to the vertex stage, so at 1024 texels
+	* it stays hidden behind it. What is left on the frame is the PCF, at most 16
+	* taps per shaded fragment. The "Shadow Map" profiler stage should stay below
+	* BudgetMilliseconds, the CPU renderer reports when it goes over.
+	*/
+class ShadowMap
+{
+public:
+	static constexpr float BudgetMilliseconds{ 2.f };
+
+	explicit ShadowMap(int resolution);
+
+	int GetResolution() const { return m_Resolution; };
+
+	// Fits the light frustum around the casters, call before GetShadowCoord and Render
+	void Fit(const std::vector<Vector3>& worldPositions, const Vector3& lightDirection);
+	void Render(const std::vector<Vector3>& worldPositions, const std::vector<uint32_t>& indices);
+
+	// x and y in shadow map texels, z is the linear depth along the light (0 to 1)
+	Vector3 GetShadowCoord(const Vector3& worldPosition) const { return m_WorldToShadow.TransformPoint(worldPosition); };
+
+	// Fraction of the light that reaches the receiver, cosine is the angle between normal and light
+	float Sample(const Vector3& shadowCoord, float cosine) const;
+
+private:
+	// Keeps the casters off the edges, the rasterizer drops triangles with a vertex outside the map
+	static constexpr float BorderTexels{ 2.f };
+	static constexpr float BiasTexels{ 1.5f };
+	static constexpr float MaxBiasSlope{ 4.f };
+
+	int m_Resolution{};
+	TiledLayout m_Layout{};
+	DepthRasterizer m_Rasterizer;
+
+	// Stores 1 / (2 - depth), the rasterizer interpolates the reciprocal of the stored value,
+	// so this keeps the orthographic depth exactly linear over a triangle
+	std::vector<float> m_Depth{};
+	std::vector<Vector4> m_Positions{};
+	// Output of the batched transforms, light space in Fit and shadow coordinates in Render
+	std::vector<Vector3> m_TransformedPositions{};
+
+	Matrix m_WorldToShadow{};
+	float m_DepthPerTexel{};
+};
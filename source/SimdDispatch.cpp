@@ -0,0 +1,597 @@
+#include "pch.h"
+
+// Validate checks the depth kernels against the main pass math bit for bit, it has to round like CPU_Renderer.cpp does
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "SimdDispatch.h"
+#include "FastMath.h"
+#include "DepthRasterizer.h"
+#include <random>
+#include <cstring>
+#include <cctype>
+
+#if defined(SIMD_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+SIMD_LEVEL SimdDispatch::s_Level{ SIMD_LEVEL::SCALAR };
+const SimdKernels* SimdDispatch::s_pKernels{ nullptr };
+
+namespace
+{
+	struct LevelInfo
+	{
+		const char* pName;
+		const char* pOption;
+		const SimdKernels* (*GetKernels)();
+	};
+
+	const LevelInfo g_Levels[static_cast<int>(SIMD_LEVEL::ENUM_LENGTH)]
+	{
+		{ "Scalar", "scalar", &GetScalarKernels },
+		{ "SSE2", "sse2", &GetSse2Kernels },
+		{ "AVX2", "avx2", &GetAvx2Kernels },
+		{ "AVX-512", "avx512", &GetAvx512Kernels },
+		{ "NEON", "neon", &GetNeonKernels }
+	};
+
+#if defined(SIMD_ARCH_X86)
+	void CpuId(int leaf, int subLeaf, uint32_t registers[4])
+	{
+#if defined(_MSC_VER)
+		int values[4]{};
+		__cpuidex(values, leaf, subLeaf);
+		for (int index{}; index < 4; ++index)
+		{
+			registers[index] = static_cast<uint32_t>(values[index]);
+		}
+#else
+		__cpuid_count(leaf, subLeaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+	}
+
+	// Register state the OS saves on a context switch, wide registers are useless if it does not
+	uint64_t ReadXcr0()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		uint32_t low{}, high{};
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return (static_cast<uint64_t>(high) << 32) | low;
+#endif
+	}
+#endif
+}
+
+SIMD_LEVEL SimdDispatch::DetectLevel()
+{
+#if defined(SIMD_ARCH_X86)
+	uint32_t registers[4]{};
+	CpuId(0, 0, registers);
+	const uint32_t maxLeaf = registers[0];
+
+	CpuId(1, 0, registers);
+	const bool hasSse2 = (registers[3] & (1u << 26)) != 0;
+	const bool hasOsXsave = (registers[2] & (1u << 27)) != 0;
+	const bool hasAvx = (registers[2] & (1u << 28)) != 0;
+	// /arch:AVX2 lets the compiler fuse multiplies and adds
+	const bool hasFma = (registers[2] & (1u << 12)) != 0;
+
+	if (!hasSse2)
+	{
+		return SIMD_LEVEL::SCALAR;
+	}
+
+	if (!hasOsXsave || !hasAvx || maxLeaf < 7)
+	{
+		return SIMD_LEVEL::SSE2;
+	}
+
+	const uint64_t xcr0 = ReadXcr0();
+	// XMM and YMM state
+	const bool isAvxStateSaved = (xcr0 & 0x6) == 0x6;
+	// Plus opmask and both halves of the ZMM state
+	const bool isAvx512StateSaved = (xcr0 & 0xE6) == 0xE6;
+
+	CpuId(7, 0, registers);
+	const bool hasAvx2 = (registers[1] & (1u << 5)) != 0;
+	// /arch:AVX512 also uses the DQ, BW and VL extensions, not only the foundation
+	const bool hasAvx512 = (registers[1] & (1u << 16)) != 0 && (registers[1] & (1u << 17)) != 0
+		&& (registers[1] & (1u << 30)) != 0 && (registers[1] & (1u << 31)) != 0;
+
+	if (hasAvx512 && hasAvx2 && hasFma && isAvx512StateSaved)
+	{
+		return SIMD_LEVEL::AVX512;
+	}
+
+	if (hasAvx2 && hasFma && isAvxStateSaved)
+	{
+		return SIMD_LEVEL::AVX2;
+	}
+
+	return SIMD_LEVEL::SSE2;
+#elif defined(SIMD_ARCH_ARM64)
+	// Part of the AArch64 baseline
+	return SIMD_LEVEL::NEON;
+#else
+	return SIMD_LEVEL::SCALAR;
+#endif
+}
+
+bool SimdDispatch::IsSupported(SIMD_LEVEL level)
+{
+	if (g_Levels[static_cast<int>(level)].GetKernels() == nullptr)
+	{
+		return false;
+	}
+
+	if (level == SIMD_LEVEL::SCALAR)
+	{
+		return true;
+	}
+
+	const SIMD_LEVEL detectedLevel = DetectLevel();
+
+	// The x86 levels are supersets of each other
+	if (level == SIMD_LEVEL::NEON || detectedLevel == SIMD_LEVEL::NEON)
+	{
+		return level == detectedLevel;
+	}
+
+	return static_cast<int>(level) <= static_cast<int>(detectedLevel);
+}
+
+void SimdDispatch::Select(SIMD_LEVEL level)
+{
+	if (!IsSupported(level))
+	{
+		std::cout << "\033[31m"; // TEXT COLOR
+		std::cout << "[SIMD] " << GetLevelName(level) << " is not supported on this machine, falling back" << std::endl;
+		std::cout << "\033[37m"; // TEXT COLOR WHITE
+
+		level = DetectLevel();
+	}
+
+	s_Level = level;
+	s_pKernels = g_Levels[static_cast<int>(level)].GetKernels();
+
+	std::cout << "\033[36m"; // TEXT COLOR
+	std::cout << "[SIMD] " << GetLevelName(level) << " kernels" << std::endl;
+	std::cout << "\033[37m"; // TEXT COLOR WHITE
+}
+
+const SimdKernels& SimdDispatch::GetKernels()
+{
+	if (s_pKernels == nullptr)
+	{
+		Select(DetectLevel());
+	}
+
+	return *s_pKernels;
+}
+
+SIMD_LEVEL SimdDispatch::GetLevel()
+{
+	GetKernels();
+	return s_Level;
+}
+
+const char* SimdDispatch::GetLevelName(SIMD_LEVEL level)
+{
+	return g_Levels[static_cast<int>(level)].pName;
+}
+
+bool SimdDispatch::ParseLevel(const char* pName, SIMD_LEVEL& level)
+{
+	std::string name{ pName };
+	std::transform(name.begin(), name.end(), name.begin(), [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+
+	for (int index{}; index < static_cast<int>(SIMD_LEVEL::ENUM_LENGTH); ++index)
+	{
+		if (name == g_Levels[index].pOption)
+		{
+			level = static_cast<SIMD_LEVEL>(index);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool SimdDispatch::Validate()
+{
+	const SimdKernels& kernels = GetKernels();
+	const SimdKernels& reference = *GetScalarKernels();
+
+	std::mt19937 generator{ 2024 };
+	std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+
+	// Vertex transform, relative error against the scalar reference
+	constexpr int vertexCount{ 1021 };
+	std::vector<Vector3> positions(vertexCount);
+	for (Vector3& position : positions)
+	{
+		position = Vector3{ unit(generator) * 4.f - 2.f, unit(generator) * 4.f - 2.f, unit(generator) * 4.f - 2.f };
+	}
+
+	const Matrix viewProjection = Matrix::CreateLookAtLH(Vector3{ 0.f, 0.f, -10.f }, Vector3{ 0.f, 0.f, 1.f }, Vector3{ 0.f, 1.f, 0.f })
+		* Matrix::CreatePerspectiveFovLH(0.8f, 4.f / 3.f, 0.1f, 100.f);
+
+	std::vector<Vector4> transformed(vertexCount);
+	std::vector<Vector4> transformedReference(vertexCount);
+	kernels.TransformToRaster(positions.data(), transformed.data(), vertexCount, viewProjection, 640.f, 480.f);
+	reference.TransformToRaster(positions.data(), transformedReference.data(), vertexCount, viewProjection, 640.f, 480.f);
+
+	float transformError{};
+	for (int index{}; index < vertexCount; ++index)
+	{
+		for (int component{}; component < 4; ++component)
+		{
+			const float expected = transformedReference[index][component];
+			const float error = fabsf(transformed[index][component] - expected) / std::max(fabsf(expected), 1.f);
+			transformError = std::max(transformError, error);
+		}
+	}
+
+	// Batched point and normalized vector transforms, in place like CPU_Mesh uses them
+	const Matrix world = Matrix::CreateRotation(0.3f, 1.1f, -0.4f) * Matrix::CreateScale(1.5f, 0.5f, 2.f) * Matrix::CreateTranslation(3.f, -1.f, 2.f);
+
+	std::vector<Vector3> points{ positions }, pointsReference{ positions };
+	kernels.TransformPoints(points.data(), points.data(), vertexCount, world);
+	reference.TransformPoints(pointsReference.data(), pointsReference.data(), vertexCount, world);
+
+	std::vector<Vector3> vectors{ positions }, vectorsReference{ positions };
+	kernels.TransformVectorsAndNormalize(vectors.data(), vectors.data(), vertexCount, world);
+	reference.TransformVectorsAndNormalize(vectorsReference.data(), vectorsReference.data(), vertexCount, world);
+
+	for (int index{}; index < vertexCount; ++index)
+	{
+		for (int component{}; component < 3; ++component)
+		{
+			const float expectedPoint = pointsReference[index][component];
+			const float expectedVector = vectorsReference[index][component];
+			transformError = std::max(transformError, fabsf(points[index][component] - expectedPoint) / std::max(fabsf(expectedPoint), 1.f));
+			transformError = std::max(transformError, fabsf(vectors[index][component] - expectedVector) / std::max(fabsf(expectedVector), 1.f));
+		}
+	}
+
+	// Depth raster, has to match bit for bit like the depth prepass and the main pass do. The selected kernel
+	// is checked against the depth math of the main pass as well, after the prepass that one only keeps fragments of equal depth
+	int depthMismatches{};
+	int mainPassMismatches{};
+	for (int iteration{}; iteration < 512; ++iteration)
+	{
+		DepthTriangle triangle{};
+		triangle.position1 = Vector4{ unit(generator) * 12.f - 2.f, unit(generator) * 12.f - 2.f, unit(generator), 1.f };
+		triangle.position2 = Vector4{ unit(generator) * 12.f - 2.f, unit(generator) * 12.f - 2.f, unit(generator), 1.f };
+		triangle.position3 = Vector4{ unit(generator) * 12.f - 2.f, unit(generator) * 12.f - 2.f, unit(generator), 1.f };
+		triangle.cullMode = static_cast<RenderConfig::CULL_MODE>(iteration % 3);
+
+		float depth[64]{};
+		for (float& value : depth)
+		{
+			value = unit(generator);
+		}
+
+		float depthReference[64]{};
+		std::copy(depth, depth + 64, depthReference);
+		float depthMainPass[64]{};
+		std::copy(depth, depth + 64, depthMainPass);
+
+		const int minX = iteration % 4;
+		const int maxY = 7 - iteration % 3;
+		kernels.RasterDepthTile(triangle, 0, 0, minX, 0, 7, maxY, depth);
+		reference.RasterDepthTile(triangle, 0, 0, minX, 0, 7, maxY, depthReference);
+
+		depthMismatches += static_cast<int>(std::memcmp(depth, depthReference, sizeof(depth)) != 0);
+
+		// Same per pixel steps as CPU_Renderer::RenderTriangle and TestDepth without a prepass
+		const Vector2 vertex1{ triangle.position1.x, triangle.position1.y };
+		const Vector2 vertex2{ triangle.position2.x, triangle.position2.y };
+		const Vector2 vertex3{ triangle.position3.x, triangle.position3.y };
+		for (int y{}; y <= maxY; ++y)
+		{
+			for (int x{ minX }; x <= 7; ++x)
+			{
+				const Vector2 point{ static_cast<float>(x), static_cast<float>(y) };
+
+				float w0 = DepthRasterizer::EdgeFunction(vertex2, vertex3, point);
+				float w1 = DepthRasterizer::EdgeFunction(vertex3, vertex1, point);
+				float w2 = DepthRasterizer::EdgeFunction(vertex1, vertex2, point);
+				if (!DepthRasterizer::IsCovered(triangle.cullMode, w0, w1, w2))
+				{
+					continue;
+				}
+
+				const float z = DepthRasterizer::InterpolateDepth(w0, w1, w2, triangle.position1.z, triangle.position2.z, triangle.position3.z);
+				if (z < 0 || z > 1 || z >= depthMainPass[8 * y + x])
+				{
+					continue;
+				}
+
+				depthMainPass[8 * y + x] = z;
+			}
+		}
+
+		mainPassMismatches += static_cast<int>(std::memcmp(depth, depthMainPass, sizeof(depth)) != 0);
+	}
+
+	// Upscale row, in 8 bit steps
+	constexpr int sourceWidth{ 93 };
+	constexpr int destinationWidth{ 141 };
+	constexpr int paddedWidth{ (destinationWidth + SimdDispatch::MaxWidth - 1) / SimdDispatch::MaxWidth * SimdDispatch::MaxWidth };
+
+	std::vector<uint32_t> row0(sourceWidth), row1(sourceWidth);
+	for (int x{}; x < sourceWidth; ++x)
+	{
+		row0[x] = static_cast<uint32_t>(generator()) & 0xFFFFFF;
+		row1[x] = static_cast<uint32_t>(generator()) & 0xFFFFFF;
+	}
+
+	std::vector<int> column0(paddedWidth), column1(paddedWidth);
+	std::vector<float> columnFraction(paddedWidth);
+	for (int x{}; x < paddedWidth; ++x)
+	{
+		const float sourceX = std::min(x, destinationWidth - 1) * (sourceWidth - 1) / static_cast<float>(destinationWidth);
+		column0[x] = static_cast<int>(sourceX);
+		column1[x] = std::min(column0[x] + 1, sourceWidth - 1);
+		columnFraction[x] = sourceX - column0[x];
+	}
+
+	std::vector<uint32_t> upscaled(destinationWidth), upscaledReference(destinationWidth);
+	UpscaleRowArgs args{ row0.data(), row1.data(), upscaled.data(), destinationWidth, column0.data(), column1.data(), columnFraction.data(),
+		0.3f, 0.6f, { 16, 8, 0 }, { 16, 8, 0 } };
+	kernels.UpscaleRow(args);
+	args.pOut = upscaledReference.data();
+	reference.UpscaleRow(args);
+
+	int upscaleError{};
+	for (int x{}; x < destinationWidth; ++x)
+	{
+		for (int shift{}; shift <= 16; shift += 8)
+		{
+			const int value = static_cast<int>((upscaled[x] >> shift) & 0xFF);
+			const int expected = static_cast<int>((upscaledReference[x] >> shift) & 0xFF);
+			upscaleError = std::max(upscaleError, std::abs(value - expected));
+		}
+	}
+
+	// Fast math, against the exact functions and the error budgets of FastMath.h rather than the scalar reference,
+	// the estimate instructions differ per level
+	constexpr int fastMathCount{ 4093 };
+	std::vector<float> x(fastMathCount), y(fastMathCount), result(fastMathCount);
+	std::uniform_real_distribution<float> exponent{ -60.f, 60.f };
+	bool isFastMathInBudget{ true };
+	float fastMathErrors[static_cast<int>(FAST_MATH_FUNCTION::ENUM_LENGTH)]{};
+	const float fastMathBudgets[]{ FastMath::RsqrtMaxError, FastMath::ReciprocalMaxError, FastMath::Exp2MaxError, FastMath::Log2MaxError, FastMath::PowMaxError };
+
+	for (int function{}; function < static_cast<int>(FAST_MATH_FUNCTION::ENUM_LENGTH); ++function)
+	{
+		const FAST_MATH_FUNCTION fastMathFunction = static_cast<FAST_MATH_FUNCTION>(function);
+		for (int index{}; index < fastMathCount; ++index)
+		{
+			// Spread over many binades, POW gets shading like values: a cosine and a specular exponent
+			x[index] = fastMathFunction == FAST_MATH_FUNCTION::EXP2 ? exponent(generator) : exp2f(exponent(generator));
+			y[index] = unit(generator) * 256.f;
+			if (fastMathFunction == FAST_MATH_FUNCTION::POW)
+			{
+				x[index] = unit(generator);
+			}
+		}
+
+		kernels.FastMathRow(fastMathFunction, x.data(), y.data(), result.data(), fastMathCount);
+
+		for (int index{}; index < fastMathCount; ++index)
+		{
+			const double value = x[index];
+			double expected{};
+			double scale{ 1.0 };
+
+			switch (fastMathFunction)
+			{
+			case FAST_MATH_FUNCTION::RSQRT:
+				expected = 1.0 / std::sqrt(value);
+				break;
+			case FAST_MATH_FUNCTION::RECIPROCAL:
+				expected = 1.0 / value;
+				break;
+			case FAST_MATH_FUNCTION::EXP2:
+				expected = std::exp2(value);
+				break;
+			case FAST_MATH_FUNCTION::LOG2:
+				// Absolute close to 1, relative further away
+				expected = std::log2(value);
+				scale = std::max(std::abs(expected), 1.0);
+				break;
+			default:
+				expected = std::pow(value, static_cast<double>(y[index]));
+				scale = 1.0 + std::abs(y[index] * std::log2(value));
+				break;
+			}
+
+			// Results that leave the normal range are clamped on purpose
+			if (expected == 0.0 || std::abs(expected) < FLT_MIN) continue;
+
+			const double reference = fastMathFunction == FAST_MATH_FUNCTION::LOG2 ? scale : std::abs(expected) * scale;
+			const float error = static_cast<float>(std::abs(result[index] - expected) / reference);
+			fastMathErrors[function] = std::max(fastMathErrors[function], error);
+		}
+
+		isFastMathInBudget = isFastMathInBudget && fastMathErrors[function] <= fastMathBudgets[function];
+	}
+
+	// Point lights, the sums run in another order per width. The approximate path only has to stay close to the exact one
+	constexpr int lightCount{ 203 };
+	std::vector<float> lightX(lightCount), lightY(lightCount), lightZ(lightCount), inverseRadiusSquared(lightCount);
+	std::vector<float> lightR(lightCount), lightG(lightCount), lightB(lightCount);
+	std::vector<int32_t> lightIndices(lightCount);
+	for (int index{}; index < lightCount; ++index)
+	{
+		lightX[index] = unit(generator) * 8.f - 4.f;
+		lightY[index] = unit(generator) * 8.f - 4.f;
+		lightZ[index] = unit(generator) * 8.f - 4.f;
+		inverseRadiusSquared[index] = 1.f / (1.f + unit(generator) * 36.f);
+		lightR[index] = unit(generator);
+		lightG[index] = unit(generator);
+		lightB[index] = unit(generator);
+		lightIndices[index] = (index * 37) % lightCount;
+	}
+
+	float pointLightError{};
+	float pointLightFastError{};
+	for (int iteration{}; iteration < 64; ++iteration)
+	{
+		PointLightArgs lightArgs{ lightX.data(), lightY.data(), lightZ.data(), inverseRadiusSquared.data(), lightR.data(), lightG.data(), lightB.data(),
+			lightIndices.data(), (iteration * 13) % lightCount + 1 };
+		lightArgs.position = Vector3{ unit(generator) * 4.f - 2.f, unit(generator) * 4.f - 2.f, unit(generator) * 4.f - 2.f };
+		lightArgs.normal = Vector3{ unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f }.Normalized();
+		lightArgs.viewDirection = Vector3{ unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f }.Normalized();
+		lightArgs.phongExponent = 1.f + unit(generator) * 24.f;
+		lightArgs.useSpecular = true;
+
+		ColorRGB lit[3]{}, specular[3]{};
+		kernels.ShadePointLights(lightArgs, lit[0], specular[0]);
+		reference.ShadePointLights(lightArgs, lit[1], specular[1]);
+		lightArgs.isFastMath = true;
+		kernels.ShadePointLights(lightArgs, lit[2], specular[2]);
+
+		for (int component{}; component < 3; ++component)
+		{
+			const float expectedLit = (&lit[1].r)[component];
+			const float expectedSpecular = (&specular[1].r)[component];
+			pointLightError = std::max(pointLightError, fabsf((&lit[0].r)[component] - expectedLit) / std::max(expectedLit, 1.f));
+			pointLightError = std::max(pointLightError, fabsf((&specular[0].r)[component] - expectedSpecular) / std::max(expectedSpecular, 1.f));
+			pointLightFastError = std::max(pointLightFastError, fabsf((&lit[2].r)[component] - expectedLit) / std::max(expectedLit, 1.f));
+			pointLightFastError = std::max(pointLightFastError, fabsf((&specular[2].r)[component] - expectedSpecular) / std::max(expectedSpecular, 1.f));
+		}
+	}
+
+	// PBR batches, full and partial ones. The approximate path only has to stay close to the exact one
+	float pbrError{};
+	float pbrFastError{};
+	PbrMaterial material{};
+	material.lightDirection = Vector3{ 0.577f, 0.577f, -0.577f };
+	material.lightRadiance = ColorRGB{ 7.f, 7.f, 7.f };
+	material.skyIrradiance = SphericalHarmonics::ProjectIrradiance(SphericalHarmonics::SkyRadiance, 16);
+	for (int iteration{}; iteration < 64; ++iteration)
+	{
+		PbrBatch batch{};
+		batch.count = iteration % PbrBatch::Size + 1;
+		for (int index{}; index < batch.count; ++index)
+		{
+			const Vector3 normal = Vector3{ unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f }.Normalized();
+			const Vector3 view = Vector3{ unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f }.Normalized();
+			batch.normalX[index] = normal.x;
+			batch.normalY[index] = normal.y;
+			batch.normalZ[index] = normal.z;
+			batch.viewX[index] = view.x;
+			batch.viewY[index] = view.y;
+			batch.viewZ[index] = view.z;
+			batch.albedoR[index] = unit(generator);
+			batch.albedoG[index] = unit(generator);
+			batch.albedoB[index] = unit(generator);
+			batch.specularR[index] = unit(generator) * 0.2f;
+			batch.specularG[index] = unit(generator) * 0.2f;
+			batch.specularB[index] = unit(generator) * 0.2f;
+			batch.glossiness[index] = unit(generator);
+			batch.visibility[index] = static_cast<float>(index % 3 != 0);
+			batch.ambientOcclusion[index] = unit(generator);
+		}
+
+		float red[3][PbrBatch::Capacity]{}, green[3][PbrBatch::Capacity]{}, blue[3][PbrBatch::Capacity]{};
+		material.isFastMath = false;
+		kernels.ShadePbrBatch(material, batch, red[0], green[0], blue[0]);
+		reference.ShadePbrBatch(material, batch, red[1], green[1], blue[1]);
+		material.isFastMath = true;
+		kernels.ShadePbrBatch(material, batch, red[2], green[2], blue[2]);
+
+		for (int index{}; index < batch.count; ++index)
+		{
+			const float* pChannels[3][3]{ { red[0], green[0], blue[0] }, { red[1], green[1], blue[1] }, { red[2], green[2], blue[2] } };
+			for (int channel{}; channel < 3; ++channel)
+			{
+				const float expected = pChannels[1][channel][index];
+				pbrError = std::max(pbrError, fabsf(pChannels[0][channel][index] - expected) / std::max(expected, 1.f));
+				pbrFastError = std::max(pbrFastError, fabsf(pChannels[2][channel][index] - expected) / std::max(expected, 1.f));
+			}
+		}
+	}
+
+	// Rays against a soup of random triangles, closest hits and occlusion of the same rays
+	constexpr int soupTriangleCount{ 2000 };
+	std::vector<Vector3> soupPositions(soupTriangleCount * 3);
+	std::vector<uint32_t> soupIndices(soupTriangleCount * 3);
+	for (int index{}; index < soupTriangleCount * 3; index += 3)
+	{
+		const Vector3 center{ unit(generator) * 8.f - 4.f, unit(generator) * 8.f - 4.f, unit(generator) * 8.f - 4.f };
+		for (int corner{}; corner < 3; ++corner)
+		{
+			soupPositions[index + corner] = center + Vector3{ unit(generator) - 0.5f, unit(generator) - 0.5f, unit(generator) - 0.5f };
+			soupIndices[index + corner] = index + corner;
+		}
+	}
+
+	Bvh soup{};
+	soup.Build(soupPositions, soupIndices);
+
+	int rayMismatches{};
+	float rayDistanceError{};
+	for (int iteration{}; iteration < 64; ++iteration)
+	{
+		RayPacket packets[2]{};
+		const Vector3 origin{ unit(generator) * 12.f - 6.f, unit(generator) * 12.f - 6.f, -8.f };
+		packets[0].count = iteration % RayPacket::Capacity + 1;
+		for (int ray{}; ray < packets[0].count; ++ray)
+		{
+			packets[0].originX[ray] = origin.x;
+			packets[0].originY[ray] = origin.y;
+			packets[0].originZ[ray] = origin.z;
+			packets[0].directionX[ray] = unit(generator) - 0.5f - origin.x * 0.1f;
+			packets[0].directionY[ray] = unit(generator) - 0.5f - origin.y * 0.1f;
+			packets[0].directionZ[ray] = 1.f;
+			packets[0].distance[ray] = 20.f;
+		}
+		packets[1] = packets[0];
+
+		const bool isOcclusion = iteration % 2 != 0;
+		kernels.TraceRays(soup.GetNodes(), soup.GetTriangles(), packets[0], isOcclusion);
+		reference.TraceRays(soup.GetNodes(), soup.GetTriangles(), packets[1], isOcclusion);
+
+		for (int ray{}; ray < packets[0].count; ++ray)
+		{
+			// Which occluder gets found first depends on the order the lanes traverse in, only whether there is one has to match
+			rayMismatches += isOcclusion ? (packets[0].primitive[ray] < 0) != (packets[1].primitive[ray] < 0) : packets[0].primitive[ray] != packets[1].primitive[ray];
+			rayDistanceError = std::max(rayDistanceError, fabsf(packets[0].distance[ray] - packets[1].distance[ray]) / packets[1].distance[ray]);
+		}
+	}
+
+	// sqrt and division are correctly rounded on every level, so only contracted multiply-adds could make a difference
+	const bool isValid = transformError <= 1e-5f && depthMismatches == 0 && mainPassMismatches == 0 && upscaleError <= 1 && isFastMathInBudget
+		&& pointLightError <= 1e-5f && pointLightFastError <= 1e-4f && pbrError <= 1e-5f && pbrFastError <= 1e-4f
+		&& rayMismatches == 0 && rayDistanceError <= 1e-5f;
+
+	std::cout << (isValid ? "\033[32m" : "\033[31m"); // TEXT COLOR
+	std::cout << "[SIMD] " << GetLevelName(s_Level) << " against the scalar reference:\n"
+		<< "  Transform kernels max relative error " << transformError << "\n"
+		<< "  RasterDepthTile mismatching tiles " << depthMismatches << " / 512, against the main pass " << mainPassMismatches << " / 512\n"
+		<< "  UpscaleRow max channel difference " << upscaleError << "\n"
+		<< "  FastMathRow max error rsqrt " << fastMathErrors[0] << ", reciprocal " << fastMathErrors[1] << ", exp2 " << fastMathErrors[2]
+		<< ", log2 " << fastMathErrors[3] << ", pow " << fastMathErrors[4] << "\n"
+		<< "  ShadePointLights max relative error " << pointLightError << ", approximate " << pointLightFastError << "\n"
+		<< "  ShadePbrBatch max relative error " << pbrError << ", approximate " << pbrFastError << "\n"
+		<< "  TraceRays mismatching hits " << rayMismatches << ", max relative distance error " << rayDistanceError << std::endl;
+	std::cout << "\033[37m"; // TEXT COLOR WHITE
+
+	return isValid;
+}
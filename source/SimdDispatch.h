@@ -0,0 +1,248 @@
+#pragma once
+#include <cstdint>
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix.h"
+#include "ColorRGB.h"
+#include "SphericalHarmonics.h"
+#include "Bvh.h"
+#include "RenderConfig.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_ARCH_X86
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define SIMD_ARCH_ARM64
+#endif
+
+#define SIMD_KERNELS (SimdDispatch::GetKernels())
+
+enum class SIMD_LEVEL
+{
+	SCALAR,
+	SSE2,
+	AVX2,
+	AVX512,
+	NEON,
+	ENUM_LENGTH
+};
+
+// One triangle for the depth-only raster kernel, positions in raster space with the depth in z
+struct DepthTriangle
+{
+	Vector4 position1{};
+	Vector4 position2{};
+	Vector4 position3{};
+	RenderConfig::CULL_MODE cullMode{};
+};
+
+// One destination row of the SpatialUpscaler
+struct UpscaleRowArgs
+{
+	const uint32_t* pRow0{};
+	const uint32_t* pRow1{};
+	uint32_t* pOut{};
+	int width{};
+
+	// Source taps per destination column, padded to a multiple of SimdDispatch::MaxWidth
+	const int* pColumn0{};
+	const int* pColumn1{};
+	const float* pColumnFraction{};
+
+	float rowFraction{};
+	float sharpness{};
+
+	int sourceShifts[3]{};
+	int destinationShifts[3]{};
+};
+
+// The point lights of one LightGrid cluster lit at one surface point. Lights are structure of
+// arrays, pIndices picks the ones of the cluster. viewDirection and normal are normalized
+struct PointLightArgs
+{
+	const float* pPositionX{};
+	const float* pPositionY{};
+	const float* pPositionZ{};
+	const float* pInverseRadiusSquared{};
+	const float* pColorR{};
+	const float* pColorG{};
+	const float* pColorB{};
+
+	const int32_t* pIndices{};
+	int count{};
+
+	Vector3 position{};
+	Vector3 normal{};
+	Vector3 viewDirection{};
+	float phongExponent{};
+	bool useSpecular{};
+	bool isFastMath{};
+};
+
+// What the PBR shading of one material shares across all of its pixels
+struct PbrMaterial
+{
+	// Towards the light, normalized
+	Vector3 lightDirection{};
+	// Light color times intensity
+	ColorRGB lightRadiance{};
+
+	// roughness = max(glossiness * roughnessScale + roughnessBias, MinRoughness), GGX alpha is its square
+	float roughnessScale{ -1.f };
+	float roughnessBias{ 1.f };
+
+	IrradianceSH skyIrradiance{};
+	bool isFastMath{};
+
+	// Keeps the GGX peak of a mirror-like surface finite
+	static constexpr float MinRoughness{ 0.045f };
+};
+
+// Pixels shaded together by SimdKernels::ShadePbrBatch, structure of arrays. The arrays are padded to
+// SimdDispatch::MaxWidth so every level loads whole vectors, lanes from count on are ignored
+struct PbrBatch
+{
+	static constexpr int Size{ 8 };
+	static constexpr int Capacity{ 16 };
+
+	// Normalized, the view direction points from the camera to the surface like Vertex_Out::viewDirection
+	alignas(64) float normalX[Capacity]{};
+	alignas(64) float normalY[Capacity]{};
+	alignas(64) float normalZ[Capacity]{};
+	alignas(64) float viewX[Capacity]{};
+	alignas(64) float viewY[Capacity]{};
+	alignas(64) float viewZ[Capacity]{};
+
+	// Diffuse texture, reflectance at normal incidence (specular texture) and glossiness
+	alignas(64) float albedoR[Capacity]{};
+	alignas(64) float albedoG[Capacity]{};
+	alignas(64) float albedoB[Capacity]{};
+	alignas(64) float specularR[Capacity]{};
+	alignas(64) float specularG[Capacity]{};
+	alignas(64) float specularB[Capacity]{};
+	alignas(64) float glossiness[Capacity]{};
+
+	// Fraction of the directional light that is not shadowed
+	alignas(64) float visibility[Capacity]{};
+	// Fraction of the sky that is not occluded, scales its irradiance
+	alignas(64) float ambientOcclusion[Capacity]{};
+
+	int count{};
+};
+
+// Rays traced together by SimdKernels::TraceRays, structure of arrays padded like PbrBatch.
+// A packet holds neighbouring rays, so they mostly visit the same nodes
+struct RayPacket
+{
+	static constexpr int Capacity{ 16 };
+
+	alignas(64) float originX[Capacity]{};
+	alignas(64) float originY[Capacity]{};
+	alignas(64) float originZ[Capacity]{};
+	// Need not be normalized, distances are in multiples of the direction
+	alignas(64) float directionX[Capacity]{};
+	alignas(64) float directionY[Capacity]{};
+	alignas(64) float directionZ[Capacity]{};
+	// Hits have to be closer than this, the closest hit replaces it
+	alignas(64) float distance[Capacity]{};
+
+	// BvhTriangle::primitive of the hit or -1, u and v weigh the second and third vertex
+	alignas(64) int32_t primitive[Capacity]{};
+	alignas(64) float u[Capacity]{};
+	alignas(64) float v[Capacity]{};
+
+	int count{};
+};
+
+// Functions of FastMath.h that have a wide form in SimdWide.h
+enum class FAST_MATH_FUNCTION
+{
+	RSQRT,
+	RECIPROCAL,
+	EXP2,
+	LOG2,
+	POW,
+	ENUM_LENGTH
+};
+
+// Every kernel exists once per instruction set, all of them compiled from SimdKernels.inl
+struct SimdKernels
+{
+	// World space positions to raster space, x and y in pixels, z divided by w like the vertex stage does
+	void (*TransformToRaster)(const Vector3* pPositions, Vector4* pOut, int count, const Matrix& viewProjection, float width, float height);
+
+	// Matrix::TransformPoints and Matrix::TransformVectorsAndNormalize, pOut can be pIn
+	void (*TransformPoints)(const Vector3* pIn, Vector3* pOut, int count, const Matrix& matrix);
+	void (*TransformVectorsAndNormalize)(const Vector3* pIn, Vector3* pOut, int count, const Matrix& matrix);
+
+	// Depth test and write of one 8x8 TiledLayout tile, only the pixels inside the inclusive rect
+	void (*RasterDepthTile)(const DepthTriangle& triangle, int tileMinX, int tileMinY, int minX, int minY, int maxX, int maxY, float* pTileDepth);
+
+	// Edge adaptive bilinear sample (gathered texel fetches), sharpen and pack of one row
+	void (*UpscaleRow)(const UpscaleRowArgs& args);
+
+	// pOut[i] = function(pX[i]), or function(pX[i], pY[i]) for POW
+	void (*FastMathRow)(FAST_MATH_FUNCTION function, const float* pX, const float* pY, float* pOut, int count);
+
+	// Sums of the irradiance (attenuated color * N.L) and of the irradiance times the Phong lobe over the lights,
+	// one light per lane. Shading::Lambert and the reflectance of Shading::Phong get applied by the caller
+	void (*ShadePointLights)(const PointLightArgs& args, ColorRGB& irradiance, ColorRGB& specular);
+
+	// GGX distribution, Smith (Schlick-GGX) geometry and Schlick Fresnel for the directional light, plus the
+	// Lambert diffuse of the light and the sky. Writes PbrBatch::Capacity colors
+	void (*ShadePbrBatch)(const PbrMaterial& material, const PbrBatch& batch, float* pRed, float* pGreen, float* pBlue);
+
+	// Closest hit of every ray of the packet, Width rays traverse the tree together.
+	// Occlusion rays stop at the first hit they find, its distance is not the closest one. Takes the arrays of Bvh
+	void (*TraceRays)(const BvhNode* pNodes, const BvhTriangle* pTriangles, RayPacket& packet, bool isOcclusion);
+};
+
+/**
+	* Picks the SIMD kernels of the software rasterizer at startup. The kernels are
+	* compiled once per instruction set (each in its own translation unit with its own
+	* compiler flags), cpuid decides which of them the host can run. The scalar
+	* kernels are the reference the wide ones get validated against.
+	* Raster covers the depth prepass only, sampling and packing only the upscaler rows.
+	* The shading pass of CPU_Renderer::RenderTriangle, Texture::Sample and PackColor
+	* work on one fragment at a time and stay scalar, compiled for the baseline: a
+	* fragment gets sampled only after its own depth test, with UVs of its own
+	* triangle, so wide sampling would need fragments queued first the way the PBR
+	* pass fills a PbrBatch.
+	*/
+class SimdDispatch
+{
+public:
+	// Widest vector of all instruction sets in floats, tables that kernels read past the end get padded to this
+	static constexpr int MaxWidth{ 16 };
+
+	// Widest level the CPU and OS support
+	static SIMD_LEVEL DetectLevel();
+
+	// Falls back to the detected level if the host can not run the requested one
+	static void Select(SIMD_LEVEL level);
+
+	static const SimdKernels& GetKernels();
+	static SIMD_LEVEL GetLevel();
+
+	static const char* GetLevelName(SIMD_LEVEL level);
+	// Case insensitive, "scalar", "sse2", "avx2", "avx512" or "neon"
+	static bool ParseLevel(const char* pName, SIMD_LEVEL& level);
+
+	// Runs every kernel of the selected level and of the scalar reference on the same inputs and prints the differences
+	static bool Validate();
+
+private:
+	static SIMD_LEVEL s_Level;
+	static const SimdKernels* s_pKernels;
+
+	static bool IsSupported(SIMD_LEVEL level);
+};
+
+static_assert(PbrBatch::Capacity >= SimdDispatch::MaxWidth);
+static_assert(RayPacket::Capacity >= SimdDispatch::MaxWidth);
+
+// Defined by the per instruction set translation units, nullptr where the target can not build them
+const SimdKernels* GetScalarKernels();
+const SimdKernels* GetSse2Kernels();
+const SimdKernels* GetAvx2Kernels();
+const SimdKernels* GetAvx512Kernels();
+const SimdKernels* GetNeonKernels();
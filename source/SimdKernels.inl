@@ -0,0 +1,774 @@
+// Kernels of SimdDispatch, written once against the wide types of SimdWide.h.
+// Included by the per instruction set translation units after SimdWide.h
+
+// The depth kernel has to match the scalar main pass bit for bit, a multiply-add contracted on one level only would break that
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace SIMD_NAMESPACE
+{
+	// Internal linkage like SimdWide.h, GetKernels of the translation unit hands out the table
+	namespace
+	{
+		// The kernels touch the math types of the renderer only as plain floats. Their member functions are inline
+		// and shared with the baseline translation units, the linker could keep a copy compiled with the flags of this one
+		struct MatrixRows
+		{
+			float values[4][4];
+		};
+
+		inline MatrixRows GetRows(const Matrix& matrix)
+		{
+			static_assert(sizeof(Matrix) == sizeof(MatrixRows));
+
+			MatrixRows rows;
+			std::memcpy(&rows, &matrix, sizeof(MatrixRows));
+			return rows;
+		}
+
+		// std::copy for the same reason
+		template<typename T>
+		inline void Copy(const T* pFrom, T* pTo, int count)
+		{
+			for (int index{}; index < count; ++index)
+			{
+				pTo[index] = pFrom[index];
+			}
+		}
+
+		void TransformToRaster(const Vector3* pPositions, Vector4* pOut, int count, const Matrix& viewProjection, float width, float height)
+		{
+			const MatrixRows rows = GetRows(viewProjection);
+			const float* row0 = rows.values[0];
+			const float* row1 = rows.values[1];
+			const float* row2 = rows.values[2];
+			const float* row3 = rows.values[3];
+
+			// Positions are 3 floats apart, the gathers pick x, y and z of Width vertices at once
+			const WideInt vertexOffsets = IotaInt() + IotaInt() + IotaInt();
+			const float* pFloats = &pPositions[0].x;
+			float* pOutFloats = &pOut[0].x;
+
+			alignas(64) float lanes[4][Width];
+
+			int index{};
+			for (; index + Width <= count; index += Width)
+			{
+				const float* pFirst = pFloats + 3 * index;
+				const WideFloat x = Gather(pFirst, vertexOffsets);
+				const WideFloat y = Gather(pFirst + 1, vertexOffsets);
+				const WideFloat z = Gather(pFirst + 2, vertexOffsets);
+
+				// Same operation order as Matrix::TransformPoint and the vertex stage, so every width gives the same result
+				const WideFloat w = x * Set(row0[3]) + y * Set(row1[3]) + z * Set(row2[3]) + Set(row3[3]);
+				const WideFloat projectedX = (x * Set(row0[0]) + y * Set(row1[0]) + z * Set(row2[0]) + Set(row3[0])) / w;
+				const WideFloat projectedY = (x * Set(row0[1]) + y * Set(row1[1]) + z * Set(row2[1]) + Set(row3[1])) / w;
+				const WideFloat projectedZ = (x * Set(row0[2]) + y * Set(row1[2]) + z * Set(row2[2]) + Set(row3[2])) / w;
+
+				// NDC to raster coordinates
+				Store(lanes[0], ((projectedX + Set(1.f)) * Set(width)) / Set(2.f));
+				Store(lanes[1], ((Set(1.f) - projectedY) * Set(height)) / Set(2.f));
+				Store(lanes[2], projectedZ);
+				Store(lanes[3], w);
+
+				for (int lane{}; lane < Width; ++lane)
+				{
+					for (int component{}; component < 4; ++component)
+					{
+						pOutFloats[4 * (index + lane) + component] = lanes[component][lane];
+					}
+				}
+			}
+
+			for (; index < count; ++index)
+			{
+				const float* position = pFloats + 3 * index;
+				const float w = position[0] * row0[3] + position[1] * row1[3] + position[2] * row2[3] + row3[3];
+				const float projectedX = (position[0] * row0[0] + position[1] * row1[0] + position[2] * row2[0] + row3[0]) / w;
+				const float projectedY = (position[0] * row0[1] + position[1] * row1[1] + position[2] * row2[1] + row3[1]) / w;
+				const float projectedZ = (position[0] * row0[2] + position[1] * row1[2] + position[2] * row2[2] + row3[2]) / w;
+
+				float* pRaster = pOutFloats + 4 * index;
+				pRaster[0] = ((projectedX + 1.f) * width) / 2.f;
+				pRaster[1] = ((1.f - projectedY) * height) / 2.f;
+				pRaster[2] = projectedZ;
+				pRaster[3] = w;
+			}
+		}
+
+		void TransformPoints(const Vector3* pIn, Vector3* pOut, int count, const Matrix& matrix)
+		{
+			const MatrixRows rows = GetRows(matrix);
+			const float* row0 = rows.values[0];
+			const float* row1 = rows.values[1];
+			const float* row2 = rows.values[2];
+			const float* row3 = rows.values[3];
+
+			const WideInt vertexOffsets = IotaInt() + IotaInt() + IotaInt();
+			const float* pFloats = &pIn[0].x;
+			float* pOutFloats = &pOut[0].x;
+
+			alignas(64) float lanes[3][Width];
+
+			int index{};
+			for (; index + Width <= count; index += Width)
+			{
+				// All lanes are read before any is written, so pOut can be pIn
+				const float* pFirst = pFloats + 3 * index;
+				const WideFloat x = Gather(pFirst, vertexOffsets);
+				const WideFloat y = Gather(pFirst + 1, vertexOffsets);
+				const WideFloat z = Gather(pFirst + 2, vertexOffsets);
+
+				// Same operation order as Matrix::TransformPoint
+				Store(lanes[0], x * Set(row0[0]) + y * Set(row1[0]) + z * Set(row2[0]) + Set(row3[0]));
+				Store(lanes[1], x * Set(row0[1]) + y * Set(row1[1]) + z * Set(row2[1]) + Set(row3[1]));
+				Store(lanes[2], x * Set(row0[2]) + y * Set(row1[2]) + z * Set(row2[2]) + Set(row3[2]));
+
+				for (int lane{}; lane < Width; ++lane)
+				{
+					for (int component{}; component < 3; ++component)
+					{
+						pOutFloats[3 * (index + lane) + component] = lanes[component][lane];
+					}
+				}
+			}
+
+			for (; index < count; ++index)
+			{
+				// Copied first, pOut can be pIn
+				const float x = pFloats[3 * index];
+				const float y = pFloats[3 * index + 1];
+				const float z = pFloats[3 * index + 2];
+
+				pOutFloats[3 * index] = x * row0[0] + y * row1[0] + z * row2[0] + row3[0];
+				pOutFloats[3 * index + 1] = x * row0[1] + y * row1[1] + z * row2[1] + row3[1];
+				pOutFloats[3 * index + 2] = x * row0[2] + y * row1[2] + z * row2[2] + row3[2];
+			}
+		}
+
+		void TransformVectorsAndNormalize(const Vector3* pIn, Vector3* pOut, int count, const Matrix& matrix)
+		{
+			const MatrixRows rows = GetRows(matrix);
+			const float* row0 = rows.values[0];
+			const float* row1 = rows.values[1];
+			const float* row2 = rows.values[2];
+
+			const WideInt vertexOffsets = IotaInt() + IotaInt() + IotaInt();
+			const float* pFloats = &pIn[0].x;
+			float* pOutFloats = &pOut[0].x;
+
+			alignas(64) float lanes[3][Width];
+
+			int index{};
+			for (; index + Width <= count; index += Width)
+			{
+				const float* pFirst = pFloats + 3 * index;
+				const WideFloat x = Gather(pFirst, vertexOffsets);
+				const WideFloat y = Gather(pFirst + 1, vertexOffsets);
+				const WideFloat z = Gather(pFirst + 2, vertexOffsets);
+
+				const WideFloat vectorX = x * Set(row0[0]) + y * Set(row1[0]) + z * Set(row2[0]);
+				const WideFloat vectorY = x * Set(row0[1]) + y * Set(row1[1]) + z * Set(row2[1]);
+				const WideFloat vectorZ = x * Set(row0[2]) + y * Set(row1[2]) + z * Set(row2[2]);
+
+				// Exact sqrt and divide like Vector3::Normalized
+				const WideFloat magnitude = Sqrt(vectorX * vectorX + vectorY * vectorY + vectorZ * vectorZ);
+				Store(lanes[0], vectorX / magnitude);
+				Store(lanes[1], vectorY / magnitude);
+				Store(lanes[2], vectorZ / magnitude);
+
+				for (int lane{}; lane < Width; ++lane)
+				{
+					for (int component{}; component < 3; ++component)
+					{
+						pOutFloats[3 * (index + lane) + component] = lanes[component][lane];
+					}
+				}
+			}
+
+			for (; index < count; ++index)
+			{
+				const float x = pFloats[3 * index];
+				const float y = pFloats[3 * index + 1];
+				const float z = pFloats[3 * index + 2];
+				const float vectorX = x * row0[0] + y * row1[0] + z * row2[0];
+				const float vectorY = x * row0[1] + y * row1[1] + z * row2[1];
+				const float vectorZ = x * row0[2] + y * row1[2] + z * row2[2];
+
+				const float magnitude = sqrtf(vectorX * vectorX + vectorY * vectorY + vectorZ * vectorZ);
+				pOutFloats[3 * index] = vectorX / magnitude;
+				pOutFloats[3 * index + 1] = vectorY / magnitude;
+				pOutFloats[3 * index + 2] = vectorZ / magnitude;
+			}
+		}
+
+		void RasterDepthTile(const DepthTriangle& triangle, int tileMinX, int tileMinY, int minX, int minY, int maxX, int maxY, float* pTileDepth)
+		{
+			const Vector4& position1 = triangle.position1;
+			const Vector4& position2 = triangle.position2;
+			const Vector4& position3 = triangle.position3;
+
+			// Same operations in the same order as DepthRasterizer::EdgeFunction of the main pass
+			const WideFloat startX0 = Set(position2.x), startY0 = Set(position2.y);
+			const WideFloat sideX0 = Set(position3.x - position2.x), sideY0 = Set(position3.y - position2.y);
+			const WideFloat startX1 = Set(position3.x), startY1 = Set(position3.y);
+			const WideFloat sideX1 = Set(position1.x - position3.x), sideY1 = Set(position1.y - position3.y);
+			const WideFloat startX2 = Set(position1.x), startY2 = Set(position1.y);
+			const WideFloat sideX2 = Set(position2.x - position1.x), sideY2 = Set(position2.y - position1.y);
+
+			const WideFloat z1 = Set(position1.z);
+			const WideFloat z2 = Set(position2.z);
+			const WideFloat z3 = Set(position3.z);
+
+			const WideFloat zero = Set(0.f);
+			const WideFloat one = Set(1.f);
+
+			const WideFloat rectMinX = Set(static_cast<float>(minX));
+			const WideFloat rectMinY = Set(static_cast<float>(minY));
+			const WideFloat rectMaxX = Set(static_cast<float>(maxX));
+			const WideFloat rectMaxY = Set(static_cast<float>(maxY));
+
+			// The 64 depths of a tile are contiguous, row-major inside the tile, so Width of them are one load
+			for (int first{}; first < 64; first += Width)
+			{
+				const WideInt pixel = IotaInt() + SetInt(first);
+				const WideFloat pointX = ToFloat(pixel & SetInt(7)) + Set(static_cast<float>(tileMinX));
+				const WideFloat pointY = ToFloat(ShiftRight(pixel, 3)) + Set(static_cast<float>(tileMinY));
+
+				const WideMask isInRect = (pointX >= rectMinX) & (pointX <= rectMaxX) & (pointY >= rectMinY) & (pointY <= rectMaxY);
+				if (MaskBits(isInRect) == 0)
+				{
+					continue;
+				}
+
+				WideFloat w0 = sideX0 * (pointY - startY0) - sideY0 * (pointX - startX0);
+				WideFloat w1 = sideX1 * (pointY - startY1) - sideY1 * (pointX - startX1);
+				WideFloat w2 = sideX2 * (pointY - startY2) - sideY2 * (pointX - startX2);
+
+				const WideMask allPositive = (w0 >= zero) & (w1 >= zero) & (w2 >= zero);
+
+				WideMask coverage{};
+				switch (triangle.cullMode)
+				{
+				case RenderConfig::CULL_MODE::BACK:
+					coverage = allPositive;
+					break;
+				case RenderConfig::CULL_MODE::FRONT:
+					coverage = (w0 < zero) & (w1 < zero) & (w2 < zero);
+					break;
+				default:
+					coverage = allPositive | ((w0 <= zero) & (w1 <= zero) & (w2 <= zero));
+					break;
+				}
+
+				coverage = coverage & isInRect;
+				if (MaskBits(coverage) == 0)
+				{
+					continue;
+				}
+
+				const WideFloat area = w0 + w1 + w2;
+				w0 = w0 / area;
+				w1 = w1 / area;
+				w2 = w2 / area;
+
+				const WideFloat z = one / (w0 / z1 + w1 / z2 + w2 / z3);
+
+				const WideFloat storedDepth = Load(pTileDepth + first);
+				const WideMask isWritten = coverage & (z < storedDepth) & (z >= zero) & (z <= one);
+
+				if (MaskBits(isWritten) == 0)
+				{
+					continue;
+				}
+
+				Store(pTileDepth + first, Select(isWritten, z, storedDepth));
+			}
+		}
+
+		// How hard interpolation weights get pulled towards the nearest texel across an edge
+		constexpr float EdgeSharpness{ 2.f };
+		// Luma difference (0-255, summed over two texel pairs) at which an edge counts as fully strong
+		constexpr float EdgeContrast{ 96.f };
+
+		struct ColorLanes
+		{
+			WideFloat r;
+			WideFloat g;
+			WideFloat b;
+		};
+
+		inline WideFloat UnpackChannel(WideInt pixels, int shift)
+		{
+			return ToFloat(ShiftRight(pixels, shift) & SetInt(0xFF));
+		}
+
+		inline ColorLanes Unpack(WideInt pixels, const int* pShifts)
+		{
+			return { UnpackChannel(pixels, pShifts[0]), UnpackChannel(pixels, pShifts[1]), UnpackChannel(pixels, pShifts[2]) };
+		}
+
+		inline WideInt Pack(const ColorLanes& color, const int* pShifts)
+		{
+			return ShiftLeft(RoundToInt(Saturate(color.r, 255.f)), pShifts[0])
+				| (ShiftLeft(RoundToInt(Saturate(color.g, 255.f)), pShifts[1]) | ShiftLeft(RoundToInt(Saturate(color.b, 255.f)), pShifts[2]));
+		}
+
+		inline WideFloat Luma(const ColorLanes& c)
+		{
+			return ((c.r + c.b) + (c.g + c.g)) * Set(0.25f);
+		}
+
+		// Contrast adaptive sharpen of one channel, limited to the 2x2 source footprint
+		inline WideFloat Sharpen(WideFloat value, WideFloat a, WideFloat b, WideFloat c, WideFloat d, WideFloat sharpness)
+		{
+			const WideFloat minimum = Min(Min(a, b), Min(c, d));
+			const WideFloat maximum = Max(Max(a, b), Max(c, d));
+			const WideFloat mean = ((a + b) + (c + d)) * Set(0.25f);
+
+			// Less sharpening where the neighbourhood is already close to black or white
+			const WideFloat headroom = Min(minimum, Set(255.f) - maximum);
+			const WideFloat amplitude = Sqrt(Saturate(headroom / (maximum + Set(1.f))));
+
+			const WideFloat sharpened = value + (value - mean) * (amplitude * sharpness);
+			return Min(Max(sharpened, minimum), maximum);
+		}
+
+		void UpscaleRow(const UpscaleRowArgs& args)
+		{
+			const int32_t* pRow0 = reinterpret_cast<const int32_t*>(args.pRow0);
+			const int32_t* pRow1 = reinterpret_cast<const int32_t*>(args.pRow1);
+
+			const WideFloat one = Set(1.f);
+			const WideFloat half = Set(0.5f);
+			const WideFloat epsilon = Set(1e-3f);
+			const WideFloat edgeSharpness = Set(EdgeSharpness);
+			const WideFloat inverseEdgeContrast = Set(1.f / EdgeContrast);
+			const WideFloat sharpness = Set(args.sharpness);
+			const WideFloat rowFraction = Set(args.rowFraction);
+
+			for (int x{}; x < args.width; x += Width)
+			{
+				const WideInt column0 = LoadInt(args.pColumn0 + x);
+				const WideInt column1 = LoadInt(args.pColumn1 + x);
+
+				// 2x2 source footprint of Width destination pixels
+				const ColorLanes a = Unpack(Gather(pRow0, column0), args.sourceShifts);
+				const ColorLanes b = Unpack(Gather(pRow0, column1), args.sourceShifts);
+				const ColorLanes c = Unpack(Gather(pRow1, column0), args.sourceShifts);
+				const ColorLanes d = Unpack(Gather(pRow1, column1), args.sourceShifts);
+
+				const WideFloat lumaA = Luma(a);
+				const WideFloat lumaB = Luma(b);
+				const WideFloat lumaC = Luma(c);
+				const WideFloat lumaD = Luma(d);
+
+				// Horizontal change means a vertical edge and the other way around
+				const WideFloat gradientX = Abs(lumaA - lumaB) + Abs(lumaC - lumaD);
+				const WideFloat gradientY = Abs(lumaA - lumaC) + Abs(lumaB - lumaD);
+				const WideFloat gradientSum = (gradientX + gradientY) + epsilon;
+				const WideFloat contrast = Saturate(Max(gradientX, gradientY) * inverseEdgeContrast);
+
+				// Steepen the fraction across the dominant edge, keep interpolating along it
+				const WideFloat steepnessX = one + edgeSharpness * (contrast * (gradientX / gradientSum));
+				const WideFloat steepnessY = one + edgeSharpness * (contrast * (gradientY / gradientSum));
+
+				const WideFloat fractionX = Saturate((Load(args.pColumnFraction + x) - half) * steepnessX + half);
+				const WideFloat fractionY = Saturate((rowFraction - half) * steepnessY + half);
+
+				ColorLanes result{};
+				result.r = Lerp(Lerp(a.r, b.r, fractionX), Lerp(c.r, d.r, fractionX), fractionY);
+				result.g = Lerp(Lerp(a.g, b.g, fractionX), Lerp(c.g, d.g, fractionX), fractionY);
+				result.b = Lerp(Lerp(a.b, b.b, fractionX), Lerp(c.b, d.b, fractionX), fractionY);
+
+				result.r = Sharpen(result.r, a.r, b.r, c.r, d.r, sharpness);
+				result.g = Sharpen(result.g, a.g, b.g, c.g, d.g, sharpness);
+				result.b = Sharpen(result.b, a.b, b.b, c.b, d.b, sharpness);
+
+				const WideInt packed = Pack(result, args.destinationShifts);
+				int32_t* pOut = reinterpret_cast<int32_t*>(args.pOut) + x;
+
+				if (x + Width <= args.width)
+				{
+					StoreInt(pOut, packed);
+				}
+				else
+				{
+					alignas(64) int32_t tail[Width];
+					StoreInt(tail, packed);
+					Copy(tail, pOut, args.width - x);
+				}
+			}
+		}
+
+		WideFloat EvaluateFastMath(FAST_MATH_FUNCTION function, WideFloat x, WideFloat y)
+		{
+			switch (function)
+			{
+			case FAST_MATH_FUNCTION::RSQRT:
+				return Rsqrt(x);
+			case FAST_MATH_FUNCTION::RECIPROCAL:
+				return Reciprocal(x);
+			case FAST_MATH_FUNCTION::EXP2:
+				return Exp2(x);
+			case FAST_MATH_FUNCTION::LOG2:
+				return Log2(x);
+			default:
+				return Pow(x, y);
+			}
+		}
+
+		void FastMathRow(FAST_MATH_FUNCTION function, const float* pX, const float* pY, float* pOut, int count)
+		{
+			int index{};
+			for (; index + Width <= count; index += Width)
+			{
+				Store(pOut + index, EvaluateFastMath(function, Load(pX + index), Load(pY + index)));
+			}
+
+			if (index < count)
+			{
+				// Ones keep the unused lanes inside the domain of every function
+				alignas(64) float x[Width];
+				alignas(64) float y[Width];
+				for (int lane{}; lane < Width; ++lane)
+				{
+					x[lane] = 1.f;
+					y[lane] = 1.f;
+				}
+				Copy(pX + index, x, count - index);
+				Copy(pY + index, y, count - index);
+
+				alignas(64) float result[Width];
+				Store(result, EvaluateFastMath(function, Load(x), Load(y)));
+				Copy(result, pOut + index, count - index);
+			}
+		}
+
+		void ShadePointLights(const PointLightArgs& args, ColorRGB& irradiance, ColorRGB& specular)
+		{
+			const WideFloat positionX = Set(args.position.x);
+			const WideFloat positionY = Set(args.position.y);
+			const WideFloat positionZ = Set(args.position.z);
+			const WideFloat normalX = Set(args.normal.x);
+			const WideFloat normalY = Set(args.normal.y);
+			const WideFloat normalZ = Set(args.normal.z);
+			const WideFloat viewX = Set(args.viewDirection.x);
+			const WideFloat viewY = Set(args.viewDirection.y);
+			const WideFloat viewZ = Set(args.viewDirection.z);
+			const WideFloat normalDotView = Set(args.normal.x * args.viewDirection.x + args.normal.y * args.viewDirection.y + args.normal.z * args.viewDirection.z);
+			const WideFloat phongExponent = Set(args.phongExponent);
+			const WideFloat zero = Set(0.f);
+			const WideFloat one = Set(1.f);
+			const WideFloat laneIndices = ToFloat(IotaInt());
+
+			WideFloat irradianceR = zero;
+			WideFloat irradianceG = zero;
+			WideFloat irradianceB = zero;
+			WideFloat specularR = zero;
+			WideFloat specularG = zero;
+			WideFloat specularB = zero;
+
+			for (int index{}; index < args.count; index += Width)
+			{
+				// The tail repeats the first light, the mask drops it again
+				alignas(64) int32_t tail[Width]{};
+				const int32_t* pIndices = args.pIndices + index;
+				if (index + Width > args.count)
+				{
+					Copy(pIndices, tail, args.count - index);
+					pIndices = tail;
+				}
+
+				const WideInt lights = LoadInt(pIndices);
+				const WideMask isLight = laneIndices < Set(static_cast<float>(args.count - index));
+
+				const WideFloat toLightX = Gather(args.pPositionX, lights) - positionX;
+				const WideFloat toLightY = Gather(args.pPositionY, lights) - positionY;
+				const WideFloat toLightZ = Gather(args.pPositionZ, lights) - positionZ;
+				const WideFloat distanceSquared = Max(toLightX * toLightX + toLightY * toLightY + toLightZ * toLightZ, Set(1e-8f));
+				const WideFloat inverseDistance = args.isFastMath ? Rsqrt(distanceSquared) : one / Sqrt(distanceSquared);
+
+				// Normalized direction to the light, the opposite of the l Shading::Phong takes
+				const WideFloat lightX = toLightX * inverseDistance;
+				const WideFloat lightY = toLightY * inverseDistance;
+				const WideFloat lightZ = toLightZ * inverseDistance;
+				const WideFloat cosine = lightX * normalX + lightY * normalY + lightZ * normalZ;
+
+				// Smooth window that reaches 0 at the radius, so the cluster bounds are exact
+				const WideFloat window = Max(one - distanceSquared * Gather(args.pInverseRadiusSquared, lights), zero);
+				const WideFloat intensity = Select(isLight & (zero < cosine), window * window * cosine, zero);
+
+				const WideFloat lightR = Gather(args.pColorR, lights) * intensity;
+				const WideFloat lightG = Gather(args.pColorG, lights) * intensity;
+				const WideFloat lightB = Gather(args.pColorB, lights) * intensity;
+				irradianceR = irradianceR + lightR;
+				irradianceG = irradianceG + lightG;
+				irradianceB = irradianceB + lightB;
+
+				if (!args.useSpecular || MaskBits(zero < intensity) == 0)
+				{
+					continue;
+				}
+
+				// reflect(l, n) . v of Shading::Phong with l = -light
+				const WideFloat angle = Max(lightX * viewX + lightY * viewY + lightZ * viewZ - Set(2.f) * cosine * normalDotView, zero);
+
+				WideFloat lobe{};
+				if (args.isFastMath)
+				{
+					lobe = Pow(angle, phongExponent);
+				}
+				else
+				{
+					alignas(64) float lanes[Width];
+					Store(lanes, angle);
+					for (float& lane : lanes)
+					{
+						lane = powf(lane, args.phongExponent);
+					}
+					lobe = Load(lanes);
+				}
+
+				specularR = specularR + lightR * lobe;
+				specularG = specularG + lightG * lobe;
+				specularB = specularB + lightB * lobe;
+			}
+
+			alignas(64) float lanes[6][Width];
+			Store(lanes[0], irradianceR);
+			Store(lanes[1], irradianceG);
+			Store(lanes[2], irradianceB);
+			Store(lanes[3], specularR);
+			Store(lanes[4], specularG);
+			Store(lanes[5], specularB);
+
+			float sums[6]{};
+			for (int sum{}; sum < 6; ++sum)
+			{
+				for (int lane{}; lane < Width; ++lane)
+				{
+					sums[sum] += lanes[sum][lane];
+				}
+			}
+
+			irradiance.r = sums[0];
+			irradiance.g = sums[1];
+			irradiance.b = sums[2];
+			specular.r = sums[3];
+			specular.g = sums[4];
+			specular.b = sums[5];
+		}
+
+		void ShadePbrBatch(const PbrMaterial& material, const PbrBatch& batch, float* pRed, float* pGreen, float* pBlue)
+		{
+			const WideFloat lightX = Set(material.lightDirection.x);
+			const WideFloat lightY = Set(material.lightDirection.y);
+			const WideFloat lightZ = Set(material.lightDirection.z);
+			const WideFloat zero = Set(0.f);
+			const WideFloat one = Set(1.f);
+			const WideFloat inversePi = Set(1.f / PI);
+			// IrradianceSH::coefficients, rgb and a padding float per coefficient
+			const float* pSky = &material.skyIrradiance.coefficients[0].x;
+
+			for (int index{}; index < batch.count; index += Width)
+			{
+				const WideFloat normalX = Load(batch.normalX + index);
+				const WideFloat normalY = Load(batch.normalY + index);
+				const WideFloat normalZ = Load(batch.normalZ + index);
+
+				// Towards the camera
+				const WideFloat viewX = zero - Load(batch.viewX + index);
+				const WideFloat viewY = zero - Load(batch.viewY + index);
+				const WideFloat viewZ = zero - Load(batch.viewZ + index);
+
+				const WideFloat halfX = lightX + viewX;
+				const WideFloat halfY = lightY + viewY;
+				const WideFloat halfZ = lightZ + viewZ;
+				const WideFloat halfLengthSquared = Max(halfX * halfX + halfY * halfY + halfZ * halfZ, Set(1e-8f));
+				const WideFloat inverseHalfLength = material.isFastMath ? Rsqrt(halfLengthSquared) : one / Sqrt(halfLengthSquared);
+
+				const WideFloat normalDotLight = Max(normalX * lightX + normalY * lightY + normalZ * lightZ, zero);
+				const WideFloat normalDotView = Max(normalX * viewX + normalY * viewY + normalZ * viewZ, Set(1e-4f));
+				const WideFloat normalDotHalf = Max((normalX * halfX + normalY * halfY + normalZ * halfZ) * inverseHalfLength, zero);
+				const WideFloat viewDotHalf = Max((viewX * halfX + viewY * halfY + viewZ * halfZ) * inverseHalfLength, zero);
+
+				const WideFloat roughness = Max(Load(batch.glossiness + index) * Set(material.roughnessScale) + Set(material.roughnessBias), Set(PbrMaterial::MinRoughness));
+				const WideFloat alpha = roughness * roughness;
+				const WideFloat alphaSquared = alpha * alpha;
+
+				// GGX distribution
+				const WideFloat distributionBase = normalDotHalf * normalDotHalf * (alphaSquared - one) + one;
+				const WideFloat distributionDenominator = Set(PI) * distributionBase * distributionBase;
+
+				// Smith with the Schlick-GGX term per direction, k of the direct light. Folded with the 4 N.L N.V of the BRDF
+				const WideFloat k = (roughness + one) * (roughness + one) * Set(0.125f);
+				const WideFloat geometryDenominator = Set(4.f) * (normalDotLight * (one - k) + k) * (normalDotView * (one - k) + k);
+
+				const WideFloat specularDenominator = distributionDenominator * geometryDenominator;
+				const WideFloat specularScale = alphaSquared * (material.isFastMath ? Reciprocal(specularDenominator) : one / specularDenominator);
+
+				// Schlick Fresnel, (1 - v.h)^5 in multiplications
+				const WideFloat fresnelBase = one - viewDotHalf;
+				const WideFloat fresnelBaseSquared = fresnelBase * fresnelBase;
+				const WideFloat fresnelWeight = fresnelBaseSquared * fresnelBaseSquared * fresnelBase;
+
+				const WideFloat directScale = normalDotLight * Load(batch.visibility + index);
+				const WideFloat ambientOcclusion = Load(batch.ambientOcclusion + index);
+
+				// Irradiance of the sky, IrradianceSH::Evaluate per lane
+				const WideFloat skyTerms[IrradianceSH::CoefficientCount]{ one, normalY, normalZ, normalX, normalX * normalY, normalY * normalZ,
+					Set(3.f) * normalZ * normalZ - one, normalX * normalZ, normalX * normalX - normalY * normalY };
+
+				const float* pAlbedo[3]{ batch.albedoR + index, batch.albedoG + index, batch.albedoB + index };
+				const float* pSpecular[3]{ batch.specularR + index, batch.specularG + index, batch.specularB + index };
+				float* pOut[3]{ pRed + index, pGreen + index, pBlue + index };
+				const float radiance[3]{ material.lightRadiance.r, material.lightRadiance.g, material.lightRadiance.b };
+
+				for (int channel{}; channel < 3; ++channel)
+				{
+					WideFloat sky = Set(pSky[channel]);
+					for (int coefficient{ 1 }; coefficient < IrradianceSH::CoefficientCount; ++coefficient)
+					{
+						sky = sky + Set(pSky[4 * coefficient + channel]) * skyTerms[coefficient];
+					}
+
+					const WideFloat reflectance = Load(pSpecular[channel]);
+					const WideFloat fresnel = reflectance + (one - reflectance) * fresnelWeight;
+					const WideFloat diffuse = Load(pAlbedo[channel]) * inversePi;
+
+					// What the surface does not reflect specularly is left for the diffuse
+					const WideFloat direct = (diffuse * (one - fresnel) + fresnel * specularScale) * (directScale * Set(radiance[channel]));
+					Store(pOut[channel], direct + diffuse * (Max(sky, zero) * ambientOcclusion));
+				}
+			}
+		}
+
+		void TraceRays(const BvhNode* pNodes, const BvhTriangle* pTriangles, RayPacket& packet, bool isOcclusion)
+		{
+			const WideFloat zero = Set(0.f);
+			const WideFloat one = Set(1.f);
+			const WideFloat missed = Set(-1.f);
+
+			for (int first{}; first < packet.count; first += Width)
+			{
+				const WideFloat originX = Load(packet.originX + first);
+				const WideFloat originY = Load(packet.originY + first);
+				const WideFloat originZ = Load(packet.originZ + first);
+				const WideFloat directionX = Load(packet.directionX + first);
+				const WideFloat directionY = Load(packet.directionY + first);
+				const WideFloat directionZ = Load(packet.directionZ + first);
+
+				// Division by 0 gives the infinite slab of a ray parallel to the axis
+				const WideFloat inverseX = one / directionX;
+				const WideFloat inverseY = one / directionY;
+				const WideFloat inverseZ = one / directionZ;
+
+				// A negative distance fails every test, the lanes past the end start out with one and occluded lanes get one
+				const WideMask isValid = ToFloat(IotaInt()) + Set(static_cast<float>(first)) < Set(static_cast<float>(packet.count));
+				WideFloat distance = Select(isValid, Load(packet.distance + first), missed);
+				WideFloat primitive = missed;
+				WideFloat hitU = zero;
+				WideFloat hitV = zero;
+
+				// The first ray decides the order of the children for all of them
+				const bool isNegative[3]{ packet.directionX[first] < 0.f, packet.directionY[first] < 0.f, packet.directionZ[first] < 0.f };
+
+				int stack[Bvh::MaxDepth];
+				int stackSize{};
+				stack[stackSize++] = 0;
+
+				while (stackSize > 0)
+				{
+					const BvhNode& node = pNodes[stack[--stackSize]];
+
+					// Slab test, the box has to be entered before it is left and before the closest hit so far
+					const WideFloat nearX = (Set(node.boundsMin[0]) - originX) * inverseX;
+					const WideFloat farX = (Set(node.boundsMax[0]) - originX) * inverseX;
+					const WideFloat nearY = (Set(node.boundsMin[1]) - originY) * inverseY;
+					const WideFloat farY = (Set(node.boundsMax[1]) - originY) * inverseY;
+					const WideFloat nearZ = (Set(node.boundsMin[2]) - originZ) * inverseZ;
+					const WideFloat farZ = (Set(node.boundsMax[2]) - originZ) * inverseZ;
+
+					const WideFloat entry = Max(Max(Min(nearX, farX), Min(nearY, farY)), Max(Min(nearZ, farZ), zero));
+					const WideFloat exit = Min(Min(Max(nearX, farX), Max(nearY, farY)), Min(Max(nearZ, farZ), distance));
+
+					if (MaskBits(entry <= exit) == 0)
+					{
+						continue;
+					}
+
+					if (node.count == 0)
+					{
+						// Far child first on the stack, so the near one gets popped first and shortens the rays early
+						const int nearChild = node.leftFirst + (isNegative[node.axis] ? 1 : 0);
+						stack[stackSize++] = 2 * node.leftFirst + 1 - nearChild;
+						stack[stackSize++] = nearChild;
+						continue;
+					}
+
+					for (int index{ node.leftFirst }; index < node.leftFirst + node.count; ++index)
+					{
+						const BvhTriangle& triangle = pTriangles[index];
+						const WideFloat edge1X = Set(triangle.edge1.x);
+						const WideFloat edge1Y = Set(triangle.edge1.y);
+						const WideFloat edge1Z = Set(triangle.edge1.z);
+						const WideFloat edge2X = Set(triangle.edge2.x);
+						const WideFloat edge2Y = Set(triangle.edge2.y);
+						const WideFloat edge2Z = Set(triangle.edge2.z);
+
+						// Moller-Trumbore, both sides of the triangle count
+						const WideFloat pX = directionY * edge2Z - directionZ * edge2Y;
+						const WideFloat pY = directionZ * edge2X - directionX * edge2Z;
+						const WideFloat pZ = directionX * edge2Y - directionY * edge2X;
+						const WideFloat inverseDeterminant = one / (edge1X * pX + edge1Y * pY + edge1Z * pZ);
+
+						const WideFloat toOriginX = originX - Set(triangle.vertex0.x);
+						const WideFloat toOriginY = originY - Set(triangle.vertex0.y);
+						const WideFloat toOriginZ = originZ - Set(triangle.vertex0.z);
+						const WideFloat u = (toOriginX * pX + toOriginY * pY + toOriginZ * pZ) * inverseDeterminant;
+
+						const WideFloat qX = toOriginY * edge1Z - toOriginZ * edge1Y;
+						const WideFloat qY = toOriginZ * edge1X - toOriginX * edge1Z;
+						const WideFloat qZ = toOriginX * edge1Y - toOriginY * edge1X;
+						const WideFloat v = (directionX * qX + directionY * qY + directionZ * qZ) * inverseDeterminant;
+						const WideFloat t = (edge2X * qX + edge2Y * qY + edge2Z * qZ) * inverseDeterminant;
+
+						// A parallel ray divides by 0, the NaN fails all of the comparisons
+						const WideMask isHit = (zero <= u) & (zero <= v) & (u + v <= one) & (zero < t) & (t < distance);
+						if (MaskBits(isHit) == 0)
+						{
+							continue;
+						}
+
+						distance = Select(isHit, isOcclusion ? missed : t, distance);
+						primitive = Select(isHit, Set(static_cast<float>(triangle.primitive)), primitive);
+						hitU = Select(isHit, u, hitU);
+						hitV = Select(isHit, v, hitV);
+					}
+
+					if (isOcclusion && MaskBits(zero <= distance) == 0)
+					{
+						break;
+					}
+				}
+
+				// Occlusion rays keep their distance, theirs became -1 on the hit
+				if (!isOcclusion)
+				{
+					Store(packet.distance + first, distance);
+				}
+				StoreInt(packet.primitive + first, RoundToInt(primitive));
+				Store(packet.u + first, hitU);
+				Store(packet.v + first, hitV);
+			}
+		}
+
+		const SimdKernels Kernels{ &TransformToRaster, &TransformPoints, &TransformVectorsAndNormalize, &RasterDepthTile, &UpscaleRow, &FastMathRow, &ShadePointLights, &ShadePbrBatch, &TraceRays };
+	}
+}
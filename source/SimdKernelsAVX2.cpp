@@ -0,0 +1,21 @@
+// AVX2 kernels, the vcxproj builds this file with /arch:AVX2.
+// Built without the precompiled header, that one is compiled without these instruction set flags
+#include "SimdDispatch.h"
+
+#if defined(SIMD_ARCH_X86)
+#define SIMD_WIDE_AVX2
+#define SIMD_NAMESPACE Avx2
+#include "SimdWide.h"
+#include "SimdKernels.inl"
+
+const SimdKernels* GetAvx2Kernels()
+{
+	return &Avx2::Kernels;
+}
+
+#else
+const SimdKernels* GetAvx2Kernels()
+{
+	return nullptr;
+}
+#endif
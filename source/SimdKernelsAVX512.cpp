@@ -0,0 +1,21 @@
+// AVX-512F kernels, the vcxproj builds this file with /arch:AVX512.
+// Built without the precompiled header, that one is compiled without these instruction set flags
+#include "SimdDispatch.h"
+
+#if defined(SIMD_ARCH_X86)
+#define SIMD_WIDE_AVX512
+#define SIMD_NAMESPACE Avx512
+#include "SimdWide.h"
+#include "SimdKernels.inl"
+
+const SimdKernels* GetAvx512Kernels()
+{
+	return &Avx512::Kernels;
+}
+
+#else
+const SimdKernels* GetAvx512Kernels()
+{
+	return nullptr;
+}
+#endif
@@ -0,0 +1,21 @@
+// NEON kernels, only built for ARM64 targets.
+// Built without the precompiled header, like every SimdKernels file
+#include "SimdDispatch.h"
+
+#if defined(SIMD_ARCH_ARM64)
+#define SIMD_WIDE_NEON
+#define SIMD_NAMESPACE Neon
+#include "SimdWide.h"
+#include "SimdKernels.inl"
+
+const SimdKernels* GetNeonKernels()
+{
+	return &Neon::Kernels;
+}
+
+#else
+const SimdKernels* GetNeonKernels()
+{
+	return nullptr;
+}
+#endif
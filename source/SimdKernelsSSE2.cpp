@@ -0,0 +1,21 @@
+// SSE2 kernels, the x64 baseline.
+// Built without the precompiled header, like every SimdKernels file
+#include "SimdDispatch.h"
+
+#if defined(SIMD_ARCH_X86)
+#define SIMD_WIDE_SSE2
+#define SIMD_NAMESPACE Sse2
+#include "SimdWide.h"
+#include "SimdKernels.inl"
+
+const SimdKernels* GetSse2Kernels()
+{
+	return &Sse2::Kernels;
+}
+
+#else
+const SimdKernels* GetSse2Kernels()
+{
+	return nullptr;
+}
+#endif
@@ -0,0 +1,13 @@
+// Scalar reference kernels, plain C++ on every target.
+// Built without the precompiled header, like every SimdKernels file
+#include "SimdDispatch.h"
+
+#define SIMD_WIDE_SCALAR
+#define SIMD_NAMESPACE Scalar
+#include "SimdWide.h"
+#include "SimdKernels.inl"
+
+const SimdKernels* GetScalarKernels()
+{
+	return &Scalar::Kernels;
+}
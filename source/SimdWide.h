@@ -0,0 +1,412 @@
+// No include guard: every kernel translation unit includes this once, after defining
+// SIMD_NAMESPACE and one of SIMD_WIDE_SCALAR, SIMD_WIDE_SSE2, SIMD_WIDE_AVX2, SIMD_WIDE_AVX512 or SIMD_WIDE_NEON
+
+/**
+	* Wide float / int / mask types of one instruction set, plus the handful of
+	* operations the kernels in SimdKernels.inl need. Every instruction set lives
+	* in its own namespace, so the kernels can be written once and compiled per
+	* translation unit with different compiler flags without ODR clashes.
+	*/
+
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+#if defined(SIMD_WIDE_SSE2)
+#include <emmintrin.h>
+#elif defined(SIMD_WIDE_AVX2) || defined(SIMD_WIDE_AVX512)
+#include <immintrin.h>
+#elif defined(SIMD_WIDE_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace SIMD_NAMESPACE
+{
+	// Internal linkage, nothing compiled with the flags of one translation unit can be shared with another
+	namespace
+	{
+#if defined(SIMD_WIDE_SCALAR)
+		/************************************************************************/
+		/* Scalar reference, one lane											*/
+		/************************************************************************/
+		constexpr int Width{ 1 };
+
+		struct WideFloat { float v; };
+		struct WideInt { int32_t v; };
+		struct WideMask { bool v; };
+
+		inline WideFloat Set(float value) { return { value }; }
+		inline WideInt SetInt(int32_t value) { return { value }; }
+		inline WideInt IotaInt() { return { 0 }; }
+
+		inline WideFloat Load(const float* p) { return { *p }; }
+		inline WideInt LoadInt(const int32_t* p) { return { *p }; }
+		inline void Store(float* p, WideFloat a) { *p = a.v; }
+		inline void StoreInt(int32_t* p, WideInt a) { *p = a.v; }
+
+		inline WideFloat operator+(WideFloat a, WideFloat b) { return { a.v + b.v }; }
+		inline WideFloat operator-(WideFloat a, WideFloat b) { return { a.v - b.v }; }
+		inline WideFloat operator*(WideFloat a, WideFloat b) { return { a.v * b.v }; }
+		inline WideFloat operator/(WideFloat a, WideFloat b) { return { a.v / b.v }; }
+		inline WideFloat Min(WideFloat a, WideFloat b) { return { a.v < b.v ? a.v : b.v }; }
+		inline WideFloat Max(WideFloat a, WideFloat b) { return { a.v > b.v ? a.v : b.v }; }
+		inline WideFloat Sqrt(WideFloat a) { return { sqrtf(a.v) }; }
+		inline WideFloat Abs(WideFloat a) { return { fabsf(a.v) }; }
+
+		inline WideMask operator<(WideFloat a, WideFloat b) { return { a.v < b.v }; }
+		inline WideMask operator<=(WideFloat a, WideFloat b) { return { a.v <= b.v }; }
+		inline WideMask operator>=(WideFloat a, WideFloat b) { return { a.v >= b.v }; }
+		inline WideMask operator&(WideMask a, WideMask b) { return { a.v && b.v }; }
+		inline WideMask operator|(WideMask a, WideMask b) { return { a.v || b.v }; }
+		inline int MaskBits(WideMask a) { return a.v ? 1 : 0; }
+		inline WideFloat Select(WideMask mask, WideFloat a, WideFloat b) { return { mask.v ? a.v : b.v }; }
+
+		inline WideInt operator+(WideInt a, WideInt b) { return { a.v + b.v }; }
+		inline WideInt operator&(WideInt a, WideInt b) { return { a.v & b.v }; }
+		inline WideInt operator|(WideInt a, WideInt b) { return { a.v | b.v }; }
+		inline WideInt ShiftLeft(WideInt a, int count) { return { static_cast<int32_t>(static_cast<uint32_t>(a.v) << count) }; }
+		inline WideInt ShiftRight(WideInt a, int count) { return { static_cast<int32_t>(static_cast<uint32_t>(a.v) >> count) }; }
+		inline WideFloat ToFloat(WideInt a) { return { static_cast<float>(a.v) }; }
+		// Round to nearest even, like cvtps2dq
+		inline WideInt RoundToInt(WideFloat a) { return { static_cast<int32_t>(nearbyintf(a.v)) }; }
+		inline WideInt operator-(WideInt a, WideInt b) { return { a.v - b.v }; }
+		inline WideInt ShiftRightArithmetic(WideInt a, int count) { return { a.v >> count }; }
+		inline WideInt AsInt(WideFloat a) { return { std::bit_cast<int32_t>(a.v) }; }
+		inline WideFloat AsFloat(WideInt a) { return { std::bit_cast<float>(a.v) }; }
+		// The exact values stand in for the hardware estimates
+		inline WideFloat RsqrtEstimate(WideFloat a) { return { 1.f / sqrtf(a.v) }; }
+		inline WideFloat ReciprocalEstimate(WideFloat a) { return { 1.f / a.v }; }
+
+		inline WideInt Gather(const int32_t* pBase, WideInt indices) { return { pBase[indices.v] }; }
+		inline WideFloat Gather(const float* pBase, WideInt indices) { return { pBase[indices.v] }; }
+
+#elif defined(SIMD_WIDE_SSE2)
+		/************************************************************************/
+		/* SSE2, 4 lanes														*/
+		/************************************************************************/
+		constexpr int Width{ 4 };
+
+		struct WideFloat { __m128 v; };
+		struct WideInt { __m128i v; };
+		struct WideMask { __m128 v; };
+
+		inline WideFloat Set(float value) { return { _mm_set1_ps(value) }; }
+		inline WideInt SetInt(int32_t value) { return { _mm_set1_epi32(value) }; }
+		inline WideInt IotaInt() { return { _mm_setr_epi32(0, 1, 2, 3) }; }
+
+		inline WideFloat Load(const float* p) { return { _mm_loadu_ps(p) }; }
+		inline WideInt LoadInt(const int32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+		inline void Store(float* p, WideFloat a) { _mm_storeu_ps(p, a.v); }
+		inline void StoreInt(int32_t* p, WideInt a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+
+		inline WideFloat operator+(WideFloat a, WideFloat b) { return { _mm_add_ps(a.v, b.v) }; }
+		inline WideFloat operator-(WideFloat a, WideFloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+		inline WideFloat operator*(WideFloat a, WideFloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+		inline WideFloat operator/(WideFloat a, WideFloat b) { return { _mm_div_ps(a.v, b.v) }; }
+		inline WideFloat Min(WideFloat a, WideFloat b) { return { _mm_min_ps(a.v, b.v) }; }
+		inline WideFloat Max(WideFloat a, WideFloat b) { return { _mm_max_ps(a.v, b.v) }; }
+		inline WideFloat Sqrt(WideFloat a) { return { _mm_sqrt_ps(a.v) }; }
+		inline WideFloat Abs(WideFloat a) { return { _mm_andnot_ps(_mm_set1_ps(-0.f), a.v) }; }
+
+		inline WideMask operator<(WideFloat a, WideFloat b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+		inline WideMask operator<=(WideFloat a, WideFloat b) { return { _mm_cmple_ps(a.v, b.v) }; }
+		inline WideMask operator>=(WideFloat a, WideFloat b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+		inline WideMask operator&(WideMask a, WideMask b) { return { _mm_and_ps(a.v, b.v) }; }
+		inline WideMask operator|(WideMask a, WideMask b) { return { _mm_or_ps(a.v, b.v) }; }
+		inline int MaskBits(WideMask a) { return _mm_movemask_ps(a.v); }
+		inline WideFloat Select(WideMask mask, WideFloat a, WideFloat b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+
+		inline WideInt operator+(WideInt a, WideInt b) { return { _mm_add_epi32(a.v, b.v) }; }
+		inline WideInt operator&(WideInt a, WideInt b) { return { _mm_and_si128(a.v, b.v) }; }
+		inline WideInt operator|(WideInt a, WideInt b) { return { _mm_or_si128(a.v, b.v) }; }
+		inline WideInt ShiftLeft(WideInt a, int count) { return { _mm_sll_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideInt ShiftRight(WideInt a, int count) { return { _mm_srl_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideFloat ToFloat(WideInt a) { return { _mm_cvtepi32_ps(a.v) }; }
+		inline WideInt RoundToInt(WideFloat a) { return { _mm_cvtps_epi32(a.v) }; }
+		inline WideInt operator-(WideInt a, WideInt b) { return { _mm_sub_epi32(a.v, b.v) }; }
+		inline WideInt ShiftRightArithmetic(WideInt a, int count) { return { _mm_sra_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideInt AsInt(WideFloat a) { return { _mm_castps_si128(a.v) }; }
+		inline WideFloat AsFloat(WideInt a) { return { _mm_castsi128_ps(a.v) }; }
+		// 12 bit estimates
+		inline WideFloat RsqrtEstimate(WideFloat a) { return { _mm_rsqrt_ps(a.v) }; }
+		inline WideFloat ReciprocalEstimate(WideFloat a) { return { _mm_rcp_ps(a.v) }; }
+
+		// No gather instruction, the loads go through the stack
+		inline WideInt Gather(const int32_t* pBase, WideInt indices)
+		{
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), indices.v);
+			return { _mm_setr_epi32(pBase[lanes[0]], pBase[lanes[1]], pBase[lanes[2]], pBase[lanes[3]]) };
+		}
+
+		inline WideFloat Gather(const float* pBase, WideInt indices)
+		{
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), indices.v);
+			return { _mm_setr_ps(pBase[lanes[0]], pBase[lanes[1]], pBase[lanes[2]], pBase[lanes[3]]) };
+		}
+
+#elif defined(SIMD_WIDE_AVX2)
+		/************************************************************************/
+		/* AVX2, 8 lanes														*/
+		/************************************************************************/
+		constexpr int Width{ 8 };
+
+		struct WideFloat { __m256 v; };
+		struct WideInt { __m256i v; };
+		struct WideMask { __m256 v; };
+
+		inline WideFloat Set(float value) { return { _mm256_set1_ps(value) }; }
+		inline WideInt SetInt(int32_t value) { return { _mm256_set1_epi32(value) }; }
+		inline WideInt IotaInt() { return { _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) }; }
+
+		inline WideFloat Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+		inline WideInt LoadInt(const int32_t* p) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) }; }
+		inline void Store(float* p, WideFloat a) { _mm256_storeu_ps(p, a.v); }
+		inline void StoreInt(int32_t* p, WideInt a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a.v); }
+
+		inline WideFloat operator+(WideFloat a, WideFloat b) { return { _mm256_add_ps(a.v, b.v) }; }
+		inline WideFloat operator-(WideFloat a, WideFloat b) { return { _mm256_sub_ps(a.v, b.v) }; }
+		inline WideFloat operator*(WideFloat a, WideFloat b) { return { _mm256_mul_ps(a.v, b.v) }; }
+		inline WideFloat operator/(WideFloat a, WideFloat b) { return { _mm256_div_ps(a.v, b.v) }; }
+		inline WideFloat Min(WideFloat a, WideFloat b) { return { _mm256_min_ps(a.v, b.v) }; }
+		inline WideFloat Max(WideFloat a, WideFloat b) { return { _mm256_max_ps(a.v, b.v) }; }
+		inline WideFloat Sqrt(WideFloat a) { return { _mm256_sqrt_ps(a.v) }; }
+		inline WideFloat Abs(WideFloat a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v) }; }
+
+		inline WideMask operator<(WideFloat a, WideFloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+		inline WideMask operator<=(WideFloat a, WideFloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+		inline WideMask operator>=(WideFloat a, WideFloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+		inline WideMask operator&(WideMask a, WideMask b) { return { _mm256_and_ps(a.v, b.v) }; }
+		inline WideMask operator|(WideMask a, WideMask b) { return { _mm256_or_ps(a.v, b.v) }; }
+		inline int MaskBits(WideMask a) { return _mm256_movemask_ps(a.v); }
+		inline WideFloat Select(WideMask mask, WideFloat a, WideFloat b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+
+		inline WideInt operator+(WideInt a, WideInt b) { return { _mm256_add_epi32(a.v, b.v) }; }
+		inline WideInt operator&(WideInt a, WideInt b) { return { _mm256_and_si256(a.v, b.v) }; }
+		inline WideInt operator|(WideInt a, WideInt b) { return { _mm256_or_si256(a.v, b.v) }; }
+		inline WideInt ShiftLeft(WideInt a, int count) { return { _mm256_sll_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideInt ShiftRight(WideInt a, int count) { return { _mm256_srl_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideFloat ToFloat(WideInt a) { return { _mm256_cvtepi32_ps(a.v) }; }
+		inline WideInt RoundToInt(WideFloat a) { return { _mm256_cvtps_epi32(a.v) }; }
+		inline WideInt operator-(WideInt a, WideInt b) { return { _mm256_sub_epi32(a.v, b.v) }; }
+		inline WideInt ShiftRightArithmetic(WideInt a, int count) { return { _mm256_sra_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideInt AsInt(WideFloat a) { return { _mm256_castps_si256(a.v) }; }
+		inline WideFloat AsFloat(WideInt a) { return { _mm256_castsi256_ps(a.v) }; }
+		// 12 bit estimates
+		inline WideFloat RsqrtEstimate(WideFloat a) { return { _mm256_rsqrt_ps(a.v) }; }
+		inline WideFloat ReciprocalEstimate(WideFloat a) { return { _mm256_rcp_ps(a.v) }; }
+
+		inline WideInt Gather(const int32_t* pBase, WideInt indices) { return { _mm256_i32gather_epi32(reinterpret_cast<const int*>(pBase), indices.v, 4) }; }
+		inline WideFloat Gather(const float* pBase, WideInt indices) { return { _mm256_i32gather_ps(pBase, indices.v, 4) }; }
+
+#elif defined(SIMD_WIDE_AVX512)
+		/************************************************************************/
+		/* AVX-512F, 16 lanes with mask registers								*/
+		/************************************************************************/
+		constexpr int Width{ 16 };
+
+		struct WideFloat { __m512 v; };
+		struct WideInt { __m512i v; };
+		struct WideMask { __mmask16 v; };
+
+		inline WideFloat Set(float value) { return { _mm512_set1_ps(value) }; }
+		inline WideInt SetInt(int32_t value) { return { _mm512_set1_epi32(value) }; }
+		inline WideInt IotaInt() { return { _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15) }; }
+
+		inline WideFloat Load(const float* p) { return { _mm512_loadu_ps(p) }; }
+		inline WideInt LoadInt(const int32_t* p) { return { _mm512_loadu_si512(p) }; }
+		inline void Store(float* p, WideFloat a) { _mm512_storeu_ps(p, a.v); }
+		inline void StoreInt(int32_t* p, WideInt a) { _mm512_storeu_si512(p, a.v); }
+
+		inline WideFloat operator+(WideFloat a, WideFloat b) { return { _mm512_add_ps(a.v, b.v) }; }
+		inline WideFloat operator-(WideFloat a, WideFloat b) { return { _mm512_sub_ps(a.v, b.v) }; }
+		inline WideFloat operator*(WideFloat a, WideFloat b) { return { _mm512_mul_ps(a.v, b.v) }; }
+		inline WideFloat operator/(WideFloat a, WideFloat b) { return { _mm512_div_ps(a.v, b.v) }; }
+		inline WideFloat Min(WideFloat a, WideFloat b) { return { _mm512_min_ps(a.v, b.v) }; }
+		inline WideFloat Max(WideFloat a, WideFloat b) { return { _mm512_max_ps(a.v, b.v) }; }
+		inline WideFloat Sqrt(WideFloat a) { return { _mm512_sqrt_ps(a.v) }; }
+		inline WideFloat Abs(WideFloat a) { return { _mm512_castsi512_ps(_mm512_and_epi32(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x7FFFFFFF))) }; }
+
+		inline WideMask operator<(WideFloat a, WideFloat b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ) }; }
+		inline WideMask operator<=(WideFloat a, WideFloat b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ) }; }
+		inline WideMask operator>=(WideFloat a, WideFloat b) { return { _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ) }; }
+		inline WideMask operator&(WideMask a, WideMask b) { return { static_cast<__mmask16>(a.v & b.v) }; }
+		inline WideMask operator|(WideMask a, WideMask b) { return { static_cast<__mmask16>(a.v | b.v) }; }
+		inline int MaskBits(WideMask a) { return static_cast<int>(a.v); }
+		inline WideFloat Select(WideMask mask, WideFloat a, WideFloat b) { return { _mm512_mask_blend_ps(mask.v, b.v, a.v) }; }
+
+		inline WideInt operator+(WideInt a, WideInt b) { return { _mm512_add_epi32(a.v, b.v) }; }
+		inline WideInt operator&(WideInt a, WideInt b) { return { _mm512_and_epi32(a.v, b.v) }; }
+		inline WideInt operator|(WideInt a, WideInt b) { return { _mm512_or_epi32(a.v, b.v) }; }
+		inline WideInt ShiftLeft(WideInt a, int count) { return { _mm512_sll_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideInt ShiftRight(WideInt a, int count) { return { _mm512_srl_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideFloat ToFloat(WideInt a) { return { _mm512_cvtepi32_ps(a.v) }; }
+		inline WideInt RoundToInt(WideFloat a) { return { _mm512_cvtps_epi32(a.v) }; }
+		inline WideInt operator-(WideInt a, WideInt b) { return { _mm512_sub_epi32(a.v, b.v) }; }
+		inline WideInt ShiftRightArithmetic(WideInt a, int count) { return { _mm512_sra_epi32(a.v, _mm_cvtsi32_si128(count)) }; }
+		inline WideInt AsInt(WideFloat a) { return { _mm512_castps_si512(a.v) }; }
+		inline WideFloat AsFloat(WideInt a) { return { _mm512_castsi512_ps(a.v) }; }
+		// 14 bit estimates
+		inline WideFloat RsqrtEstimate(WideFloat a) { return { _mm512_rsqrt14_ps(a.v) }; }
+		inline WideFloat ReciprocalEstimate(WideFloat a) { return { _mm512_rcp14_ps(a.v) }; }
+
+		inline WideInt Gather(const int32_t* pBase, WideInt indices) { return { _mm512_i32gather_epi32(indices.v, pBase, 4) }; }
+		inline WideFloat Gather(const float* pBase, WideInt indices) { return { _mm512_i32gather_ps(indices.v, pBase, 4) }; }
+
+#elif defined(SIMD_WIDE_NEON)
+		/************************************************************************/
+		/* NEON (AArch64), 4 lanes												*/
+		/************************************************************************/
+		constexpr int Width{ 4 };
+
+		struct WideFloat { float32x4_t v; };
+		struct WideInt { int32x4_t v; };
+		struct WideMask { uint32x4_t v; };
+
+		inline WideFloat Set(float value) { return { vdupq_n_f32(value) }; }
+		inline WideInt SetInt(int32_t value) { return { vdupq_n_s32(value) }; }
+		inline WideInt IotaInt()
+		{
+			alignas(16) static const int32_t iota[4]{ 0, 1, 2, 3 };
+			return { vld1q_s32(iota) };
+		}
+
+		inline WideFloat Load(const float* p) { return { vld1q_f32(p) }; }
+		inline WideInt LoadInt(const int32_t* p) { return { vld1q_s32(p) }; }
+		inline void Store(float* p, WideFloat a) { vst1q_f32(p, a.v); }
+		inline void StoreInt(int32_t* p, WideInt a) { vst1q_s32(p, a.v); }
+
+		inline WideFloat operator+(WideFloat a, WideFloat b) { return { vaddq_f32(a.v, b.v) }; }
+		inline WideFloat operator-(WideFloat a, WideFloat b) { return { vsubq_f32(a.v, b.v) }; }
+		inline WideFloat operator*(WideFloat a, WideFloat b) { return { vmulq_f32(a.v, b.v) }; }
+		inline WideFloat operator/(WideFloat a, WideFloat b) { return { vdivq_f32(a.v, b.v) }; }
+		inline WideFloat Min(WideFloat a, WideFloat b) { return { vminq_f32(a.v, b.v) }; }
+		inline WideFloat Max(WideFloat a, WideFloat b) { return { vmaxq_f32(a.v, b.v) }; }
+		inline WideFloat Sqrt(WideFloat a) { return { vsqrtq_f32(a.v) }; }
+		inline WideFloat Abs(WideFloat a) { return { vabsq_f32(a.v) }; }
+
+		inline WideMask operator<(WideFloat a, WideFloat b) { return { vcltq_f32(a.v, b.v) }; }
+		inline WideMask operator<=(WideFloat a, WideFloat b) { return { vcleq_f32(a.v, b.v) }; }
+		inline WideMask operator>=(WideFloat a, WideFloat b) { return { vcgeq_f32(a.v, b.v) }; }
+		inline WideMask operator&(WideMask a, WideMask b) { return { vandq_u32(a.v, b.v) }; }
+		inline WideMask operator|(WideMask a, WideMask b) { return { vorrq_u32(a.v, b.v) }; }
+		inline int MaskBits(WideMask a)
+		{
+			alignas(16) static const uint32_t laneBits[4]{ 1, 2, 4, 8 };
+			return static_cast<int>(vaddvq_u32(vandq_u32(a.v, vld1q_u32(laneBits))));
+		}
+		inline WideFloat Select(WideMask mask, WideFloat a, WideFloat b) { return { vbslq_f32(mask.v, a.v, b.v) }; }
+
+		inline WideInt operator+(WideInt a, WideInt b) { return { vaddq_s32(a.v, b.v) }; }
+		inline WideInt operator&(WideInt a, WideInt b) { return { vandq_s32(a.v, b.v) }; }
+		inline WideInt operator|(WideInt a, WideInt b) { return { vorrq_s32(a.v, b.v) }; }
+		inline WideInt ShiftLeft(WideInt a, int count) { return { vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a.v), vdupq_n_s32(count))) }; }
+		inline WideInt ShiftRight(WideInt a, int count) { return { vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a.v), vdupq_n_s32(-count))) }; }
+		inline WideFloat ToFloat(WideInt a) { return { vcvtq_f32_s32(a.v) }; }
+		inline WideInt RoundToInt(WideFloat a) { return { vcvtnq_s32_f32(a.v) }; }
+		inline WideInt operator-(WideInt a, WideInt b) { return { vsubq_s32(a.v, b.v) }; }
+		inline WideInt ShiftRightArithmetic(WideInt a, int count) { return { vshlq_s32(a.v, vdupq_n_s32(-count)) }; }
+		inline WideInt AsInt(WideFloat a) { return { vreinterpretq_s32_f32(a.v) }; }
+		inline WideFloat AsFloat(WideInt a) { return { vreinterpretq_f32_s32(a.v) }; }
+		// The NEON estimates only have 8 bits, one step of the built in Newton-Raphson brings them to the 12 bits of SSE
+		inline WideFloat RsqrtEstimate(WideFloat a)
+		{
+			const float32x4_t y = vrsqrteq_f32(a.v);
+			return { vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a.v, y), y)) };
+		}
+		inline WideFloat ReciprocalEstimate(WideFloat a)
+		{
+			const float32x4_t y = vrecpeq_f32(a.v);
+			return { vmulq_f32(y, vrecpsq_f32(a.v, y)) };
+		}
+
+		inline WideInt Gather(const int32_t* pBase, WideInt indices)
+		{
+			alignas(16) int32_t lanes[4];
+			vst1q_s32(lanes, indices.v);
+			const int32_t values[4]{ pBase[lanes[0]], pBase[lanes[1]], pBase[lanes[2]], pBase[lanes[3]] };
+			return { vld1q_s32(values) };
+		}
+
+		inline WideFloat Gather(const float* pBase, WideInt indices)
+		{
+			alignas(16) int32_t lanes[4];
+			vst1q_s32(lanes, indices.v);
+			const float values[4]{ pBase[lanes[0]], pBase[lanes[1]], pBase[lanes[2]], pBase[lanes[3]] };
+			return { vld1q_f32(values) };
+		}
+
+#else
+#error "SimdWide.h needs one of SIMD_WIDE_SCALAR, SIMD_WIDE_SSE2, SIMD_WIDE_AVX2, SIMD_WIDE_AVX512 or SIMD_WIDE_NEON"
+#endif
+
+		/************************************************************************/
+		/* Shared helpers														*/
+		/************************************************************************/
+		inline WideFloat Saturate(WideFloat a, float maximum = 1.f)
+		{
+			return Min(Max(a, Set(0.f)), Set(maximum));
+		}
+
+		inline WideFloat Lerp(WideFloat a, WideFloat b, WideFloat t)
+		{
+			return a + (b - a) * t;
+		}
+
+		/************************************************************************/
+		/* Fast math, the wide forms of FastMath.h								*/
+		/************************************************************************/
+		// Same algorithms and coefficients as the scalar forms, SimdDispatch::Validate checks them against the error budgets documented there
+		inline WideFloat Rsqrt(WideFloat x)
+		{
+			const WideFloat y = RsqrtEstimate(x);
+			return y * (Set(1.5f) - Set(0.5f) * x * y * y);
+		}
+
+		inline WideFloat Reciprocal(WideFloat x)
+		{
+			const WideFloat y = ReciprocalEstimate(x);
+			return y * (Set(2.f) - x * y);
+		}
+
+		inline WideFloat Exp2(WideFloat x)
+		{
+			x = Min(Max(x, Set(-126.f)), Set(127.f));
+			const WideInt n = RoundToInt(x);
+			const WideFloat f = x - ToFloat(n);
+
+			WideFloat p = Set(0.00133908634f);
+			p = p * f + Set(0.00967603192f);
+			p = p * f + Set(0.0555035711f);
+			p = p * f + Set(0.240221075f);
+			p = p * f + Set(0.693147188f);
+			p = p * f + Set(1.00000008f);
+			return p * AsFloat(ShiftLeft(n + SetInt(127), 23));
+		}
+
+		inline WideFloat Log2(WideFloat x)
+		{
+			const WideInt bits = AsInt(x);
+			const WideInt e = ShiftRightArithmetic(bits - SetInt(0x3F3504F3), 23);
+			const WideFloat t = AsFloat(bits - ShiftLeft(e, 23)) - Set(1.f);
+
+			WideFloat q = Set(-0.142759734f);
+			q = q * t + Set(0.232652579f);
+			q = q * t + Set(-0.249271822f);
+			q = q * t + Set(0.287288882f);
+			q = q * t + Set(-0.360225182f);
+			q = q * t + Set(0.480916708f);
+			q = q * t + Set(-0.721352931f);
+			q = q * t + Set(1.44269499f);
+			return ToFloat(e) + t * q;
+		}
+
+		inline WideFloat Pow(WideFloat x, WideFloat y)
+		{
+			return Select(x <= Set(0.f), Set(0.f), Exp2(y * Log2(x)));
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "SpatialUpscaler.h"
+#include "JobSystem.h"
+#include "SimdDispatch.h"
+
+void SpatialUpscaler::Upscale(const SDL_Surface* pSource, SDL_Surface* pDestination)
+{
+	if (pSource->w != m_SourceWidth || pDestination->w != m_DestinationWidth)
+	{
+		BuildColumnTables(pSource->w, pDestination->w);
+	}
+
+	// Present is on the critical path of the frame
+	JOB_SYSTEM->ParallelFor(0, pDestination->h, [=, this](int y)
+		{
+			UpscaleRow(pSource, pDestination, y);
+		}, JobSystem::PRIORITY::HIGH
+	);
+}
+
+void SpatialUpscaler::BuildColumnTables(int sourceWidth, int destinationWidth)
+{
+	m_SourceWidth = sourceWidth;
+	m_DestinationWidth = destinationWidth;
+
+	// The row kernel reads whole vectors
+	const int paddedWidth = (destinationWidth + SimdDispatch::MaxWidth - 1) / SimdDispatch::MaxWidth * SimdDispatch::MaxWidth;
+	m_Column0.resize(paddedWidth);
+	m_Column1.resize(paddedWidth);
+	m_ColumnFraction.resize(paddedWidth);
+
+	const float scale = static_cast<float>(sourceWidth) / static_cast<float>(destinationWidth);
+
+	for (int x{}; x < paddedWidth; ++x)
+	{
+		// Pixel centers line up, padding columns just repeat the last one
+		const float sourceX = std::max((std::min(x, destinationWidth - 1) + 0.5f) * scale - 0.5f, 0.f);
+		const int column = std::min(static_cast<int>(sourceX), sourceWidth - 1);
+
+		m_Column0[x] = column;
+		m_Column1[x] = std::min(column + 1, sourceWidth - 1);
+		m_ColumnFraction[x] = sourceX - column;
+	}
+}
+
+void SpatialUpscaler::UpscaleRow(const SDL_Surface* pSource, SDL_Surface* pDestination, int y) const
+{
+	const float scale = static_cast<float>(pSource->h) / static_cast<float>(pDestination->h);
+	const float sourceY = std::max((y + 0.5f) * scale - 0.5f, 0.f);
+	const int row = std::min(static_cast<int>(sourceY), pSource->h - 1);
+
+	UpscaleRowArgs args{};
+	args.pRow0 = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(pSource->pixels) + row * pSource->pitch);
+	args.pRow1 = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(pSource->pixels) + std::min(row + 1, pSource->h - 1) * pSource->pitch);
+	args.pOut = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pDestination->pixels) + y * pDestination->pitch);
+	args.width = pDestination->w;
+	args.pColumn0 = m_Column0.data();
+	args.pColumn1 = m_Column1.data();
+	args.pColumnFraction = m_ColumnFraction.data();
+	args.rowFraction = sourceY - row;
+	args.sharpness = m_Sharpness;
+	args.sourceShifts[0] = pSource->format->Rshift;
+	args.sourceShifts[1] = pSource->format->Gshift;
+	args.sourceShifts[2] = pSource->format->Bshift;
+	args.destinationShifts[0] = pDestination->format->Rshift;
+	args.destinationShifts[1] = pDestination->format->Gshift;
+	args.destinationShifts[2] = pDestination->format->Bshift;
+
+	SIMD_KERNELS.UpscaleRow(args);
+}
@@ -0,0 +1,98 @@
+#include "pch.h"
+#include "SphericalHarmonics.h"
+
+namespace
+{
+	// Normalization of the real basis functions, in the order of IrradianceSH::Evaluate
+	constexpr float BasisConstants[IrradianceSH::CoefficientCount]
+	{
+		0.282095f,
+		0.488603f, 0.488603f, 0.488603f,
+		1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f
+	};
+
+	// Clamped cosine convolution of the band of every coefficient
+	constexpr float CosineConvolution[IrradianceSH::CoefficientCount]
+	{
+		PI,
+		2.f * PI / 3.f, 2.f * PI / 3.f, 2.f * PI / 3.f,
+		PI / 4.f, PI / 4.f, PI / 4.f, PI / 4.f, PI / 4.f
+	};
+
+	// The order of IrradianceSH::Evaluate, without the basis constants
+	void EvaluatePolynomials(const Vector3& n, float* pTerms)
+	{
+		pTerms[0] = 1.f;
+		pTerms[1] = n.y;
+		pTerms[2] = n.z;
+		pTerms[3] = n.x;
+		pTerms[4] = n.x * n.y;
+		pTerms[5] = n.y * n.z;
+		pTerms[6] = 3.f * n.z * n.z - 1.f;
+		pTerms[7] = n.x * n.z;
+		pTerms[8] = n.x * n.x - n.y * n.y;
+	}
+}
+
+IrradianceSH SphericalHarmonics::ProjectIrradiance(const std::function<ColorRGB(const Vector3&)>& radiance, int resolution)
+{
+	// Accumulated in double, the 8k samples of the default resolution would lose the small bands in float
+	double sums[IrradianceSH::CoefficientCount][3]{};
+
+	const int resolutionPhi = 2 * resolution;
+	const double cellArea = (PI / resolution) * (2.0 * PI / resolutionPhi);
+
+	for (int thetaIndex{}; thetaIndex < resolution; ++thetaIndex)
+	{
+		// Polar angle from +y, every cell covers sin(theta) of the solid angle
+		const float theta = (thetaIndex + 0.5f) * PI / resolution;
+		const double weight = sinf(theta) * cellArea;
+
+		for (int phiIndex{}; phiIndex < resolutionPhi; ++phiIndex)
+		{
+			const float phi = (phiIndex + 0.5f) * 2.f * PI / resolutionPhi;
+			const Vector3 direction{ sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) };
+			const ColorRGB color = radiance(direction);
+
+			float terms[IrradianceSH::CoefficientCount];
+			EvaluatePolynomials(direction, terms);
+
+			for (int coefficient{}; coefficient < IrradianceSH::CoefficientCount; ++coefficient)
+			{
+				const double basis = weight * terms[coefficient];
+				sums[coefficient][0] += color.r * basis;
+				sums[coefficient][1] += color.g * basis;
+				sums[coefficient][2] += color.b * basis;
+			}
+		}
+	}
+
+	// The projection needs the basis constant once and the evaluation once more, both end up in the coefficient
+	IrradianceSH irradiance{};
+	for (int coefficient{}; coefficient < IrradianceSH::CoefficientCount; ++coefficient)
+	{
+		const double scale = static_cast<double>(CosineConvolution[coefficient]) * BasisConstants[coefficient] * BasisConstants[coefficient];
+
+		irradiance.coefficients[coefficient] = Vector4{ static_cast<float>(sums[coefficient][0] * scale),
+			static_cast<float>(sums[coefficient][1] * scale), static_cast<float>(sums[coefficient][2] * scale), 0.f };
+	}
+
+	return irradiance;
+}
+
+ColorRGB SphericalHarmonics::SkyRadiance(const Vector3& direction)
+{
+	const ColorRGB zenith{ .05f, .07f, .12f };
+	const ColorRGB horizon{ .08f, .08f, .08f };
+	const ColorRGB ground{ .03f, .027f, .024f };
+
+	if (direction.y >= 0.f)
+	{
+		const float t = sqrtf(direction.y);
+		return horizon * (1.f - t) + zenith * t;
+	}
+
+	// The ground takes over quickly below the horizon
+	const float t = std::min(-4.f * direction.y, 1.f);
+	return horizon * (1.f - t) + ground * t;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <functional>
+#include "Math.h"
+#include "ColorRGB.h"
+
+/**
+	* Irradiance of a distant environment as 9 order-2 spherical harmonics
+	* coefficients (Ramamoorthi and Hanrahan). The environment gets projected once at
+	* load, already convolved with the clamped cosine and with the basis constants
+	* folded in, so the irradiance for a normal is a polynomial of 9 terms.
+	* One Vector4 (rgb, w unused) per coefficient, the layout of a std140 vec4 array,
+	* so the Vulkan uniform buffer takes them as is. shader.frag evaluates the same
+	* polynomial in EvaluateIrradiance.
+	*/
+struct IrradianceSH
+{
+	static constexpr int CoefficientCount{ 9 };
+
+	Vector4 coefficients[CoefficientCount]{};
+
+	// Irradiance reaching a surface with this (normalized) normal, Shading::Lambert turns it into outgoing light
+	ColorRGB Evaluate(const Vector3& n) const
+	{
+		// Vector4 runs the color channels in one SSE register
+		const Vector4 irradiance = coefficients[0]
+			+ coefficients[1] * n.y + coefficients[2] * n.z + coefficients[3] * n.x
+			+ coefficients[4] * (n.x * n.y) + coefficients[5] * (n.y * n.z) + coefficients[6] * (3.f * n.z * n.z - 1.f)
+			+ coefficients[7] * (n.x * n.z) + coefficients[8] * (n.x * n.x - n.y * n.y);
+
+		return { irradiance.x, irradiance.y, irradiance.z };
+	}
+};
+
+namespace SphericalHarmonics
+{
+	// Integrates the radiance over resolution x 2 * resolution directions
+	IrradianceSH ProjectIrradiance(const std::function<ColorRGB(const Vector3&)>& radiance, int resolution = 64);
+
+	// Analytic sky of the scene: a blue zenith fading to a neutral horizon and a darker ground, y is up.
+	// Stands in for the old constant ambient, the directional light stays separate
+	ColorRGB SkyRadiance(const Vector3& direction);
+}
@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "StageProfiler.h"
+#include "SDL.h"
+#include "RenderConfig.h"
+#include <cstring>
+
+StageProfiler::ScopedStage::ScopedStage(StageProfiler& profiler, const char* stageName)
+	: m_Profiler{ profiler }, m_StageName{ stageName }, m_StartCounter{ SDL_GetPerformanceCounter() }
+{
+}
+
+StageProfiler::ScopedStage::~ScopedStage()
+{
+	const uint64_t endCounter = SDL_GetPerformanceCounter();
+	m_Profiler.AddSample(m_StageName, (endCounter - m_StartCounter) * m_Profiler.m_MillisecondsPerCount);
+}
+
+StageProfiler::StageProfiler(const char* ownerName)
+	: m_OwnerName{ ownerName }
+{
+	m_MillisecondsPerCount = 1000.f / static_cast<float>(SDL_GetPerformanceFrequency());
+}
+
+void StageProfiler::AddSample(const char* stageName, float milliseconds)
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	Stage& stage = GetStage(stageName);
+	stage.totalMilliseconds += milliseconds;
+	++stage.sampleCount;
+}
+
+bool StageProfiler::Update(float elapsedSeconds)
+{
+	m_PrintTimer += elapsedSeconds;
+	if (m_PrintTimer < 1.f)
+	{
+		return false;
+	}
+
+	m_PrintTimer = 0.f;
+
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	for (Stage& stage : m_Stages)
+	{
+		stage.lastAverage = stage.sampleCount > 0 ? static_cast<float>(stage.totalMilliseconds / stage.sampleCount) : 0.f;
+		stage.totalMilliseconds = 0.0;
+		stage.sampleCount = 0;
+	}
+
+	if (!RENDER_CONFIG->ShouldPrintFPS())
+	{
+		return true;
+	}
+
+	std::cout << "\033[36m"; // TEXT COLOR
+	for (const Stage& stage : m_Stages)
+	{
+		std::cout << "[" << m_OwnerName << "] " << stage.name << ": " << stage.lastAverage << " ms" << std::endl;
+	}
+	std::cout << "\033[37m"; // TEXT COLOR WHITE
+
+	return true;
+}
+
+float StageProfiler::GetAverage(const char* stageName) const
+{
+	std::lock_guard<std::mutex> lock{ m_Mutex };
+
+	for (const Stage& stage : m_Stages)
+	{
+		if (std::strcmp(stage.name, stageName) == 0)
+		{
+			return stage.lastAverage;
+		}
+	}
+
+	return 0.f;
+}
+
+StageProfiler::Stage& StageProfiler::GetStage(const char* stageName)
+{
+	for (Stage& stage : m_Stages)
+	{
+		if (std::strcmp(stage.name, stageName) == 0)
+		{
+			return stage;
+		}
+	}
+
+	m_Stages.push_back(Stage{ stageName });
+	return m_Stages.back();
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <mutex>
+
+/**
+	* Accumulates the time spent in named frame stages and prints the
+	* per-stage averages once per second while FPS printing is enabled.
+	* Stage names are expected to be string literals. Samples can come in
+	* from several threads (the CPU renderer records and rasterizes in parallel).
+	*/
+class StageProfiler
+{
+public:
+	class ScopedStage
+	{
+	public:
+		ScopedStage(StageProfiler& profiler, const char* stageName);
+		~ScopedStage();
+
+		ScopedStage(const ScopedStage&) = delete;
+		ScopedStage(ScopedStage&&) noexcept = delete;
+		ScopedStage& operator=(const ScopedStage&) = delete;
+		ScopedStage& operator=(ScopedStage&&) noexcept = delete;
+
+	private:
+		StageProfiler& m_Profiler;
+		const char* m_StageName{};
+		uint64_t m_StartCounter{};
+	};
+
+	StageProfiler(const char* ownerName);
+
+	void AddSample(const char* stageName, float milliseconds);
+	// True once per second, when the averages got refreshed
+	bool Update(float elapsedSeconds);
+
+	float GetAverage(const char* stageName) const;
+
+private:
+	struct Stage
+	{
+		const char* name{};
+		double totalMilliseconds{};
+		uint32_t sampleCount{};
+		float lastAverage{};
+	};
+
+	const char* m_OwnerName{};
+	mutable std::mutex m_Mutex{};
+	std::vector<Stage> m_Stages{};
+	float m_PrintTimer{};
+	float m_MillisecondsPerCount{};
+
+	Stage& GetStage(const char* stageName);
+};
@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "TaskGraph.h"
+
+TaskGraph::TaskId TaskGraph::AddTask(std::function<void()> function, JobSystem::PRIORITY priority)
+{
+	Task& task = m_Tasks.emplace_back();
+	task.function = std::move(function);
+	task.priority = priority;
+
+	return static_cast<TaskId>(m_Tasks.size()) - 1;
+}
+
+void TaskGraph::AddDependency(TaskId task, TaskId dependency)
+{
+	m_Tasks[dependency].successors.push_back(task);
+	++m_Tasks[task].dependencyCount;
+}
+
+void TaskGraph::Clear()
+{
+	m_Tasks.clear();
+}
+
+void TaskGraph::Run()
+{
+	if (m_Tasks.empty())
+	{
+		return;
+	}
+
+	for (Task& task : m_Tasks)
+	{
+		task.remainingDependencies.store(task.dependencyCount, std::memory_order_relaxed);
+	}
+
+	// Every task decrements this once it ran, including the ones that are not queued yet
+	m_PendingCount.store(GetTaskCount(), std::memory_order_relaxed);
+
+	for (Task& task : m_Tasks)
+	{
+		if (task.dependencyCount == 0)
+		{
+			Schedule(task);
+		}
+	}
+
+	JOB_SYSTEM->Wait(m_PendingCount);
+}
+
+void TaskGraph::Schedule(Task& task)
+{
+	// Two pointers, fits the small buffer of std::function so queueing does not allocate
+	JOB_SYSTEM->Submit([this, &task]()
+		{
+			Execute(task);
+		}, m_PendingCount, task.priority
+	);
+}
+
+void TaskGraph::Execute(Task& task)
+{
+	task.function();
+
+	for (TaskId successor : task.successors)
+	{
+		Task& successorTask = m_Tasks[successor];
+
+		// The last finished dependency queues the task, acq_rel hands over everything its dependencies wrote
+		if (successorTask.remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Schedule(successorTask);
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "JobSystem.h"
+
+/**
+	* Dependency graph of jobs, built once and run any number of times.
+	* A task gets queued on the JobSystem the moment its last dependency
+	* finished, so independent parts of a frame overlap instead of meeting at
+	* full barriers. Running resets the dependency counters in place, so a
+	* built graph allocates nothing per run.
+	*/
+class TaskGraph
+{
+public:
+	using TaskId = int;
+
+	TaskGraph() = default;
+
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph(TaskGraph&&) noexcept = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+	TaskGraph& operator=(TaskGraph&&) noexcept = delete;
+
+	// The function can run on any thread of the JobSystem
+	TaskId AddTask(std::function<void()> function, JobSystem::PRIORITY priority = JobSystem::PRIORITY::NORMAL);
+
+	// task only starts once dependency finished
+	void AddDependency(TaskId task, TaskId dependency);
+
+	void Clear();
+
+	// Runs every task once and returns when all of them finished, the calling thread helps out meanwhile
+	void Run();
+
+	int GetTaskCount() const { return static_cast<int>(m_Tasks.size()); };
+	bool IsEmpty() const { return m_Tasks.empty(); };
+
+private:
+	struct Task
+	{
+		std::function<void()> function{};
+		JobSystem::PRIORITY priority{};
+		std::vector<TaskId> successors{};
+		int dependencyCount{};
+		std::atomic<int> remainingDependencies{};
+	};
+
+	// Tasks hold an atomic, the deque never moves them
+	std::deque<Task> m_Tasks{};
+	std::atomic<int> m_PendingCount{};
+
+	void Schedule(Task& task);
+	void Execute(Task& task);
+};
@@ -41,19 +41,33 @@ Texture* Texture::LoadFromFile(const std::string& path)
 	return new Texture(pTextureSurface);
 }
 
+Texture* Texture::CreateFromSurface(SDL_Surface* pSurface)
+{
+	return new Texture(pSurface);
+}
+
 ID3D11ShaderResourceView* Texture::GetSRV()
 {
 	return m_pResourceView;
 }
 
 ColorRGB Texture::Sample(const Vector2& uv) const
+{
+	// Opaque callers ignore the alpha
+	float alpha{};
+	return Sample(uv, alpha);
+}
+
+ColorRGB Texture::Sample(const Vector2& uv, float& alpha) const
 {
 	const int16_t pixelX = m_pSurface->w * uv.x;
 	const int16_t pixelY = m_pSurface->h * uv.y;
 	const int32_t pixelIndex = pixelY * m_pSurface->w + pixelX;
 
-	uint8_t r{}, g{}, b{};
-	SDL_GetRGB(m_pSurfacePixels[pixelIndex], m_pSurface->format, &r, &g, &b);
+	uint8_t r{}, g{}, b{}, a{};
+	SDL_GetRGBA(m_pSurfacePixels[pixelIndex], m_pSurface->format, &r, &g, &b, &a);
+
+	alpha = (float)a / 255.f;
 
 	return{
 		(float)r / 255.f,
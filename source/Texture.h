@@ -12,6 +12,8 @@ public:
 	~Texture();
 
 	static Texture* LoadFromFile(const std::string& path);
+	// Takes ownership of the surface, for textures generated at load time
+	static Texture* CreateFromSurface(SDL_Surface* pSurface);
 	SDL_Surface* GetSurface() { return m_pSurface; };
 
 	ID3D11ShaderResourceView* GetSRV();
@@ -20,6 +22,7 @@ public:
 	void SetResourceView(ID3D11ShaderResourceView* resourceView) { m_pResourceView = resourceView; };
 	
 	ColorRGB Sample(const Vector2& uv) const;
+	ColorRGB Sample(const Vector2& uv, float& alpha) const;
 
 private:
 	Texture() = default;
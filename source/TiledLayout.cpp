@@ -0,0 +1,47 @@
+#include "pch.h"
+#include "TiledLayout.h"
+#include "JobSystem.h"
+#include <emmintrin.h>
+
+TiledLayout::TiledLayout(int width, int height)
+	: m_Width{ width }, m_Height{ height }
+{
+	m_TilesX = (width + TileSize - 1) / TileSize;
+	m_TilesY = (height + TileSize - 1) / TileSize;
+}
+
+void TiledLayout::Linearize(const uint32_t* pTiled, SDL_Surface* pTarget) const
+{
+	// One row of tiles per task, that band of the tiled buffer stays in cache while its 8 rows get written
+	JOB_SYSTEM->ParallelFor(0, m_TilesY, [=, this](int tileY)
+		{
+			LinearizeRect(pTiled, pTarget, 0, tileY * TileSize, m_Width - 1, std::min((tileY + 1) * TileSize, m_Height) - 1);
+		}
+	);
+}
+
+void TiledLayout::LinearizeRect(const uint32_t* pTiled, SDL_Surface* pTarget, int minX, int minY, int maxX, int maxY) const
+{
+	const int fullTilesEnd = (maxX + 1) & ~(TileSize - 1);
+
+	for (int y{ minY }; y <= maxY; ++y)
+	{
+		uint32_t* pOut = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pTarget->pixels) + y * pTarget->pitch) + minX;
+		const uint32_t* pIn = pTiled + GetIndex(minX, y);
+
+		int x{ minX };
+		for (; x < fullTilesEnd; x += TileSize)
+		{
+			const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIn));
+			const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIn + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut), left);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + 4), right);
+
+			pIn += TilePixelCount;
+			pOut += TileSize;
+		}
+
+		// Partial tile at the right edge
+		std::copy(pIn, pIn + (maxX + 1 - x), pOut);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+
+struct SDL_Surface;
+
+/**
+	* Tile-major pixel order for the internal buffers of the software rasterizer.
+	* Every 8x8 tile is contiguous in memory (row-major inside the tile), so a
+	* compact screen area maps to a few cache lines and pages. The buffers are
+	* padded to whole tiles and get linearized into the SDL surface at present.
+	*/
+class TiledLayout
+{
+public:
+	static constexpr int TileShift{ 3 };
+	static constexpr int TileSize{ 1 << TileShift };
+	static constexpr int TilePixelCount{ TileSize * TileSize };
+
+	TiledLayout() = default;
+	TiledLayout(int width, int height);
+
+	int GetIndex(int x, int y) const
+	{
+		const int tileIndex = (y >> TileShift) * m_TilesX + (x >> TileShift);
+		return (tileIndex << (2 * TileShift)) + ((y & (TileSize - 1)) << TileShift) + (x & (TileSize - 1));
+	}
+
+	int GetWidth() const { return m_Width; };
+	int GetHeight() const { return m_Height; };
+	// Including the padding of the edge tiles
+	int GetPixelCount() const { return m_TilesX * m_TilesY * TilePixelCount; };
+
+	// Inclusive pixel rect, filled one contiguous tile row segment at a time
+	template<typename T>
+	void FillRect(T* pBuffer, int minX, int minY, int maxX, int maxY, T value) const
+	{
+		for (int y{ minY }; y <= maxY; ++y)
+		{
+			for (int x{ minX }; x <= maxX;)
+			{
+				const int segmentEnd = std::min((x | (TileSize - 1)) + 1, maxX + 1);
+				std::fill_n(pBuffer + GetIndex(x, y), segmentEnd - x, value);
+				x = segmentEnd;
+			}
+		}
+	}
+
+	// Copies a tiled 32 bit color buffer into a row-major surface of the same size
+	void Linearize(const uint32_t* pTiled, SDL_Surface* pTarget) const;
+	// Same for the inclusive pixel rect only, minX has to start a tile
+	void LinearizeRect(const uint32_t* pTiled, SDL_Surface* pTarget, int minX, int minY, int maxX, int maxY) const;
+
+private:
+	int m_Width{};
+	int m_Height{};
+	int m_TilesX{};
+	int m_TilesY{};
+};
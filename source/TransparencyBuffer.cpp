@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "TransparencyBuffer.h"
+
+namespace
+{
+	// Depth weight of equation 9 in the paper, fragments closer to the camera count more
+	inline float GetDepthWeight(float alpha, float viewDepth)
+	{
+		const float scaledDepth = viewDepth / 5.f;
+		const float farDepth = viewDepth / 200.f;
+		const float farDepth3 = farDepth * farDepth * farDepth;
+		const float weight = 10.f / (1e-5f + scaledDepth * scaledDepth + farDepth3 * farDepth3);
+
+		return alpha * std::clamp(weight, 1e-2f, 3e3f);
+	}
+}
+
+TransparencyBuffer::TransparencyBuffer(int width, int height)
+	: m_Layout{ width, height }
+{
+	const int pixelCount = m_Layout.GetPixelCount();
+
+	m_AccumulationRed.resize(pixelCount);
+	m_AccumulationGreen.resize(pixelCount);
+	m_AccumulationBlue.resize(pixelCount);
+	m_AccumulationAlpha.resize(pixelCount);
+	m_Revealage.resize(pixelCount, 1.f);
+}
+
+void TransparencyBuffer::Clear(int minX, int minY, int maxX, int maxY)
+{
+	m_Layout.FillRect(m_AccumulationRed.data(), minX, minY, maxX, maxY, 0.f);
+	m_Layout.FillRect(m_AccumulationGreen.data(), minX, minY, maxX, maxY, 0.f);
+	m_Layout.FillRect(m_AccumulationBlue.data(), minX, minY, maxX, maxY, 0.f);
+	m_Layout.FillRect(m_AccumulationAlpha.data(), minX, minY, maxX, maxY, 0.f);
+	m_Layout.FillRect(m_Revealage.data(), minX, minY, maxX, maxY, 1.f);
+}
+
+void TransparencyBuffer::Accumulate(int pixelIndex, const ColorRGB& color, float alpha, float viewDepth)
+{
+	const float weight = GetDepthWeight(alpha, viewDepth);
+
+	m_AccumulationRed[pixelIndex] += color.r * weight;
+	m_AccumulationGreen[pixelIndex] += color.g * weight;
+	m_AccumulationBlue[pixelIndex] += color.b * weight;
+	m_AccumulationAlpha[pixelIndex] += weight;
+	m_Revealage[pixelIndex] *= 1.f - alpha;
+}
+
+bool TransparencyBuffer::Composite(int pixelIndex, ColorRGB& color) const
+{
+	const float revealage = m_Revealage[pixelIndex];
+	if (revealage >= 1.f)
+	{
+		return false;
+	}
+
+	// Weighted average of the transparent colors, covering (1 - revealage) of the pixel
+	const float inverseAlpha = 1.f / std::max(m_AccumulationAlpha[pixelIndex], 1e-5f);
+	const ColorRGB average{ m_AccumulationRed[pixelIndex] * inverseAlpha, m_AccumulationGreen[pixelIndex] * inverseAlpha, m_AccumulationBlue[pixelIndex] * inverseAlpha };
+
+	color = average * (1.f - revealage) + color * revealage;
+	return true;
+}
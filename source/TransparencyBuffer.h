@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include "ColorRGB.h"
+#include "TiledLayout.h"
+
+/**
+	* Weighted blended order-independent transparency (McGuire and Bavoil 2013).
+	* Transparent fragments get accumulated in any order into a premultiplied,
+	* depth weighted color sum and a revealage product, and one composite pass
+	* blends that average over the opaque color. Uses the TiledLayout of the
+	* render size, callers make sure no two threads write the same pixel.
+	*/
+class TransparencyBuffer
+{
+public:
+	TransparencyBuffer(int width, int height);
+
+	// Inclusive pixel rect
+	void Clear(int minX, int minY, int maxX, int maxY);
+
+	// viewDepth is the linear view space depth of the fragment
+	void Accumulate(int pixelIndex, const ColorRGB& color, float alpha, float viewDepth);
+
+	// Blends the transparent average over the opaque color, false if nothing transparent covers the pixel
+	bool Composite(int pixelIndex, ColorRGB& color) const;
+
+private:
+	TiledLayout m_Layout{};
+
+	// Sum of premultiplied color * weight and of alpha * weight
+	std::vector<float> m_AccumulationRed{};
+	std::vector<float> m_AccumulationGreen{};
+	std::vector<float> m_AccumulationBlue{};
+	std::vector<float> m_AccumulationAlpha{};
+
+	// Product of (1 - alpha), the part of the opaque color that stays visible
+	std::vector<float> m_Revealage{};
+};
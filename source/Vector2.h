@@ -1,43 +1,136 @@
 #pragma once
+#include <cassert>
+#include <cmath>
 
+	// Header-only like the rest of the math core, so every operator can inline into the per-pixel loops and fold at compile time
 	struct Vector2
 	{
 		float x{};
 		float y{};
 
-		Vector2() = default;
-		Vector2(float _x, float _y);
-		Vector2(const Vector2& from, const Vector2& to);
-
-		float Magnitude() const;
-		float SqrMagnitude() const;
-		float Normalize();
-		Vector2 Normalized() const;
-
-		static float Dot(const Vector2& v1, const Vector2& v2);
-		static float Cross(const Vector2& v1, const Vector2& v2);
-
-		//Member Operators
-		Vector2 operator*(float scale) const;
-		Vector2 operator/(float scale) const;
-		Vector2 operator+(const Vector2& v) const;
-		Vector2 operator-(const Vector2& v) const;
-		Vector2 operator-() const;
-		//Vector2& operator-();
-		Vector2& operator+=(const Vector2& v);
-		Vector2& operator-=(const Vector2& v);
-		Vector2& operator/=(float scale);
-		Vector2& operator*=(float scale);
-		float& operator[](int index);
-		float operator[](int index) const;
+		constexpr Vector2() noexcept = default;
+		constexpr Vector2(float _x, float _y) noexcept : x(_x), y(_y) {}
+		constexpr Vector2(const Vector2& from, const Vector2& to) noexcept : x(to.x - from.x), y(to.y - from.y) {}
+
+		float Magnitude() const noexcept
+		{
+			return sqrtf(x * x + y * y);
+		}
+
+		constexpr float SqrMagnitude() const noexcept
+		{
+			return x * x + y * y;
+		}
+
+		float Normalize() noexcept
+		{
+			const float m = Magnitude();
+			x /= m;
+			y /= m;
+
+			return m;
+		}
+
+		Vector2 Normalized() const noexcept
+		{
+			const float m = Magnitude();
+			return { x / m, y / m };
+		}
+
+		static constexpr float Dot(const Vector2& v1, const Vector2& v2) noexcept
+		{
+			return v1.x * v2.x + v1.y * v2.y;
+		}
+
+		static constexpr float Cross(const Vector2& v1, const Vector2& v2) noexcept
+		{
+			return v1.x * v2.y - v1.y * v2.x;
+		}
+
+		// f1 * v1 + f2 * v2 + f3 * v3 per component, barycentric interpolation without intermediate vectors
+		static constexpr Vector2 Lico(float f1, const Vector2& v1, float f2, const Vector2& v2, float f3, const Vector2& v3) noexcept
+		{
+			return { f1 * v1.x + f2 * v2.x + f3 * v3.x, f1 * v1.y + f2 * v2.y + f3 * v3.y };
+		}
+
+#pragma region Operator Overloads
+		constexpr Vector2 operator*(float scale) const noexcept
+		{
+			return { x * scale, y * scale };
+		}
+
+		constexpr Vector2 operator/(float scale) const noexcept
+		{
+			return { x / scale, y / scale };
+		}
+
+		constexpr Vector2 operator+(const Vector2& v) const noexcept
+		{
+			return { x + v.x, y + v.y };
+		}
+
+		constexpr Vector2 operator-(const Vector2& v) const noexcept
+		{
+			return { x - v.x, y - v.y };
+		}
+
+		constexpr Vector2 operator-() const noexcept
+		{
+			return { -x ,-y };
+		}
+
+		constexpr Vector2& operator*=(float scale) noexcept
+		{
+			x *= scale;
+			y *= scale;
+			return *this;
+		}
+
+		constexpr Vector2& operator/=(float scale) noexcept
+		{
+			x /= scale;
+			y /= scale;
+			return *this;
+		}
+
+		constexpr Vector2& operator-=(const Vector2& v) noexcept
+		{
+			x -= v.x;
+			y -= v.y;
+			return *this;
+		}
+
+		constexpr Vector2& operator+=(const Vector2& v) noexcept
+		{
+			x += v.x;
+			y += v.y;
+			return *this;
+		}
+
+		constexpr float& operator[](int index) noexcept
+		{
+			assert(index <= 1 && index >= 0);
+			return index == 0 ? x : y;
+		}
+
+		constexpr float operator[](int index) const noexcept
+		{
+			assert(index <= 1 && index >= 0);
+			return index == 0 ? x : y;
+		}
+#pragma endregion
 
 		static const Vector2 UnitX;
 		static const Vector2 UnitY;
 		static const Vector2 Zero;
 	};
 
+	inline constexpr Vector2 Vector2::UnitX{ 1, 0 };
+	inline constexpr Vector2 Vector2::UnitY{ 0, 1 };
+	inline constexpr Vector2 Vector2::Zero{ 0, 0 };
+
 	//Global Operators
-	inline Vector2 operator*(float scale, const Vector2& v)
+	constexpr Vector2 operator*(float scale, const Vector2& v) noexcept
 	{
 		return { v.x * scale, v.y * scale };
 	}
@@ -1,7 +1,8 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include "Vector2.h"
 
-
-	struct Vector2;
 	struct Vector4;
 	struct Vector3
 	{
@@ -9,41 +10,161 @@
 		float y{};
 		float z{};
 
-		Vector3() = default;
-		Vector3(float _x, float _y, float _z);
-		Vector3(const Vector3& from, const Vector3& to);
-		Vector3(const Vector4& v);
-
-		float Magnitude() const;
-		float SqrMagnitude() const;
-		float Normalize();
-		Vector3 Normalized() const;
-
-		static float Dot(const Vector3& v1, const Vector3& v2);
-		static Vector3 Cross(const Vector3& v1, const Vector3& v2);
-		static Vector3 Project(const Vector3& v1, const Vector3& v2);
-		static Vector3 Reject(const Vector3& v1, const Vector3& v2);
-		static Vector3 Reflect(const Vector3& v1, const Vector3& v2);
-		static Vector3 Lico(float f1, const Vector3& v1, float f2, const Vector3& v2, float f3, const Vector3& v3);
-
-		Vector4 ToPoint4() const;
-		Vector4 ToVector4() const;
-
-		Vector2 GetXY() const;
-
-		//Member Operators
-		Vector3 operator*(float scale) const;
-		Vector3 operator/(float scale) const;
-		Vector3 operator+(const Vector3& v) const;
-		Vector3 operator-(const Vector3& v) const;
-		Vector3 operator-() const;
-		//Vector3& operator-();
-		Vector3& operator+=(const Vector3& v);
-		Vector3& operator-=(const Vector3& v);
-		Vector3& operator/=(float scale);
-		Vector3& operator*=(float scale);
-		float& operator[](int index);
-		float operator[](int index) const;
+		constexpr Vector3() noexcept = default;
+		constexpr Vector3(float _x, float _y, float _z) noexcept : x(_x), y(_y), z(_z) {}
+		constexpr Vector3(const Vector3& from, const Vector3& to) noexcept : x(to.x - from.x), y(to.y - from.y), z(to.z - from.z) {}
+		// Defined in Vector4.h, together with the other conversions that need the complete Vector4
+		constexpr Vector3(const Vector4& v) noexcept;
+
+		float Magnitude() const noexcept
+		{
+			return sqrtf(x * x + y * y + z * z);
+		}
+
+		constexpr float SqrMagnitude() const noexcept
+		{
+			return x * x + y * y + z * z;
+		}
+
+		float Normalize() noexcept
+		{
+			const float m = Magnitude();
+			x /= m;
+			y /= m;
+			z /= m;
+
+			return m;
+		}
+
+		Vector3 Normalized() const noexcept
+		{
+			const float m = Magnitude();
+			return { x / m, y / m, z / m };
+		}
+
+		static constexpr float Dot(const Vector3& v1, const Vector3& v2) noexcept
+		{
+			return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+		}
+
+		static constexpr Vector3 Cross(const Vector3& v1, const Vector3& v2) noexcept
+		{
+			return Vector3{
+				v1.y * v2.z - v1.z * v2.y,
+				v1.z * v2.x - v1.x * v2.z,
+				v1.x * v2.y - v1.y * v2.x
+			};
+		}
+
+		static constexpr Vector3 Project(const Vector3& v1, const Vector3& v2) noexcept
+		{
+			return (v2 * (Dot(v1, v2) / Dot(v2, v2)));
+		}
+
+		static constexpr Vector3 Reject(const Vector3& v1, const Vector3& v2) noexcept
+		{
+			return (v1 - v2 * (Dot(v1, v2) / Dot(v2, v2)));
+		}
+
+		static constexpr Vector3 Reflect(const Vector3& v1, const Vector3& v2) noexcept
+		{
+			return v1 - v2 * (2.f * Vector3::Dot(v1, v2));
+		}
+
+		// f1 * v1 + f2 * v2 + f3 * v3 per component, barycentric interpolation without intermediate vectors
+		static constexpr Vector3 Lico(float f1, const Vector3& v1, float f2, const Vector3& v2, float f3, const Vector3& v3) noexcept
+		{
+			return {
+				f1 * v1.x + f2 * v2.x + f3 * v3.x,
+				f1 * v1.y + f2 * v2.y + f3 * v3.y,
+				f1 * v1.z + f2 * v2.z + f3 * v3.z
+			};
+		}
+
+		constexpr Vector4 ToPoint4() const noexcept;
+		constexpr Vector4 ToVector4() const noexcept;
+
+		constexpr Vector2 GetXY() const noexcept
+		{
+			return { x, y };
+		}
+
+#pragma region Operator Overloads
+		constexpr Vector3 operator*(float scale) const noexcept
+		{
+			return { x * scale, y * scale, z * scale };
+		}
+
+		constexpr Vector3 operator/(float scale) const noexcept
+		{
+			return { x / scale, y / scale, z / scale };
+		}
+
+		constexpr Vector3 operator+(const Vector3& v) const noexcept
+		{
+			return { x + v.x, y + v.y, z + v.z };
+		}
+
+		constexpr Vector3 operator-(const Vector3& v) const noexcept
+		{
+			return { x - v.x, y - v.y, z - v.z };
+		}
+
+		constexpr Vector3 operator-() const noexcept
+		{
+			return { -x ,-y,-z };
+		}
+
+		constexpr Vector3& operator*=(float scale) noexcept
+		{
+			x *= scale;
+			y *= scale;
+			z *= scale;
+			return *this;
+		}
+
+		constexpr Vector3& operator/=(float scale) noexcept
+		{
+			x /= scale;
+			y /= scale;
+			z /= scale;
+			return *this;
+		}
+
+		constexpr Vector3& operator-=(const Vector3& v) noexcept
+		{
+			x -= v.x;
+			y -= v.y;
+			z -= v.z;
+			return *this;
+		}
+
+		constexpr Vector3& operator+=(const Vector3& v) noexcept
+		{
+			x += v.x;
+			y += v.y;
+			z += v.z;
+			return *this;
+		}
+
+		constexpr float& operator[](int index) noexcept
+		{
+			assert(index <= 2 && index >= 0);
+
+			if (index == 0) return x;
+			if (index == 1) return y;
+			return z;
+		}
+
+		constexpr float operator[](int index) const noexcept
+		{
+			assert(index <= 2 && index >= 0);
+
+			if (index == 0) return x;
+			if (index == 1) return y;
+			return z;
+		}
+#pragma endregion
 
 		static const Vector3 UnitX;
 		static const Vector3 UnitY;
@@ -51,9 +172,16 @@
 		static const Vector3 Zero;
 	};
 
+	inline constexpr Vector3 Vector3::UnitX{ 1, 0, 0 };
+	inline constexpr Vector3 Vector3::UnitY{ 0, 1, 0 };
+	inline constexpr Vector3 Vector3::UnitZ{ 0, 0, 1 };
+	inline constexpr Vector3 Vector3::Zero{ 0, 0, 0 };
+
 	//Global Operators
-	inline Vector3 operator*(float scale, const Vector3& v)
+	constexpr Vector3 operator*(float scale, const Vector3& v) noexcept
 	{
 		return { v.x * scale, v.y * scale, v.z * scale };
 	}
 
+// The Vector4 conversions above need the complete type
+#include "Vector4.h"
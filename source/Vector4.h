@@ -1,7 +1,11 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include "MathHelpers.h"
+#include "Vector2.h"
+#include "Vector3.h"
 
-	struct Vector2;
-	struct Vector3;
 	struct Vector4
 	{
 		float x;
@@ -10,25 +14,154 @@
 		float w;
 
 		Vector4() = default;
-		Vector4(float _x, float _y, float _z, float _w);
-		Vector4(const Vector3& v, float _w);
-
-		float Magnitude() const;
-		float SqrMagnitude() const;
-		float Normalize();
-		Vector4 Normalized() const;
-
-		Vector2 GetXY() const;
-		Vector3 GetXYZ() const;
-
-		static float Dot(const Vector4& v1, const Vector4& v2);
-
-		// operator overloading
-		Vector4 operator*(float scale) const;
-		Vector4 operator+(const Vector4& v) const;
-		Vector4 operator-(const Vector4& v) const;
-		Vector4& operator+=(const Vector4& v);
-		float& operator[](int index);
-		float operator[](int index) const;
+		constexpr Vector4(float _x, float _y, float _z, float _w) noexcept : x(_x), y(_y), z(_z), w(_w) {}
+		constexpr Vector4(const Vector3& v, float _w) noexcept : x(v.x), y(v.y), z(v.z), w(_w) {}
+
+		float Magnitude() const noexcept
+		{
+			return sqrtf(x * x + y * y + z * z + w * w);
+		}
+
+		constexpr float SqrMagnitude() const noexcept
+		{
+			return x * x + y * y + z * z + w * w;
+		}
+
+		float Normalize() noexcept
+		{
+			const float m = Magnitude();
+			x /= m;
+			y /= m;
+			z /= m;
+			w /= m;
+
+			return m;
+		}
+
+		Vector4 Normalized() const noexcept
+		{
+			const float m = Magnitude();
+			return { x / m, y / m, z / m, w / m };
+		}
+
+		constexpr Vector2 GetXY() const noexcept
+		{
+			return { x, y };
+		}
+
+		constexpr Vector3 GetXYZ() const noexcept
+		{
+			return { x, y, z };
+		}
+
+		static constexpr float Dot(const Vector4& v1, const Vector4& v2) noexcept
+		{
+			return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+		}
+
+		// f1 * v1 + f2 * v2 + f3 * v3 per component, barycentric interpolation without intermediate vectors
+		static constexpr Vector4 Lico(float f1, const Vector4& v1, float f2, const Vector4& v2, float f3, const Vector4& v3) noexcept
+		{
+			return {
+				f1 * v1.x + f2 * v2.x + f3 * v3.x,
+				f1 * v1.y + f2 * v2.y + f3 * v3.y,
+				f1 * v1.z + f2 * v2.z + f3 * v3.z,
+				f1 * v1.w + f2 * v2.w + f3 * v3.w
+			};
+		}
+
+#pragma region Operator Overloads
+		// The SSE paths only run outside of constant evaluation, every lane computes the same as the scalar code
+		constexpr Vector4 operator*(float scale) const noexcept
+		{
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				Vector4 result;
+				_mm_storeu_ps(&result.x, _mm_mul_ps(_mm_loadu_ps(&x), _mm_set1_ps(scale)));
+				return result;
+			}
+#endif
+			return { x * scale, y * scale, z * scale, w * scale };
+		}
+
+		constexpr Vector4 operator+(const Vector4& v) const noexcept
+		{
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				Vector4 result;
+				_mm_storeu_ps(&result.x, _mm_add_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&v.x)));
+				return result;
+			}
+#endif
+			return { x + v.x, y + v.y, z + v.z, w + v.w };
+		}
+
+		constexpr Vector4 operator-(const Vector4& v) const noexcept
+		{
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				Vector4 result;
+				_mm_storeu_ps(&result.x, _mm_sub_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&v.x)));
+				return result;
+			}
+#endif
+			return { x - v.x, y - v.y, z - v.z, w - v.w };
+		}
+
+		constexpr Vector4& operator+=(const Vector4& v) noexcept
+		{
+#if defined(MATH_SSE)
+			if (!std::is_constant_evaluated())
+			{
+				_mm_storeu_ps(&x, _mm_add_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&v.x)));
+				return *this;
+			}
+#endif
+			x += v.x;
+			y += v.y;
+			z += v.z;
+			w += v.w;
+			return *this;
+		}
+
+		constexpr float& operator[](int index) noexcept
+		{
+			assert(index <= 3 && index >= 0);
+
+			if (index == 0)return x;
+			if (index == 1)return y;
+			if (index == 2)return z;
+			return w;
+		}
+
+		constexpr float operator[](int index) const noexcept
+		{
+			assert(index <= 3 && index >= 0);
+
+			if (index == 0)return x;
+			if (index == 1)return y;
+			if (index == 2)return z;
+			return w;
+		}
+#pragma endregion
 	};
 
+	// The SSE paths load x, y, z and w as one vector
+	static_assert(sizeof(Vector4) == 4 * sizeof(float));
+
+#pragma region Vector3 Conversions
+	constexpr Vector3::Vector3(const Vector4& v) noexcept : x(v.x), y(v.y), z(v.z) {}
+
+	constexpr Vector4 Vector3::ToPoint4() const noexcept
+	{
+		return { x, y, z, 1 };
+	}
+
+	constexpr Vector4 Vector3::ToVector4() const noexcept
+	{
+		return { x, y, z, 0 };
+	}
+#pragma endregion
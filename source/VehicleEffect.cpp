@@ -1,9 +1,19 @@
 #include "pch.h"
 #include "VehicleEffect.h"
 
-VehicleEffect::VehicleEffect(ID3D11Device* pDevice, const std::wstring& assetFile)
+VehicleEffect::VehicleEffect(ID3D11Device* pDevice, const std::wstring& assetFile, bool isNormalMapObjectSpace)
 	: BaseEffect(pDevice, assetFile)
+	, m_IsNormalMapObjectSpace{ isNormalMapObjectSpace }
 {
+	if (m_IsNormalMapObjectSpace)
+	{
+		m_pEffectTechnique = m_pEffect->GetTechniqueByName("ObjectSpaceNormalTechnique");
+		if (!m_pEffectTechnique->IsValid())
+		{
+			std::wcout << L"ObjectSpaceNormalTechnique not valid" << std::endl;
+		}
+	}
+
 	CreateLayout(pDevice);
 
 	m_pNormalMapVariable = m_pEffect->GetVariableByName("gNormalMap")->AsShaderResource();
@@ -80,13 +90,21 @@ void VehicleEffect::CreateLayout(ID3D11Device* pDevice)
 	vertexDesc[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
-	// Tangent coordinates
-	vertexDesc[3].SemanticName = "TANGENT";
-	vertexDesc[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	// Tangent coordinates, or the normal map coordinates of Vertex_Baked
+	if (m_IsNormalMapObjectSpace)
+	{
+		vertexDesc[3].SemanticName = "TEXCOORD";
+		vertexDesc[3].SemanticIndex = 1;
+		vertexDesc[3].Format = DXGI_FORMAT_R32G32_FLOAT;
+	}
+	else
+	{
+		vertexDesc[3].SemanticName = "TANGENT";
+		vertexDesc[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	}
 	vertexDesc[3].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
-	
 
 	// Create input layout
 	D3DX11_PASS_DESC passDesc{};
@@ -5,7 +5,8 @@
 class VehicleEffect : public BaseEffect
 {
 public:
-	VehicleEffect(ID3D11Device* pDevice, const std::wstring& assetFile);
+	// Meshes with a baked object space normal map (MeshData::isNormalMapObjectSpace) use Vertex_Baked and their own technique
+	VehicleEffect(ID3D11Device* pDevice, const std::wstring& assetFile, bool isNormalMapObjectSpace = false);
 	~VehicleEffect();
 
 	virtual void SetNormalMap(Texture* pNormalMap) override;
@@ -16,6 +17,8 @@ protected:
 	virtual void CreateLayout(ID3D11Device* pDevice) override;
 
 private:
+	bool m_IsNormalMapObjectSpace{};
+
 	ID3DX11EffectShaderResourceVariable* m_pNormalMapVariable{};
 	ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable{};
 	ID3DX11EffectShaderResourceVariable* m_pGlossinessMapVariable{};
@@ -4,9 +4,13 @@
 #include <SDL_vulkan.h>
 #include "RenderConfig.h"
 
-VulkanRenderer::VulkanRenderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes)
+VulkanRenderer::VulkanRenderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes, const IrradianceSH& skyIrradiance)
 	:BaseRenderer(pWindow, pCamera)
 {
+	// Same lighting as the combined mode of the CPU renderer, without the specular
+	m_UboViewProjection.lightDirection = Vector4{ .577f, -.577f, .577f, 7.f };
+	m_UboViewProjection.skyIrradiance = skyIrradiance;
+
 	Init(pMeshes);
 
 	m_RendererColor = { 0.8f, 0.1f, 0.2f };
@@ -573,7 +577,7 @@ void VulkanRenderer::CreateDescriptorSetLayout()
 	vpLayoutBinding.binding = 0;											// Where to bind in shader (layout(binding = 0))
 	vpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;		// Type of descriptor (uniform, dynamic uniform, image sampler etc...)
 	vpLayoutBinding.descriptorCount = 1;									// Number of descriptors for binding
-	vpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;				// Shader stage to bind to
+	vpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;	// Shader stage to bind to, the fragment stage reads the lighting
 	vpLayoutBinding.pImmutableSamplers = nullptr;							// For textures: can make sampler immutable
 
 	//VkDescriptorSetLayoutBinding modelLayoutBinding{};
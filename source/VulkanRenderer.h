@@ -4,6 +4,7 @@
 #include "VulkanMesh.h"
 #include <vulkan/vulkan.h>
 #include "Utils.h"
+#include "SphericalHarmonics.h"
 
 #define MAX_FRAME_DRAWS 3
 #define MAX_OBJECTS 20
@@ -11,7 +12,7 @@
 class VulkanRenderer : public BaseRenderer
 {
 public:
-	VulkanRenderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes);
+	VulkanRenderer(SDL_Window* pWindow, Camera* pCamera, std::vector<MeshData*> pMeshes, const IrradianceSH& skyIrradiance);
 	virtual ~VulkanRenderer() override;
 
 	virtual void Update(Timer* pTimer) override;
@@ -27,9 +28,13 @@ private:
 	uint32_t m_CurrentFrame{};
 
 	// Scene settings
+	// std140, the fragment shader reads the lighting
 	struct UboViewProjection {
 		Matrix projection;
 		Matrix view;
+		// xyz the direction of the directional light, w its intensity
+		Vector4 lightDirection;
+		IrradianceSH skyIrradiance;
 	} m_UboViewProjection;
 
 	// Vulkan components
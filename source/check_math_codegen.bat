@@ -0,0 +1,7 @@
+REM Compiles the per pixel math loops of MathCodegen.cpp with the Release optimizations and lists the calls left in them.
+REM Run from a Developer Command Prompt in this folder. The errno fallback of sqrtf is the one call allowed, it only runs for negative input
+cl /nologo /c /O2 /std:c++20 /permissive- /sdl /FA /FaMathCodegen.asm /Fo%TEMP%\MathCodegen.obj MathCodegen.cpp || goto end
+findstr /R /I "\<call\>" MathCodegen.asm | findstr /V /I "sqrt" && (echo FAILED: calls left in the math loops) || (echo OK: no calls left in the math loops)
+
+:end
+pause
@@ -7,6 +7,13 @@
 #undef main
 #include "Renderer.h"
 #include "RenderConfig.h"
+#include "ActivityMonitor.h"
+#include "JobSystem.h"
+#include "SimdDispatch.h"
+#include "MathBenchmark.h"
+
+// Longest idle wait of on-demand rendering, so the stats keep getting reported
+constexpr uint32_t IdleTimeoutMs{ 500 };
 
 void ShutDown(SDL_Window* pWindow)
 {
@@ -16,9 +23,42 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	// SIMD kernels of the software rasterizer, --simd=<scalar|sse2|avx2|avx512|neon> overrides the detected level
+	SIMD_LEVEL simdLevel = SimdDispatch::DetectLevel();
+	bool shouldValidateSimd = false;
+	bool shouldBenchmarkMath = false;
+	for (int index{ 1 }; index < argc; ++index)
+	{
+		const std::string argument{ args[index] };
+		if (argument.rfind("--simd=", 0) == 0)
+		{
+			if (!SimdDispatch::ParseLevel(argument.c_str() + 7, simdLevel))
+			{
+				std::cout << "\033[31m"; // TEXT COLOR
+				std::cout << "[SIMD] Unknown level " << argument.substr(7) << std::endl;
+				std::cout << "\033[37m"; // TEXT COLOR WHITE
+			}
+		}
+		else if (argument == "--simd-validate")
+		{
+			shouldValidateSimd = true;
+		}
+		else if (argument == "--bench-math")
+		{
+			shouldBenchmarkMath = true;
+		}
+	}
+
+	SimdDispatch::Select(simdLevel);
+	if (shouldValidateSimd)
+	{
+		SimdDispatch::Validate();
+	}
+
+	if (shouldBenchmarkMath)
+	{
+		MathBenchmark::Run();
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -44,8 +84,20 @@ int main(int argc, char* args[])
 	pTimer->Start();
 	float printTimer = 0.f;
 	bool isLooping = true;
+	ActivityMonitor activityMonitor{};
 	while (isLooping)
 	{
+		//--------- Idle ---------
+		// Sleep until an event arrives, the timer is paused so the idle time does not end up in the next frame
+		if (RENDER_CONFIG->ShouldRenderOnDemand() && !pRenderer->NeedsRender())
+		{
+			pTimer->Stop();
+			SDL_WaitEventTimeout(nullptr, IdleTimeoutMs);
+			pTimer->Start();
+
+			activityMonitor.AddWakeup();
+		}
+
 		//--------- Get input events ---------
 		SDL_Event e;
 		while (SDL_PollEvent(&e))
@@ -55,7 +107,16 @@ int main(int argc, char* args[])
 			case SDL_QUIT:
 				isLooping = false;
 				break;
+			case SDL_WINDOWEVENT:
+			case SDL_MOUSEMOTION:
+			case SDL_MOUSEBUTTONDOWN:
+			case SDL_MOUSEBUTTONUP:
+				pRenderer->MarkDirty();
+				break;
 			case SDL_KEYUP:
+				// Every key binding changes config or camera state
+				pRenderer->MarkDirty();
+
 				//Test for a key
 				if (e.key.keysym.scancode == SDL_SCANCODE_F1)
 				{
@@ -88,6 +149,11 @@ int main(int argc, char* args[])
 					RENDER_CONFIG->TogglePrintFPS();
 				}
 
+				if (e.key.keysym.scancode == SDL_SCANCODE_O)
+				{
+					RENDER_CONFIG->ToggleOnDemandRendering();
+				}
+
 				if (e.key.keysym.scancode == SDL_SCANCODE_F3)
 				{
 					RENDER_CONFIG->ToggleThruster();
@@ -118,6 +184,56 @@ int main(int argc, char* args[])
 					RENDER_CONFIG->ToggleBoundingBox();
 				}
 
+				if (e.key.keysym.scancode == SDL_SCANCODE_R)
+				{
+					RENDER_CONFIG->ToggleVariableRateShading();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_U)
+				{
+					RENDER_CONFIG->CycleRenderScale();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_H)
+				{
+					RENDER_CONFIG->ToggleHDR();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_Z)
+				{
+					RENDER_CONFIG->ToggleDepthPrepass();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_M)
+				{
+					RENDER_CONFIG->CycleShadowMapResolution();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_L)
+				{
+					RENDER_CONFIG->CyclePointLightCount();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_T)
+				{
+					RENDER_CONFIG->ToggleRayTracedShadows();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_K)
+				{
+					RENDER_CONFIG->CycleAmbientOcclusionSampleCount();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_P)
+				{
+					RENDER_CONFIG->CyclePipelineDepth();
+				}
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_Q)
+				{
+					RENDER_CONFIG->CycleMathQuality();
+				}
+
 				if (e.key.keysym.scancode == SDL_SCANCODE_V)
 				{
 					RENDER_CONFIG->ToggleVulkan();
@@ -126,6 +242,8 @@ int main(int argc, char* args[])
 				break;
 
 			case SDL_KEYDOWN:
+				pRenderer->MarkDirty();
+
 				if (e.key.keysym.scancode == SDL_SCANCODE_LSHIFT)
 				{
 					pRenderer->SetMoveSpeedFast();
@@ -139,7 +257,17 @@ int main(int argc, char* args[])
 		pRenderer->Update(pTimer);
 
 		//--------- Render ---------
-		pRenderer->Render();
+		if (!RENDER_CONFIG->ShouldRenderOnDemand() || pRenderer->NeedsRender())
+		{
+			pRenderer->Render();
+			activityMonitor.AddRenderedFrame();
+		}
+		else
+		{
+			activityMonitor.AddSkippedFrame();
+		}
+
+		activityMonitor.Update();
 
 		//--------- Timer ---------
 		pTimer->Update();
@@ -161,6 +289,7 @@ int main(int argc, char* args[])
 
 	// Destroy instance
 	RENDER_CONFIG->DestroyInstance();
+	JOB_SYSTEM->DestroyInstance();
 
 	ShutDown(pWindow);
 	return 0;